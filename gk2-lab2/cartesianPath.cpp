@@ -0,0 +1,150 @@
+#include "cartesianPath.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+LinePath::LinePath(XMFLOAT3 from, XMFLOAT3 to, XMFLOAT3 fromNormal, XMFLOAT3 toNormal)
+	: m_from(from), m_to(to)
+{
+	XMStoreFloat3(&m_fromNormal, XMVector3Normalize(XMLoadFloat3(&fromNormal)));
+	XMStoreFloat3(&m_toNormal, XMVector3Normalize(XMLoadFloat3(&toNormal)));
+}
+
+void LinePath::Evaluate(float t, XMFLOAT3& position, XMFLOAT3& normal) const
+{
+	XMStoreFloat3(&position, XMVectorLerp(XMLoadFloat3(&m_from), XMLoadFloat3(&m_to), t));
+	XMStoreFloat3(&normal, XMVector3Normalize(XMVectorLerp(XMLoadFloat3(&m_fromNormal), XMLoadFloat3(&m_toNormal), t)));
+}
+
+float LinePath::length() const
+{
+	return XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&m_to), XMLoadFloat3(&m_from))));
+}
+
+CirclePath::CirclePath(XMFLOAT3 center, XMFLOAT3 normal, float radius, float startAngle)
+	: m_center(center), m_radius(radius), m_startAngle(startAngle)
+{
+	auto n = XMVector3Normalize(XMLoadFloat3(&normal));
+	auto helper = fabsf(XMVectorGetX(n)) < 0.9f ? XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f) : XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+	auto u = XMVector3Normalize(XMVector3Cross(helper, n));
+	XMStoreFloat3(&m_normal, n);
+	XMStoreFloat3(&m_u, XMVectorScale(u, radius));
+	XMStoreFloat3(&m_v, XMVectorScale(XMVector3Cross(n, u), radius));
+}
+
+CirclePath CirclePath::OnPlane(const XMFLOAT4X4& planeMtx, XMFLOAT2 center, float radius, float startAngle)
+{
+	auto mtx = XMLoadFloat4x4(&planeMtx);
+	XMFLOAT3 c, n;
+	XMStoreFloat3(&c, XMVector3TransformCoord(XMVectorSet(center.x, center.y, 0.0f, 1.0f), mtx));
+	XMStoreFloat3(&n, XMVector3TransformNormal(XMVectorSet(0.0f, 0.0f, -1.0f, 0.0f), mtx));
+	CirclePath circle(c, n, radius, startAngle);
+	//start from the plane's local x axis, so startAngle is measured in the plane's coordinates
+	auto u = XMVector3Normalize(XMVector3TransformNormal(XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), mtx));
+	auto nv = XMLoadFloat3(&circle.m_normal);
+	XMStoreFloat3(&circle.m_u, XMVectorScale(u, radius));
+	XMStoreFloat3(&circle.m_v, XMVectorScale(XMVector3Cross(nv, u), radius));
+	return circle;
+}
+
+void CirclePath::Evaluate(float t, XMFLOAT3& position, XMFLOAT3& normal) const
+{
+	float s, c;
+	XMScalarSinCos(&s, &c, m_startAngle + XM_2PI * t);
+	auto p = XMVectorAdd(XMLoadFloat3(&m_center),
+		XMVectorAdd(XMVectorScale(XMLoadFloat3(&m_u), c), XMVectorScale(XMLoadFloat3(&m_v), s)));
+	XMStoreFloat3(&position, p);
+	normal = m_normal;
+}
+
+float CirclePath::length() const
+{
+	return XM_2PI * m_radius;
+}
+
+const float ArcPath::MIN_AREA = 1e-6f;
+
+ArcPath::ArcPath(XMFLOAT3 from, XMFLOAT3 via, XMFLOAT3 to, XMFLOAT3 fromNormal, XMFLOAT3 toNormal)
+{
+	assert(!Collinear(from, via, to));
+	auto a = XMLoadFloat3(&from);
+	auto ab = XMVectorSubtract(XMLoadFloat3(&via), a);
+	auto ac = XMVectorSubtract(XMLoadFloat3(&to), a);
+	//a, b, c go counterclockwise about n
+	auto n = XMVector3Cross(ab, ac);
+	auto toCenter = XMVectorDivide(XMVectorAdd(XMVectorMultiply(XMVector3LengthSq(ac), XMVector3Cross(n, ab)),
+		XMVectorMultiply(XMVector3LengthSq(ab), XMVector3Cross(ac, n))), XMVectorScale(XMVector3LengthSq(n), 2.0f));
+	auto axis = XMVector3Normalize(n);
+	auto start = XMVectorNegate(toCenter);
+	auto end = XMVectorSubtract(ac, toCenter);
+	m_sweep = atan2f(XMVectorGetX(XMVector3Dot(axis, XMVector3Cross(start, end))), XMVectorGetX(XMVector3Dot(start, end)));
+	if (m_sweep < 0.0f)
+		m_sweep += XM_2PI;
+	XMStoreFloat3(&m_center, XMVectorAdd(a, toCenter));
+	XMStoreFloat3(&m_axis, axis);
+	XMStoreFloat3(&m_start, start);
+	XMStoreFloat3(&m_fromNormal, XMVector3Normalize(XMLoadFloat3(&fromNormal)));
+	XMStoreFloat3(&m_toNormal, XMVector3Normalize(XMLoadFloat3(&toNormal)));
+}
+
+bool ArcPath::Collinear(XMFLOAT3 a, XMFLOAT3 b, XMFLOAT3 c)
+{
+	auto pa = XMLoadFloat3(&a);
+	auto n = XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&b), pa), XMVectorSubtract(XMLoadFloat3(&c), pa));
+	return XMVectorGetX(XMVector3Length(n)) < MIN_AREA;
+}
+
+void ArcPath::Evaluate(float t, XMFLOAT3& position, XMFLOAT3& normal) const
+{
+	float s, c;
+	XMScalarSinCos(&s, &c, m_sweep * t);
+	auto u = XMLoadFloat3(&m_start);
+	auto v = XMVector3Cross(XMLoadFloat3(&m_axis), u);
+	XMStoreFloat3(&position, XMVectorAdd(XMLoadFloat3(&m_center), XMVectorAdd(XMVectorScale(u, c), XMVectorScale(v, s))));
+	XMStoreFloat3(&normal, XMVector3Normalize(XMVectorLerp(XMLoadFloat3(&m_fromNormal), XMLoadFloat3(&m_toNormal), t)));
+}
+
+float ArcPath::length() const
+{
+	return m_sweep * XMVectorGetX(XMVector3Length(XMLoadFloat3(&m_start)));
+}
+
+SplinePath::SplinePath(vector<XMFLOAT3> points, vector<XMFLOAT3> normals)
+	: m_points(move(points)), m_normals(move(normals))
+{
+	assert(m_points.size() >= 2 && m_points.size() == m_normals.size());
+}
+
+void SplinePath::Evaluate(float t, XMFLOAT3& position, XMFLOAT3& normal) const
+{
+	auto segments = m_points.size() - 1;
+	auto s = min(max(t, 0.0f), 1.0f) * segments;
+	auto i = min(static_cast<size_t>(s), segments - 1);
+	auto local = s - i;
+	//end points are repeated to get tangents of the first and last segments
+	auto p0 = XMLoadFloat3(&m_points[i > 0 ? i - 1 : 0]);
+	auto p1 = XMLoadFloat3(&m_points[i]);
+	auto p2 = XMLoadFloat3(&m_points[i + 1]);
+	auto p3 = XMLoadFloat3(&m_points[min(i + 2, segments)]);
+	XMStoreFloat3(&position, XMVectorCatmullRom(p0, p1, p2, p3, local));
+	XMStoreFloat3(&normal, XMVector3Normalize(XMVectorLerp(XMLoadFloat3(&m_normals[i]), XMLoadFloat3(&m_normals[i + 1]), local)));
+}
+
+float SplinePath::length() const
+{
+	auto samples = LENGTH_SAMPLES_PER_SEGMENT * (m_points.size() - 1);
+	auto length = 0.0f;
+	XMFLOAT3 previous, current, normal;
+	Evaluate(0.0f, previous, normal);
+	for (size_t i = 1; i <= samples; ++i)
+	{
+		Evaluate(static_cast<float>(i) / samples, current, normal);
+		length += XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&current), XMLoadFloat3(&previous))));
+		previous = current;
+	}
+	return length;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Path of the robot's tool tip parametrized by t from [0,1], together with the normal
+		//of the surface being touched, i.e. reversed tool direction (see PumaKinematics)
+		class CartesianPath
+		{
+		public:
+			virtual ~CartesianPath() = default;
+
+			virtual void Evaluate(float t, DirectX::XMFLOAT3& position, DirectX::XMFLOAT3& normal) const = 0;
+			virtual float length() const = 0;
+		};
+
+		class LinePath : public CartesianPath
+		{
+		public:
+			LinePath(DirectX::XMFLOAT3 from, DirectX::XMFLOAT3 to, DirectX::XMFLOAT3 normal)
+				: LinePath(from, to, normal, normal) { }
+			//Normal turns from fromNormal to toNormal along the way; they must not be opposite
+			LinePath(DirectX::XMFLOAT3 from, DirectX::XMFLOAT3 to, DirectX::XMFLOAT3 fromNormal, DirectX::XMFLOAT3 toNormal);
+
+			void Evaluate(float t, DirectX::XMFLOAT3& position, DirectX::XMFLOAT3& normal) const override;
+			float length() const override;
+
+		private:
+			DirectX::XMFLOAT3 m_from, m_to, m_fromNormal, m_toNormal;
+		};
+
+		//Circle in a plane, traversed counterclockwise when looking against the normal
+		class CirclePath : public CartesianPath
+		{
+		public:
+			CirclePath(DirectX::XMFLOAT3 center, DirectX::XMFLOAT3 normal, float radius, float startAngle = 0.0f);
+			//Circle around point (x, y) in the local XY plane of a rectangle mesh with normal (0,0,-1),
+			//e.g. the desk drawn with m_deskMtx
+			static CirclePath OnPlane(const DirectX::XMFLOAT4X4& planeMtx, DirectX::XMFLOAT2 center, float radius, float startAngle = 0.0f);
+
+			void Evaluate(float t, DirectX::XMFLOAT3& position, DirectX::XMFLOAT3& normal) const override;
+			float length() const override;
+
+		private:
+			DirectX::XMFLOAT3 m_center, m_normal;
+			DirectX::XMFLOAT3 m_u, m_v;	//in-plane axes scaled by radius
+			float m_radius;
+			float m_startAngle;
+		};
+
+		//Arc of the circle through three points, from the first one through the second to the third
+		class ArcPath : public CartesianPath
+		{
+		public:
+			//Points must not be collinear (see Collinear); the normal turns like in LinePath
+			ArcPath(DirectX::XMFLOAT3 from, DirectX::XMFLOAT3 via, DirectX::XMFLOAT3 to, DirectX::XMFLOAT3 fromNormal,
+				DirectX::XMFLOAT3 toNormal);
+
+			static bool Collinear(DirectX::XMFLOAT3 a, DirectX::XMFLOAT3 b, DirectX::XMFLOAT3 c);
+
+			void Evaluate(float t, DirectX::XMFLOAT3& position, DirectX::XMFLOAT3& normal) const override;
+			float length() const override;
+
+		private:
+			static const float MIN_AREA;	//twice the area of the smallest triangle of points not considered collinear
+
+			DirectX::XMFLOAT3 m_center, m_axis, m_start;	//m_start from the center to the first point
+			float m_sweep;	//angle about m_axis from the first to the last point
+			DirectX::XMFLOAT3 m_fromNormal, m_toNormal;
+		};
+
+		//Catmull-Rom spline through control points; normals are interpolated between control points
+		class SplinePath : public CartesianPath
+		{
+		public:
+			SplinePath(std::vector<DirectX::XMFLOAT3> points, std::vector<DirectX::XMFLOAT3> normals);
+
+			void Evaluate(float t, DirectX::XMFLOAT3& position, DirectX::XMFLOAT3& normal) const override;
+			float length() const override;
+
+		private:
+			static const int LENGTH_SAMPLES_PER_SEGMENT = 16;
+
+			std::vector<DirectX::XMFLOAT3> m_points, m_normals;
+		};
+	}
+}
@@ -0,0 +1,182 @@
+#pragma once
+#include <DirectXMath.h>
+#include <array>
+#include <cassert>
+#include "kinematicChain.h"
+#include "parallel.h"
+#include "rigidBody.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Rigid-body dynamics of a KinematicChain with DOF joints and a fixed base.
+		//Inverse dynamics (torques for given accelerations) uses the recursive Newton-Euler algorithm and forward
+		//dynamics (accelerations for given torques) the articulated-body algorithm, both O(DOF). All spatial
+		//quantities are expressed in world coordinates, where joint axes and link inertias come straight from
+		//the link matrices, so no transforms between link frames are needed. Solves don't allocate.
+		template<size_t DOF>
+		class ChainDynamics
+		{
+		public:
+			using Vector = std::array<float, DOF>;
+
+			//links - inertia of the link moved by every joint, in the world space of the rest pose
+			ChainDynamics(KinematicChain chain, const std::array<RigidBodyInertia, DOF>& links,
+				DirectX::XMFLOAT3 gravity = { 0.0f, -9.81f, 0.0f })
+				: m_chain(std::move(chain)), m_links(links), m_gravity(gravity)
+			{
+				assert(m_chain.jointsCount() == DOF);
+			}
+
+			void SetLinkInertia(size_t joint, const RigidBodyInertia& link) { m_links[joint] = link; }
+			void SetGravity(DirectX::XMFLOAT3 gravity) { m_gravity = gravity; }
+
+			//Joint torques producing accelerations qdd at angles q and velocities qd
+			void InverseDynamics(const Vector& q, const Vector& qd, const Vector& qdd, Vector& tau) const;
+			//Joint accelerations produced by torques tau at angles q and velocities qd
+			void ForwardDynamics(const Vector& q, const Vector& qd, const Vector& tau, Vector& qdd) const;
+			//Advances q and qd by dt with torques tau held constant (semi-implicit Euler)
+			void Step(Vector& q, Vector& qd, const Vector& tau, float dt) const;
+
+			//count independent states split between threads
+			void InverseDynamicsBatch(size_t count, const Vector* q, const Vector* qd, const Vector* qdd, Vector* tau) const;
+			void ForwardDynamicsBatch(size_t count, const Vector* q, const Vector* qd, const Vector* tau, Vector* qdd) const;
+
+			const KinematicChain& chain() const { return m_chain; }
+			const RigidBodyInertia& linkInertia(size_t joint) const { return m_links[joint]; }
+
+		private:
+			KinematicChain m_chain;
+			std::array<RigidBodyInertia, DOF> m_links;
+			DirectX::XMFLOAT3 m_gravity;
+
+			//Motion subspaces of the joints and link inertias at angles q
+			void Pose(const Vector& q, std::array<SpatialVector, DOF>& axes, std::array<RigidBodyInertia, DOF>& links) const;
+			//Acceleration of the fixed base, which stands in for gravity
+			SpatialVector BaseAcceleration() const
+			{
+				return { { 0.0f, 0.0f, 0.0f, -m_gravity.x, -m_gravity.y, -m_gravity.z } };
+			}
+		};
+
+		template<size_t DOF>
+		void ChainDynamics<DOF>::Pose(const Vector& q, std::array<SpatialVector, DOF>& axes,
+			std::array<RigidBodyInertia, DOF>& links) const
+		{
+			using namespace DirectX;
+			std::array<XMFLOAT4X4, DOF> mtx;
+			m_chain.ForwardKinematics(1, q.data(), mtx.data());
+			for (size_t j = 0; j < DOF; ++j)
+			{
+				auto link = XMLoadFloat4x4(&mtx[j]);
+				auto axis = XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&m_chain.joint(j).Axis), link));
+				auto pivot = XMVector3TransformCoord(XMLoadFloat3(&m_chain.joint(j).Pivot), link);
+				//turning about the axis moves the point at the origin with pivot x axis
+				axes[j] = SpatialVector::Make(axis, XMVector3Cross(pivot, axis));
+				links[j] = m_links[j].Transformed(mtx[j]);
+			}
+		}
+
+		template<size_t DOF>
+		void ChainDynamics<DOF>::InverseDynamics(const Vector& q, const Vector& qd, const Vector& qdd, Vector& tau) const
+		{
+			std::array<SpatialVector, DOF> axes, forces;
+			std::array<RigidBodyInertia, DOF> links;
+			Pose(q, axes, links);
+			std::array<SpatialVector, DOF> v, a;
+			for (size_t j = 0; j < DOF; ++j)
+			{
+				auto parent = m_chain.joint(j).Parent;
+				auto vj = axes[j] * qd[j];
+				v[j] = parent < 0 ? vj : v[parent] + vj;
+				a[j] = (parent < 0 ? BaseAcceleration() : a[parent]) + axes[j] * qdd[j] + v[j].CrossMotion(vj);
+				forces[j] = links[j].Momentum(a[j]) + v[j].CrossForce(links[j].Momentum(v[j]));
+			}
+			//children pass their forces on to parents
+			for (auto j = DOF; j-- > 0;)
+			{
+				tau[j] = axes[j].Dot(forces[j]);
+				auto parent = m_chain.joint(j).Parent;
+				if (parent >= 0)
+					forces[parent] += forces[j];
+			}
+		}
+
+		template<size_t DOF>
+		void ChainDynamics<DOF>::ForwardDynamics(const Vector& q, const Vector& qd, const Vector& tau, Vector& qdd) const
+		{
+			std::array<SpatialVector, DOF> axes;
+			std::array<RigidBodyInertia, DOF> links;
+			Pose(q, axes, links);
+			std::array<SpatialVector, DOF> v, c, bias, u;
+			std::array<SpatialMatrix, DOF> inertia;
+			std::array<float, DOF> d, torque;
+			for (size_t j = 0; j < DOF; ++j)
+			{
+				auto parent = m_chain.joint(j).Parent;
+				auto vj = axes[j] * qd[j];
+				v[j] = parent < 0 ? vj : v[parent] + vj;
+				c[j] = v[j].CrossMotion(vj);
+				inertia[j] = links[j].Spatial();
+				bias[j] = v[j].CrossForce(links[j].Momentum(v[j]));
+			}
+			//articulated inertias of the subtrees, from the leaves towards the base
+			for (auto j = DOF; j-- > 0;)
+			{
+				u[j] = inertia[j] * axes[j];
+				d[j] = axes[j].Dot(u[j]);
+				torque[j] = tau[j] - axes[j].Dot(bias[j]);
+				auto parent = m_chain.joint(j).Parent;
+				if (parent < 0)
+					continue;
+				auto articulated = inertia[j];
+				articulated.SubtractOuter(u[j], d[j]);
+				inertia[parent] += articulated;
+				bias[parent] += bias[j] + articulated * c[j] + u[j] * (torque[j] / d[j]);
+			}
+			std::array<SpatialVector, DOF> a;
+			for (size_t j = 0; j < DOF; ++j)
+			{
+				auto parent = m_chain.joint(j).Parent;
+				a[j] = (parent < 0 ? BaseAcceleration() : a[parent]) + c[j];
+				qdd[j] = (torque[j] - u[j].Dot(a[j])) / d[j];
+				a[j] += axes[j] * qdd[j];
+			}
+		}
+
+		template<size_t DOF>
+		void ChainDynamics<DOF>::Step(Vector& q, Vector& qd, const Vector& tau, float dt) const
+		{
+			Vector qdd;
+			ForwardDynamics(q, qd, tau, qdd);
+			for (size_t j = 0; j < DOF; ++j)
+			{
+				qd[j] += qdd[j] * dt;
+				q[j] += qd[j] * dt;
+			}
+		}
+
+		template<size_t DOF>
+		void ChainDynamics<DOF>::InverseDynamicsBatch(size_t count, const Vector* q, const Vector* qd, const Vector* qdd,
+			Vector* tau) const
+		{
+			ParallelFor(count, [&](size_t begin, size_t end)
+			{
+				for (auto i = begin; i < end; ++i)
+					InverseDynamics(q[i], qd[i], qdd[i], tau[i]);
+			}, 64);
+		}
+
+		template<size_t DOF>
+		void ChainDynamics<DOF>::ForwardDynamicsBatch(size_t count, const Vector* q, const Vector* qd, const Vector* tau,
+			Vector* qdd) const
+		{
+			ParallelFor(count, [&](size_t begin, size_t end)
+			{
+				for (auto i = begin; i < end; ++i)
+					ForwardDynamics(q[i], qd[i], tau[i], qdd[i]);
+			}, 64);
+		}
+	}
+}
@@ -0,0 +1,6 @@
+#include "dampedIK.h"
+#include "pumaKinematics.h"
+
+//The PUMA arm is the only chain in the project, so the solver is compiled for it here, where template errors
+//show up in every build of the application; headlessChecks compares it with PumaKinematics.
+template class mini::gk2::DampedIK<mini::gk2::PumaKinematics::JOINTS_COUNT>;
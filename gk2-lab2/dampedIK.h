@@ -0,0 +1,280 @@
+#pragma once
+#include <DirectXMath.h>
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include "kinematicChain.h"
+#include "parallel.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Counters of DampedIK solves
+		struct DampedIKStats
+		{
+			size_t solves;
+			size_t converged;
+			size_t iterations;	//total over all solves
+			size_t limited;		//solutions with a joint stopped at its limit
+			float maxError;		//largest remaining error of solves that didn't converge
+
+			DampedIKStats() : solves(0), converged(0), iterations(0), limited(0), maxError(0.0f) { }
+
+			float convergenceRate() const { return solves ? static_cast<float>(converged) / solves : 0.0f; }
+			float averageIterations() const { return solves ? static_cast<float>(iterations) / solves : 0.0f; }
+
+			void Add(const DampedIKStats& other)
+			{
+				solves += other.solves;
+				converged += other.converged;
+				iterations += other.iterations;
+				limited += other.limited;
+				maxError = std::max(maxError, other.maxError);
+			}
+		};
+
+		struct JointRange
+		{
+			float Min, Max;
+		};
+
+		//Numerical IK of a KinematicChain with DOF joints, for arms without a closed-form solution.
+		//The tool is a point and a normal attached to the last link (like the tool tip and the normal of the touched
+		//surface in PumaKinematics). Every iteration builds the geometric Jacobian of the tool position and normal
+		//from the link matrices and takes a damped least squares step (J^T J + l^2 I) d = J^T e, which stays stable
+		//near singularities. All matrices are fixed size arrays on the stack, so solves don't allocate.
+		template<size_t DOF>
+		class DampedIK
+		{
+		public:
+			using Angles = std::array<float, DOF>;
+
+			struct Settings
+			{
+				unsigned int MaxIterations = 64;
+				float Damping = 0.05f;				//l, larger is slower but steadier near singularities
+				float Tolerance = 1e-4f;			//error at which a solve has converged
+				float OrientationWeight = 0.3f;		//length at which normal errors count as much as position errors
+				float MaxStep = 0.3f;				//largest change of a joint angle in one iteration
+			};
+
+			//toolPoint and toolNormal are given in the world space of the rest pose
+			DampedIK(KinematicChain chain, DirectX::XMFLOAT3 toolPoint, DirectX::XMFLOAT3 toolNormal,
+				const Settings& settings = Settings())
+				: m_chain(std::move(chain)), m_toolPoint(toolPoint), m_toolNormal(toolNormal), m_settings(settings)
+			{
+				assert(m_chain.jointsCount() == DOF);
+				for (auto& l : m_limits)
+					l = { -FLT_MAX, FLT_MAX };
+				//only ancestors of the last link move the tool
+				m_moves.fill(false);
+				for (auto j = static_cast<int>(DOF) - 1; j >= 0; j = m_chain.joint(j).Parent)
+					m_moves[j] = true;
+			}
+
+			void SetLimits(const std::array<JointRange, DOF>& limits) { m_limits = limits; }
+			void SetSettings(const Settings& settings) { m_settings = settings; }
+
+			//Iterates from seed towards the target. Returns true on convergence; angles receive the last iterate
+			//either way. stats may be null.
+			bool Solve(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 normal, const Angles& seed, Angles& angles,
+				DampedIKStats* stats = nullptr) const;
+			//Solves count independent targets split between threads. converged may be null.
+			//Returns the number of converged solves; stats, if given, receives the counters of all of them.
+			size_t SolveBatch(size_t count, const DirectX::XMFLOAT3* positions, const DirectX::XMFLOAT3* normals,
+				const Angles* seeds, Angles* angles, uint8_t* converged = nullptr, DampedIKStats* stats = nullptr) const;
+
+			const KinematicChain& chain() const { return m_chain; }
+			const Settings& settings() const { return m_settings; }
+
+		private:
+			static const size_t TASK = 6;	//position and normal
+
+			template<size_t N>
+			using Matrix = std::array<std::array<float, N>, N>;
+
+			KinematicChain m_chain;
+			DirectX::XMFLOAT3 m_toolPoint, m_toolNormal;
+			Settings m_settings;
+			std::array<JointRange, DOF> m_limits;
+			std::array<bool, DOF> m_moves;
+
+			//Solves A x = b in place for symmetric positive definite A (Cholesky decomposition)
+			template<size_t N>
+			static void CholeskySolve(Matrix<N>& a, std::array<float, N>& b);
+		};
+
+		template<size_t DOF>
+		template<size_t N>
+		void DampedIK<DOF>::CholeskySolve(Matrix<N>& a, std::array<float, N>& b)
+		{
+			//lower triangle of a is replaced by L, A = L L^T
+			for (size_t i = 0; i < N; ++i)
+			{
+				for (size_t j = 0; j <= i; ++j)
+				{
+					auto sum = a[i][j];
+					for (size_t k = 0; k < j; ++k)
+						sum -= a[i][k] * a[j][k];
+					a[i][j] = i == j ? sqrtf(std::max(sum, FLT_MIN)) : sum / a[j][j];
+				}
+			}
+			for (size_t i = 0; i < N; ++i)
+			{
+				for (size_t k = 0; k < i; ++k)
+					b[i] -= a[i][k] * b[k];
+				b[i] /= a[i][i];
+			}
+			for (auto i = N; i-- > 0;)
+			{
+				for (auto k = i + 1; k < N; ++k)
+					b[i] -= a[k][i] * b[k];
+				b[i] /= a[i][i];
+			}
+		}
+
+		template<size_t DOF>
+		bool DampedIK<DOF>::Solve(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 normal, const Angles& seed, Angles& angles,
+			DampedIKStats* stats) const
+		{
+			using namespace DirectX;
+			auto target = XMLoadFloat3(&position);
+			auto targetNormal = XMVector3Normalize(XMLoadFloat3(&normal));
+			auto w = m_settings.OrientationWeight;
+			auto lambdaSq = m_settings.Damping * m_settings.Damping;
+			std::array<XMFLOAT4X4, DOF> links;
+			angles = seed;
+			auto converged = false;
+			auto errorSq = 0.0f;
+			unsigned int iteration = 0;
+			for (;; ++iteration)
+			{
+				m_chain.ForwardKinematics(1, angles.data(), links.data());
+				auto tool = XMLoadFloat4x4(&links[DOF - 1]);
+				auto p = XMVector3TransformCoord(XMLoadFloat3(&m_toolPoint), tool);
+				auto n = XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&m_toolNormal), tool));
+
+				std::array<float, TASK> e;
+				XMFLOAT3 ep, en;
+				XMStoreFloat3(&ep, XMVectorSubtract(target, p));
+				XMStoreFloat3(&en, XMVectorScale(XMVectorSubtract(targetNormal, n), w));
+				e = { ep.x, ep.y, ep.z, en.x, en.y, en.z };
+				errorSq = 0.0f;
+				for (auto v : e)
+					errorSq += v * v;
+				converged = errorSq <= m_settings.Tolerance * m_settings.Tolerance;
+				if (converged || iteration == m_settings.MaxIterations)
+					break;
+
+				//columns: how the tool point and normal move when joint j turns about its axis
+				std::array<std::array<float, DOF>, TASK> jacobian{};
+				for (size_t j = 0; j < DOF; ++j)
+				{
+					if (!m_moves[j])
+						continue;
+					auto link = XMLoadFloat4x4(&links[j]);
+					auto axis = XMVector3TransformNormal(XMLoadFloat3(&m_chain.joint(j).Axis), link);
+					auto pivot = XMVector3TransformCoord(XMLoadFloat3(&m_chain.joint(j).Pivot), link);
+					XMFLOAT3 dp, dn;
+					XMStoreFloat3(&dp, XMVector3Cross(axis, XMVectorSubtract(p, pivot)));
+					XMStoreFloat3(&dn, XMVectorScale(XMVector3Cross(axis, n), w));
+					jacobian[0][j] = dp.x; jacobian[1][j] = dp.y; jacobian[2][j] = dp.z;
+					jacobian[3][j] = dn.x; jacobian[4][j] = dn.y; jacobian[5][j] = dn.z;
+				}
+
+				//the smaller of the two equivalent systems is solved
+				std::array<float, DOF> step{};
+				if constexpr (DOF <= TASK)
+				{
+					Matrix<DOF> a{};
+					for (size_t r = 0; r < DOF; ++r)
+					{
+						for (size_t c = 0; c <= r; ++c)
+						{
+							auto sum = 0.0f;
+							for (size_t k = 0; k < TASK; ++k)
+								sum += jacobian[k][r] * jacobian[k][c];
+							a[r][c] = a[c][r] = sum;
+						}
+						a[r][r] += lambdaSq;
+						for (size_t k = 0; k < TASK; ++k)
+							step[r] += jacobian[k][r] * e[k];
+					}
+					CholeskySolve(a, step);
+				}
+				else
+				{
+					Matrix<TASK> a{};
+					for (size_t r = 0; r < TASK; ++r)
+					{
+						for (size_t c = 0; c <= r; ++c)
+						{
+							auto sum = 0.0f;
+							for (size_t k = 0; k < DOF; ++k)
+								sum += jacobian[r][k] * jacobian[c][k];
+							a[r][c] = a[c][r] = sum;
+						}
+						a[r][r] += lambdaSq;
+					}
+					auto y = e;
+					CholeskySolve(a, y);
+					for (size_t k = 0; k < DOF; ++k)
+						for (size_t r = 0; r < TASK; ++r)
+							step[k] += jacobian[r][k] * y[r];
+				}
+
+				auto largest = 0.0f;
+				for (auto s : step)
+					largest = std::max(largest, fabsf(s));
+				auto scale = largest > m_settings.MaxStep ? m_settings.MaxStep / largest : 1.0f;
+				for (size_t j = 0; j < DOF; ++j)
+					angles[j] = std::clamp(angles[j] + scale * step[j], m_limits[j].Min, m_limits[j].Max);
+			}
+
+			if (stats)
+			{
+				++stats->solves;
+				stats->iterations += iteration;
+				if (converged)
+					++stats->converged;
+				else
+					stats->maxError = std::max(stats->maxError, sqrtf(errorSq));
+				for (size_t j = 0; j < DOF; ++j)
+					if (angles[j] <= m_limits[j].Min || angles[j] >= m_limits[j].Max)
+					{
+						++stats->limited;
+						break;
+					}
+			}
+			return converged;
+		}
+
+		template<size_t DOF>
+		size_t DampedIK<DOF>::SolveBatch(size_t count, const DirectX::XMFLOAT3* positions, const DirectX::XMFLOAT3* normals,
+			const Angles* seeds, Angles* angles, uint8_t* converged, DampedIKStats* stats) const
+		{
+			DampedIKStats total;
+			std::mutex merge;
+			ParallelFor(count, [&](size_t begin, size_t end)
+			{
+				DampedIKStats local;
+				for (auto i = begin; i < end; ++i)
+				{
+					auto ok = Solve(positions[i], normals[i], seeds[i], angles[i], &local);
+					if (converged)
+						converged[i] = ok ? 1 : 0;
+				}
+				std::lock_guard<std::mutex> lock(merge);
+				total.Add(local);
+			}, 16);
+			if (stats)
+				stats->Add(total);
+			return total.converged;
+		}
+	}
+}
@@ -62,6 +62,17 @@ void mini::DxApplication::UpdateBuffer(const dx_ptr<ID3D11Buffer>& buffer, const
 	m_device.context()->Unmap(buffer.get(), 0);
 }
 
+void mini::DxApplication::UpdateBufferRange(const dx_ptr<ID3D11Buffer>& buffer, size_t offset, const void* data, size_t count,
+	bool discard)
+{
+	D3D11_MAPPED_SUBRESOURCE res;
+	auto hr = m_device.context()->Map(buffer.get(), 0, discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0, &res);
+	if (FAILED(hr))
+		THROW_DX(hr);
+	memcpy(static_cast<char*>(res.pData) + offset, data, count);
+	m_device.context()->Unmap(buffer.get(), 0);
+}
+
 bool DxApplication::HandleCameraInput(double dt)
 {
 	MouseState mstate;
@@ -40,6 +40,9 @@ namespace mini
 		{
 			UpdateBuffer(buffer, data.data(), data.size() * sizeof(T));
 		}
+		//Copies count bytes at offset of a dynamic vertex or index buffer. Without discard the buffer is mapped with
+		//D3D11_MAP_WRITE_NO_OVERWRITE, so the written range must not be used by draws issued since the last discard.
+		void UpdateBufferRange(const dx_ptr<ID3D11Buffer>& buffer, size_t offset, const void* data, size_t count, bool discard);
 
 		bool HandleCameraInput(double dt);
 
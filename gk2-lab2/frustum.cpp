@@ -0,0 +1,45 @@
+#include "frustum.h"
+
+using namespace mini;
+using namespace DirectX;
+
+ViewFrustum::ViewFrustum()
+{
+	//planes that accept every point
+	for (auto i = 0U; i < 2U; ++i)
+	{
+		m_nx[i] = m_ny[i] = m_nz[i] = XMVectorZero();
+		m_d[i] = XMVectorReplicate(FLT_MAX);
+	}
+}
+
+ViewFrustum::ViewFrustum(FXMMATRIX viewProjMtx)
+{
+	//clip-space coordinates are p*M, so each plane is a combination of matrix columns
+	auto m = XMMatrixTranspose(viewProjMtx);
+	XMFLOAT4 planes[8];
+	XMStoreFloat4(&planes[0], XMPlaneNormalize(XMVectorAdd(m.r[3], m.r[0])));		//left
+	XMStoreFloat4(&planes[1], XMPlaneNormalize(XMVectorSubtract(m.r[3], m.r[0])));	//right
+	XMStoreFloat4(&planes[2], XMPlaneNormalize(XMVectorAdd(m.r[3], m.r[1])));		//bottom
+	XMStoreFloat4(&planes[3], XMPlaneNormalize(XMVectorSubtract(m.r[3], m.r[1])));	//top
+	XMStoreFloat4(&planes[4], XMPlaneNormalize(m.r[2]));							//near
+	XMStoreFloat4(&planes[5], XMPlaneNormalize(XMVectorSubtract(m.r[3], m.r[2])));	//far
+	//padding repeats the first planes, so it never rejects anything on its own
+	planes[6] = planes[0];
+	planes[7] = planes[1];
+	for (auto i = 0U; i < 2U; ++i)
+	{
+		auto p = planes + 4 * i;
+		m_nx[i] = XMVectorSet(p[0].x, p[1].x, p[2].x, p[3].x);
+		m_ny[i] = XMVectorSet(p[0].y, p[1].y, p[2].y, p[3].y);
+		m_nz[i] = XMVectorSet(p[0].z, p[1].z, p[2].z, p[3].z);
+		m_d[i] = XMVectorSet(p[0].w, p[1].w, p[2].w, p[3].w);
+	}
+}
+
+XMVECTOR ViewFrustum::getPlane(unsigned int i) const
+{
+	auto block = i / 4U, lane = i % 4U;
+	return XMVectorSet(XMVectorGetByIndex(m_nx[block], lane), XMVectorGetByIndex(m_ny[block], lane),
+		XMVectorGetByIndex(m_nz[block], lane), XMVectorGetByIndex(m_d[block], lane));
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <DirectXMath.h>
+
+namespace mini
+{
+	//View frustum planes stored in SoA form: component arrays of six planes padded to eight,
+	//so a point can be tested against four planes with a single vector operation.
+	//Planes point inwards, i.e. dot(n, p) + d >= 0 for points inside.
+	class ViewFrustum
+	{
+	public:
+		ViewFrustum();
+		//Extracts planes from a row-vector view*projection matrix (D3D clip space, 0 <= z <= w)
+		explicit ViewFrustum(DirectX::FXMMATRIX viewProjMtx);
+
+		DirectX::XMVECTOR getPlane(unsigned int i) const;
+
+		//Returns true if sphere is at least partially inside the frustum
+		bool IntersectsSphere(DirectX::FXMVECTOR center, float radius) const
+		{
+			using namespace DirectX;
+			auto x = XMVectorSplatX(center), y = XMVectorSplatY(center), z = XMVectorSplatZ(center);
+			auto r = XMVectorReplicate(-radius);
+			auto outside = XMVectorFalseInt();
+			for (auto i = 0U; i < 2U; ++i)
+			{
+				auto d = XMVectorMultiplyAdd(m_nx[i], x, XMVectorMultiplyAdd(m_ny[i], y, XMVectorMultiplyAdd(m_nz[i], z, m_d[i])));
+				outside = XMVectorOrInt(outside, XMVectorLess(d, r));
+			}
+			return XMVector4EqualInt(outside, XMVectorFalseInt());
+		}
+
+	private:
+		DirectX::XMVECTOR m_nx[2], m_ny[2], m_nz[2], m_d[2];
+	};
+}
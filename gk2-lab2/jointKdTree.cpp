@@ -0,0 +1,126 @@
+#include "jointKdTree.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+using namespace mini;
+using namespace gk2;
+using namespace std;
+
+namespace
+{
+	float DistanceSq(const PumaAngles& a, const PumaAngles& b)
+	{
+		auto sum = 0.0f;
+		for (size_t j = 0; j < a.size(); ++j)
+			sum += (b[j] - a[j]) * (b[j] - a[j]);
+		return sum;
+	}
+
+	//Depth beyond which the tree is rebuilt, a few times that of a balanced tree
+	unsigned int MaxDepth(size_t count)
+	{
+		return 3 * static_cast<unsigned int>(log2(static_cast<double>(count) + 1.0)) + 8;
+	}
+}
+
+size_t JointKdTree::Insert(const PumaAngles& point)
+{
+	auto index = static_cast<uint32_t>(m_points.size());
+	m_points.push_back(point);
+	auto depth = 0U;
+	auto* link = &m_root;
+	while (*link >= 0)
+	{
+		auto& n = m_nodes[*link];
+		link = point[n.Axis] < m_points[n.Point][n.Axis] ? &n.Left : &n.Right;
+		++depth;
+	}
+	//link may point into m_nodes, so it's set before the vector grows
+	*link = static_cast<int32_t>(m_nodes.size());
+	m_nodes.push_back({ index, -1, -1, static_cast<uint8_t>(depth % AXES) });
+	if (depth > MaxDepth(m_points.size()))
+		Rebuild();
+	return index;
+}
+
+size_t JointKdTree::Nearest(const PumaAngles& point, float* distanceSq) const
+{
+	assert(m_root >= 0);
+	auto best = m_nodes[m_root].Point;
+	auto bestSq = FLT_MAX;
+	Search(m_root, point, best, bestSq);
+	if (distanceSq)
+		*distanceSq = bestSq;
+	return best;
+}
+
+void JointKdTree::Search(int32_t node, const PumaAngles& point, uint32_t& best, float& bestSq) const
+{
+	while (node >= 0)
+	{
+		auto& n = m_nodes[node];
+		auto& p = m_points[n.Point];
+		auto d = DistanceSq(p, point);
+		if (d < bestSq)
+		{
+			bestSq = d;
+			best = n.Point;
+		}
+		auto offset = point[n.Axis] - p[n.Axis];
+		auto nearSide = offset < 0.0f ? n.Left : n.Right, farSide = offset < 0.0f ? n.Right : n.Left;
+		//the far side can only be closer if the splitting plane is
+		if (farSide >= 0 && offset * offset < bestSq)
+		{
+			Search(nearSide, point, best, bestSq);
+			if (offset * offset < bestSq)
+				Search(farSide, point, best, bestSq);
+			return;
+		}
+		node = nearSide;
+	}
+}
+
+void JointKdTree::Clear()
+{
+	m_points.clear();
+	m_nodes.clear();
+	m_root = -1;
+}
+
+void JointKdTree::Reserve(size_t count)
+{
+	m_points.reserve(count);
+	m_nodes.reserve(count);
+}
+
+void JointKdTree::Rebuild()
+{
+	m_order.resize(m_points.size());
+	for (uint32_t i = 0; i < m_order.size(); ++i)
+		m_order[i] = i;
+	m_nodes.clear();
+	m_root = Build(m_order.data(), m_order.data() + m_order.size(), 0);
+}
+
+int32_t JointKdTree::Build(uint32_t* first, uint32_t* last, unsigned int depth)
+{
+	if (first == last)
+		return -1;
+	auto axis = depth % AXES;
+	//the median splits the points, equal coordinates go right as in Insert
+	auto median = first + (last - first) / 2;
+	nth_element(first, median, last, [&](uint32_t a, uint32_t b) { return m_points[a][axis] < m_points[b][axis]; });
+	auto split = m_points[*median][axis];
+	auto equal = partition(first, median, [&](uint32_t a) { return m_points[a][axis] < split; });
+	iter_swap(equal, median);
+	median = equal;
+	auto node = static_cast<int32_t>(m_nodes.size());
+	m_nodes.push_back({ *median, -1, -1, static_cast<uint8_t>(axis) });
+	auto left = Build(first, median, depth + 1);
+	auto right = Build(median + 1, last, depth + 1);
+	m_nodes[node].Left = left;
+	m_nodes[node].Right = right;
+	return node;
+}
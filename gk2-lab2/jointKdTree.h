@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "pumaKinematics.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Nearest neighbour search over PUMA joint angles for sampling-based planners.
+		//Points are inserted one at a time, each splitting the cell it falls into across the next axis in turn.
+		//Planners often add points along straight lines, which would grow long chains of nodes, so the tree is
+		//rebuilt balanced once a path from the root gets too deep. Points keep the index they were inserted with.
+		class JointKdTree
+		{
+		public:
+			//Returns the index of the point
+			size_t Insert(const PumaAngles& point);
+			//Index of the point closest to point in joint space; the tree must not be empty.
+			//distanceSq, if given, receives the squared distance to it.
+			size_t Nearest(const PumaAngles& point, float* distanceSq = nullptr) const;
+			//Removes all points, keeping the memory
+			void Clear();
+			void Reserve(size_t count);
+
+			const PumaAngles& point(size_t index) const { return m_points[index]; }
+			size_t size() const { return m_points.size(); }
+			bool empty() const { return m_points.empty(); }
+
+		private:
+			static const unsigned int AXES = PumaKinematics::JOINTS_COUNT;
+
+			struct Node
+			{
+				uint32_t Point;
+				int32_t Left, Right;	//-1 if there is no child
+				uint8_t Axis;
+			};
+
+			std::vector<PumaAngles> m_points;
+			std::vector<Node> m_nodes;
+			std::vector<uint32_t> m_order;	//scratch of Rebuild
+			int32_t m_root = -1;
+
+			void Search(int32_t node, const PumaAngles& point, uint32_t& best, float& bestSq) const;
+			void Rebuild();
+			int32_t Build(uint32_t* first, uint32_t* last, unsigned int depth);
+		};
+	}
+}
@@ -0,0 +1,173 @@
+#include "jointTrajectory.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	PumaAngles Lerp(const PumaAngles& a, const PumaAngles& b, float t)
+	{
+		PumaAngles r;
+		for (size_t j = 0; j < r.size(); ++j)
+			r[j] = a[j] + (b[j] - a[j]) * t;
+		return r;
+	}
+}
+
+void JointTrajectory::Append(float time, const PumaAngles& angles)
+{
+	m_times.push_back(time);
+	m_angles.push_back(angles);
+}
+
+JointTrajectory JointTrajectory::JointMove(const PumaAngles& from, const PumaAngles& to, float duration)
+{
+	JointTrajectory move;
+	for (auto i = 0; i <= EASE_KEYS; ++i)
+	{
+		auto t = static_cast<float>(i) / EASE_KEYS;
+		move.Append(t * duration, Lerp(from, to, t * t * (3.0f - 2.0f * t)));
+	}
+	return move;
+}
+
+PumaAngles JointTrajectory::Sample(float time) const
+{
+	size_t cursor = 0;
+	return Sample(time, cursor);
+}
+
+PumaAngles JointTrajectory::Sample(float time, size_t& cursor) const
+{
+	if (m_times.empty())
+		return {};
+	if (time <= m_times.front())
+	{
+		cursor = 0;
+		return m_angles.front();
+	}
+	if (time >= m_times.back())
+	{
+		cursor = m_times.size() - 1;
+		return m_angles.back();
+	}
+	if (cursor >= m_times.size() || m_times[cursor] > time)
+		cursor = 0;
+	//playback moves forward by a few keys per frame, so a short linear search beats bisection
+	while (m_times[cursor + 1] < time)
+		++cursor;
+	auto span = m_times[cursor + 1] - m_times[cursor];
+	if (span <= 0.0f)
+		return m_angles[cursor + 1];
+	return Lerp(m_angles[cursor], m_angles[cursor + 1], (time - m_times[cursor]) / span);
+}
+
+void JointTrajectory::Compact(float tolerance)
+{
+	if (m_times.size() < 3)
+		return;
+	vector<float> times{ m_times.front() };
+	vector<PumaAngles> angles{ m_angles.front() };
+	//slopes from key last that pass within tolerance of every key after it so far, per joint, so each key is
+	//tested once instead of again for every later candidate end of the segment
+	PumaAngles minSlope, maxSlope;
+	auto reset = [&]
+	{
+		minSlope.fill(-numeric_limits<float>::infinity());
+		maxSlope.fill(numeric_limits<float>::infinity());
+	};
+	reset();
+	size_t last = 0;
+	for (size_t next = 2; next < m_times.size(); ++next)
+	{
+		//key next - 1 lies between last and next
+		auto k = next - 1;
+		auto dt = m_times[k] - m_times[last];
+		for (size_t j = 0; j < minSlope.size(); ++j)
+		{
+			auto da = m_angles[k][j] - m_angles[last][j];
+			if (dt > 0.0f)
+			{
+				minSlope[j] = max(minSlope[j], (da - tolerance) / dt);
+				maxSlope[j] = min(maxSlope[j], (da + tolerance) / dt);
+			}
+			else if (fabsf(da) > tolerance)
+				minSlope[j] = numeric_limits<float>::infinity();
+		}
+		//can all keys between last and next be dropped?
+		auto span = m_times[next] - m_times[last];
+		auto fits = span > 0.0f;
+		for (size_t j = 0; j < minSlope.size() && fits; ++j)
+		{
+			auto slope = (m_angles[next][j] - m_angles[last][j]) / span;
+			fits = slope >= minSlope[j] && slope <= maxSlope[j];
+		}
+		if (!fits)
+		{
+			last = k;
+			times.push_back(m_times[last]);
+			angles.push_back(m_angles[last]);
+			reset();
+		}
+	}
+	times.push_back(m_times.back());
+	angles.push_back(m_angles.back());
+	m_times = move(times);
+	m_angles = move(angles);
+}
+
+void TrajectoryPlayer::Play(JointTrajectory trajectory, bool loop)
+{
+	Stop();
+	Queue(move(trajectory), loop);
+}
+
+void TrajectoryPlayer::Queue(JointTrajectory trajectory, bool loop)
+{
+	if (!trajectory.empty())
+		m_queue.push_back({ move(trajectory), loop });
+}
+
+void TrajectoryPlayer::Stop()
+{
+	m_queue.clear();
+	m_time = 0.0f;
+	m_cursor = 0;
+}
+
+bool TrajectoryPlayer::Update(float dt, PumaAngles& angles)
+{
+	if (m_queue.empty())
+		return false;
+	m_time += dt;
+	//skip finished trajectories, carrying the remaining time over to the next one
+	while (true)
+	{
+		auto& current = m_queue.front();
+		auto duration = current.Trajectory.duration();
+		if (m_time <= duration)
+			break;
+		if (current.Loop)
+		{
+			m_time = duration > 0.0f ? fmodf(m_time, duration) : 0.0f;
+			m_cursor = 0;
+			break;
+		}
+		if (m_queue.size() == 1)
+		{
+			angles = current.Trajectory.angles().back();
+			Stop();
+			return true;
+		}
+		m_time -= duration;
+		m_cursor = 0;
+		m_queue.pop_front();
+	}
+	angles = m_queue.front().Trajectory.Sample(m_time, m_cursor);
+	return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <deque>
+#include <vector>
+#include "pumaKinematics.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Joint angles keyed by time and linearly interpolated between keys
+		class JointTrajectory
+		{
+		public:
+			//Keys must be appended in increasing time order
+			void Append(float time, const PumaAngles& angles);
+			//Straight line in joint space eased in and out
+			static JointTrajectory JointMove(const PumaAngles& from, const PumaAngles& to, float duration);
+
+			PumaAngles Sample(float time) const;
+			//cursor - key index reused between calls, so playing forward finds keys in constant time
+			PumaAngles Sample(float time, size_t& cursor) const;
+			//Removes keys that linear interpolation of their neighbours reproduces within tolerance radians
+			void Compact(float tolerance);
+
+			float duration() const { return m_times.empty() ? 0.0f : m_times.back(); }
+			size_t keysCount() const { return m_times.size(); }
+			bool empty() const { return m_times.empty(); }
+			const std::vector<float>& times() const { return m_times; }
+			const std::vector<PumaAngles>& angles() const { return m_angles; }
+
+		private:
+			static const int EASE_KEYS = 16;	//keys of JointMove
+
+			std::vector<float> m_times;
+			std::vector<PumaAngles> m_angles;
+		};
+
+		//Plays queued trajectories one after another at frame rate
+		class TrajectoryPlayer
+		{
+		public:
+			//Replaces queued trajectories
+			void Play(JointTrajectory trajectory, bool loop = false);
+			//Plays after the trajectories already queued; a looped one is never left, so nothing after it plays
+			void Queue(JointTrajectory trajectory, bool loop = false);
+			void Stop();
+
+			//Advances playback by dt and returns current angles. Returns false if there is nothing to play.
+			bool Update(float dt, PumaAngles& angles);
+
+			bool playing() const { return !m_queue.empty(); }
+
+		private:
+			struct Entry
+			{
+				JointTrajectory Trajectory;
+				bool Loop;
+			};
+
+			std::deque<Entry> m_queue;
+			float m_time = 0.0f;
+			size_t m_cursor = 0;
+		};
+	}
+}
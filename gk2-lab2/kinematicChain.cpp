@@ -0,0 +1,81 @@
+#include "kinematicChain.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+KinematicChain::KinematicChain(vector<JointDescriptor> joints)
+	: m_joints(move(joints))
+{
+	auto count = m_joints.size();
+	m_pivotIn.resize(count);
+	m_pivotOut.resize(count);
+	m_angles.assign(count, 0.0f);
+	m_links.resize(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		auto& j = m_joints[i];
+		assert(j.Parent < static_cast<int>(i));
+		XMStoreFloat3(&j.Axis, XMVector3Normalize(XMLoadFloat3(&j.Axis)));
+		XMStoreFloat4x4(&m_pivotIn[i], XMMatrixTranslation(-j.Pivot.x, -j.Pivot.y, -j.Pivot.z));
+		XMStoreFloat4x4(&m_pivotOut[i], XMMatrixTranslation(j.Pivot.x, j.Pivot.y, j.Pivot.z));
+	}
+}
+
+void KinematicChain::SetAngle(size_t joint, float angle)
+{
+	if (m_angles[joint] == angle)
+		return;
+	m_angles[joint] = angle;
+	m_firstDirty = min(m_firstDirty, joint);
+}
+
+void KinematicChain::SetAngles(const float* angles)
+{
+	for (size_t i = 0; i < m_angles.size(); ++i)
+		SetAngle(i, angles[i]);
+}
+
+XMMATRIX XM_CALLCONV KinematicChain::LocalMatrix(size_t joint, float angle) const
+{
+	return XMLoadFloat4x4(&m_pivotIn[joint]) * XMMatrixRotationNormal(XMLoadFloat3(&m_joints[joint].Axis), angle) *
+		XMLoadFloat4x4(&m_pivotOut[joint]);
+}
+
+bool KinematicChain::Update()
+{
+	auto count = m_joints.size();
+	if (m_firstDirty >= count)
+		return false;
+	for (auto i = m_firstDirty; i < count; ++i)
+	{
+		auto local = LocalMatrix(i, m_angles[i]);
+		auto parent = m_joints[i].Parent;
+		XMStoreFloat4x4(&m_links[i], parent < 0 ? local : local * XMLoadFloat4x4(&m_links[parent]));
+	}
+	m_firstDirty = count;
+	return true;
+}
+
+void KinematicChain::ForwardKinematics(size_t count, const float* angles, XMFLOAT4X4* links) const
+{
+	auto joints = m_joints.size();
+	ParallelFor(count, [&](size_t begin, size_t end)
+	{
+		for (auto c = begin; c < end; ++c)
+		{
+			auto configAngles = angles + c * joints;
+			auto configLinks = links + c * joints;
+			for (size_t i = 0; i < joints; ++i)
+			{
+				auto local = LocalMatrix(i, configAngles[i]);
+				auto parent = m_joints[i].Parent;
+				XMStoreFloat4x4(&configLinks[i], parent < 0 ? local : local * XMLoadFloat4x4(&configLinks[parent]));
+			}
+		}
+	}, 256);
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Revolute joint rotating its link about an axis through a pivot, both given in the world space
+		//of the rest pose (all angles 0). Parent is the index of the joint the link is attached to, or -1.
+		struct JointDescriptor
+		{
+			DirectX::XMFLOAT3 Axis;
+			DirectX::XMFLOAT3 Pivot;
+			int Parent;
+		};
+
+		//Tree of revolute joints with world matrices of their links stored contiguously.
+		//Joints must be ordered so that every parent precedes its children; then changing a joint
+		//invalidates only the links from that joint on, and Update recomputes just those.
+		class KinematicChain
+		{
+		public:
+			KinematicChain() = default;
+			explicit KinematicChain(std::vector<JointDescriptor> joints);
+
+			//Marks links from joint on as out of date if the angle differs from the current one
+			void SetAngle(size_t joint, float angle);
+			//angles - jointsCount() values
+			void SetAngles(const float* angles);
+			//Recomputes out of date link matrices. Returns false if all were up to date.
+			bool Update();
+
+			//World matrices of the links, one per joint, valid after Update
+			const DirectX::XMFLOAT4X4* linkMatrices() const { return m_links.data(); }
+			const DirectX::XMFLOAT4X4& linkMatrix(size_t joint) const { return m_links[joint]; }
+			float angle(size_t joint) const { return m_angles[joint]; }
+			size_t jointsCount() const { return m_joints.size(); }
+			const JointDescriptor& joint(size_t joint) const { return m_joints[joint]; }
+
+			//Link matrices of count configurations, independent of the chain's own angles.
+			//angles - count * jointsCount() values, configuration after configuration
+			//links - count * jointsCount() matrices in the same layout
+			void ForwardKinematics(size_t count, const float* angles, DirectX::XMFLOAT4X4* links) const;
+
+		private:
+			std::vector<JointDescriptor> m_joints;
+			std::vector<DirectX::XMFLOAT4X4> m_pivotIn, m_pivotOut;	//translations moving pivots to the origin and back
+			std::vector<float> m_angles;
+			std::vector<DirectX::XMFLOAT4X4> m_links;
+			size_t m_firstDirty = 0;	//links from this one on are out of date
+
+			DirectX::XMMATRIX XM_CALLCONV LocalMatrix(size_t joint, float angle) const;
+		};
+	}
+}
@@ -0,0 +1,32 @@
+#include "lampAnimation.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+const XMFLOAT4 LampAnimation::LIGHT_POSITION{ 0.0f, -0.05f, 0.0f, 1.0f };
+const XMFLOAT4 LampAnimation::LIGHT_TARGET{ 0.0f, -10.0f, 0.0f, 1.0f };
+const XMFLOAT4 LampAnimation::LIGHT_UP{ 1.0f, 0.0f, 0.0f, 0.0f };
+
+XMMATRIX LampAnimation::lampMatrix() const
+{
+	auto swing = 0.3f * XMScalarSin(XM_2PI * m_time / 8);
+	auto rot = XM_2PI * m_time / 20;
+	return XMMatrixTranslation(0.0f, -0.4f, 0.0f) * XMMatrixRotationX(swing) * XMMatrixRotationY(rot) *
+		XMMatrixTranslation(0.0f, 2.0f, 0.0f);
+}
+
+XMFLOAT3 LampAnimation::lightPosition() const
+{
+	XMFLOAT3 position;
+	XMStoreFloat3(&position, XMVector3TransformCoord(XMLoadFloat4(&LIGHT_POSITION), lampMatrix()));
+	return position;
+}
+
+XMMATRIX LampAnimation::lightViewMatrix() const
+{
+	auto lamp = lampMatrix();
+	return XMMatrixLookAtLH(XMVector3TransformCoord(XMLoadFloat4(&LIGHT_POSITION), lamp),
+		XMVector3TransformCoord(XMLoadFloat4(&LIGHT_TARGET), lamp), XMVector3TransformNormal(XMLoadFloat4(&LIGHT_UP), lamp));
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <DirectXMath.h>
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Ceiling lamp swinging on its cord while slowly turning, and the spot light hanging from it.
+		//Only depends on time, so it can be advanced without a window, e.g. by the headless runner.
+		class LampAnimation
+		{
+		public:
+			explicit LampAnimation(float time = 0.0f) : m_time(time) { }
+
+			void Update(float dt) { m_time += dt; }
+
+			float time() const { return m_time; }
+			//World matrix of the lamp mesh
+			DirectX::XMMATRIX lampMatrix() const;
+			DirectX::XMFLOAT3 lightPosition() const;
+			//View matrix of the light looking down from the lamp, used for the shadow map
+			DirectX::XMMATRIX lightViewMatrix() const;
+
+		private:
+			static const DirectX::XMFLOAT4 LIGHT_POSITION, LIGHT_TARGET, LIGHT_UP;	//in lamp space
+
+			float m_time;
+		};
+	}
+}
@@ -8,12 +8,12 @@ using namespace gk2;
 int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE prevInstance, LPWSTR cmdLine, int cmdShow)
 {
 	UNREFERENCED_PARAMETER(prevInstance);
-	UNREFERENCED_PARAMETER(cmdLine);
 	auto exitCode = EXIT_FAILURE;
 	CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
 	try
 	{
-		RoomDemo app(hInstance);
+		//--cpu-billboards expands particles without the geometry shader
+		RoomDemo app(hInstance, cmdLine && wcsstr(cmdLine, L"--cpu-billboards"));
 		exitCode = app.Run();
 	}
 	catch (Exception& e)
@@ -1,4 +1,5 @@
 #include "mesh.h"
+#include "meshData.h"
 #include <algorithm>
 #include <fstream>
 
@@ -64,6 +65,20 @@ void Mesh::Render(const dx_ptr<ID3D11DeviceContext>& context) const
 	context->DrawIndexed(m_indexCount, 0, 0);
 }
 
+void Mesh::RenderInstanced(const dx_ptr<ID3D11DeviceContext>& context, const dx_ptr<ID3D11Buffer>& instances,
+	unsigned int instanceStride, unsigned int instanceCount, unsigned int startInstance) const
+{
+	if (!m_indexBuffer || m_vertexBuffers.empty() || !instanceCount)
+		return;
+	context->IASetPrimitiveTopology(m_primitiveType);
+	context->IASetIndexBuffer(m_indexBuffer.get(), DXGI_FORMAT_R16_UINT, 0);
+	context->IASetVertexBuffers(0, m_vertexBuffers.size(), m_vertexBuffers.data(), m_strides.data(), m_offsets.data());
+	auto instanceBuffer = instances.get();
+	unsigned int offset = 0;
+	context->IASetVertexBuffers(m_vertexBuffers.size(), 1, &instanceBuffer, &instanceStride, &offset);
+	context->DrawIndexedInstanced(m_indexCount, instanceCount, 0, 0, startInstance);
+}
+
 Mesh::~Mesh()
 {
 	Release();
@@ -397,65 +412,7 @@ std::vector<unsigned short> mini::Mesh::DiskIdx(unsigned int slices)
 
 Mesh mini::Mesh::LoadMesh(const DxDevice& device, const std::wstring& meshPath)
 {
-	//File format for VN vertices and IN indices (IN divisible by 3, i.e. IN/3 triangles):
-	//VN IN
-	//pos.x pos.y pos.z norm.x norm.y norm.z tex.x tex.y [VN times, i.e. for each vertex]
-	//t.i1 t.i2 t.i3 [IN/3 times, i.e. for each triangle]
-
-	ifstream input;
-	// In general we shouldn't throw exceptions on end-of-file,
-	// however, in case of this file format if we reach the end
-	// of a file before we read all values, the file is
-	// ill-formated and we would need to throw an exception anyway
-	input.exceptions(ios::badbit | ios::failbit | ios::eofbit);
-	input.open(meshPath);
-
-	vector<VertexPositionNormal> verts;
-	vector<unsigned short> inds;	
-	vector<XMFLOAT3> positions;
-
-	int k, l, m, n;
-	input >> k;
-
-	for (int i = 0; i < k; i++)
-	{
-		XMFLOAT3 vec;
-		input >> vec.x >> vec.y >> vec.z;
-		positions.push_back(vec);
-	}
-	input >> l;
-	
-	vector<XMFLOAT4> normals;
-	for (int i = 0; i < l; i++)
-	{
-		XMFLOAT4 norm;
-		input >> norm.w >> norm.x >> norm.y >> norm.z;
-		normals.push_back(norm);
-		verts.push_back({ positions[norm.w], XMFLOAT3(norm.x, norm.y, norm.z) });
-	}
-	
-	input >> m;
-	
-	for (int i = 0; i < m; i++)
-	{
-		XMFLOAT3 ids;
-		input >> ids.x >> ids.y >> ids.z;
-		inds.push_back(ids.x);
-		inds.push_back(ids.y);
-		inds.push_back(ids.z);
-		/*XMFLOAT3 ids;
-		input >> ids.x >> ids.y >> ids.z;
-		m_triangleIds.push_back(ids);
-		Triangle triangle;
-		triangle.vertNormal.push_back(NormalIds(ids.x, m_normals[ids.x]));
-		triangle.vertNormal.push_back(NormalIds(ids.y, m_normals[ids.y]));
-		triangle.vertNormal.push_back(NormalIds(ids.z, m_normals[ids.z]));
-		m_triangles.push_back(triangle);*/
-	}
-
-
-		
-	return SimpleTriMesh(device, verts, inds);
+	return LoadMesh(device, MeshData::Load(meshPath));
 
 
 	//TODO Kod radka do krawdzi. zrozumie i napisa wsny.
@@ -525,3 +482,12 @@ Mesh mini::Mesh::LoadMesh(const DxDevice& device, const std::wstring& meshPath)
 
 
 }
+
+Mesh mini::Mesh::LoadMesh(const DxDevice& device, const MeshData& data)
+{
+	vector<VertexPositionNormal> verts;
+	verts.reserve(data.Positions.size());
+	for (size_t i = 0; i < data.Positions.size(); ++i)
+		verts.push_back({ data.Positions[i], data.Normals[i] });
+	return SimpleTriMesh(device, verts, data.Indices);
+}
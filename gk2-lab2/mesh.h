@@ -9,6 +9,8 @@
 
 namespace mini
 {
+	struct MeshData;
+
 	class Mesh
 	{
 	public:
@@ -36,6 +38,10 @@ namespace mini
 		Mesh& operator=(const Mesh& right) = delete;
 		Mesh& operator=(Mesh&& right) noexcept;
 		void Render(const dx_ptr<ID3D11DeviceContext>& context) const;
+		//Draws instanceCount instances with per instance data read from the vertex buffer slot following the
+		//mesh's own buffers, starting at startInstance (see VertexPositionNormal::InstancedLayout)
+		void RenderInstanced(const dx_ptr<ID3D11DeviceContext>& context, const dx_ptr<ID3D11Buffer>& instances,
+			unsigned int instanceStride, unsigned int instanceCount, unsigned int startInstance = 0) const;
 
 		template<typename VertexType>
 		static Mesh SimpleTriMesh(const DxDevice& device, const std::vector<VertexType> verts, const std::vector<unsigned short> idxs)
@@ -108,6 +114,7 @@ namespace mini
 
 		//Mesh Loading
 		static Mesh LoadMesh(const DxDevice& device, const std::wstring& meshPath);
+		static Mesh LoadMesh(const DxDevice& device, const MeshData& data);
 
 	private:
 		dx_ptr<ID3D11Buffer> m_indexBuffer;
@@ -0,0 +1,53 @@
+#include "meshData.h"
+#include <filesystem>
+#include <fstream>
+
+using namespace mini;
+using namespace DirectX;
+using namespace std;
+
+MeshData MeshData::Load(const wstring& meshPath)
+{
+	//File format:
+	//PN - number of distinct positions
+	//pos.x pos.y pos.z [PN times]
+	//VN - number of vertices
+	//pos.i norm.x norm.y norm.z [VN times, pos.i indexes the positions above]
+	//TN - number of triangles
+	//t.i1 t.i2 t.i3 [TN times, indices of vertices]
+
+	ifstream input;
+	// In general we shouldn't throw exceptions on end-of-file,
+	// however, in case of this file format if we reach the end
+	// of a file before we read all values, the file is
+	// ill-formated and we would need to throw an exception anyway
+	input.exceptions(ios::badbit | ios::failbit | ios::eofbit);
+	input.open(filesystem::path(meshPath));
+
+	size_t positionsCount;
+	input >> positionsCount;
+	vector<XMFLOAT3> positions(positionsCount);
+	for (auto& p : positions)
+		input >> p.x >> p.y >> p.z;
+
+	MeshData data;
+	size_t verticesCount;
+	input >> verticesCount;
+	data.Positions.reserve(verticesCount);
+	data.Normals.reserve(verticesCount);
+	for (size_t i = 0; i < verticesCount; ++i)
+	{
+		size_t position;
+		XMFLOAT3 normal;
+		input >> position >> normal.x >> normal.y >> normal.z;
+		data.Positions.push_back(positions.at(position));
+		data.Normals.push_back(normal);
+	}
+
+	size_t trianglesCount;
+	input >> trianglesCount;
+	data.Indices.resize(3 * trianglesCount);
+	for (auto& i : data.Indices)
+		input >> i;
+	return data;
+}
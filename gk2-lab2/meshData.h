@@ -0,0 +1,20 @@
+#pragma once
+#include <DirectXMath.h>
+#include <string>
+#include <vector>
+
+namespace mini
+{
+	//CPU copy of a triangle mesh loaded from a .mesh file.
+	//Kept free of Direct3D, so simulation code can sample and measure meshes without a device.
+	struct MeshData
+	{
+		std::vector<DirectX::XMFLOAT3> Positions;
+		std::vector<DirectX::XMFLOAT3> Normals;
+		std::vector<unsigned short> Indices;	//three per triangle
+
+		size_t trianglesCount() const { return Indices.size() / 3; }
+
+		static MeshData Load(const std::wstring& meshPath);
+	};
+}
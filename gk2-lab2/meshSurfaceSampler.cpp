@@ -0,0 +1,104 @@
+#include "meshSurfaceSampler.h"
+#include <map>
+#include <mutex>
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+MeshSurfaceSampler::MeshSurfaceSampler(const MeshData& mesh)
+	: m_area(0.0f)
+{
+	auto count = mesh.trianglesCount();
+	m_triangles.reserve(count);
+	vector<float> areas;
+	areas.reserve(count);
+	for (size_t t = 0; t < count; ++t)
+	{
+		auto i0 = mesh.Indices[3 * t], i1 = mesh.Indices[3 * t + 1], i2 = mesh.Indices[3 * t + 2];
+		auto p0 = XMLoadFloat3(&mesh.Positions[i0]);
+		auto e1 = XMVectorSubtract(XMLoadFloat3(&mesh.Positions[i1]), p0);
+		auto e2 = XMVectorSubtract(XMLoadFloat3(&mesh.Positions[i2]), p0);
+		auto area = 0.5f * XMVectorGetX(XMVector3Length(XMVector3Cross(e1, e2)));
+		//degenerate triangles can never be drawn, so they are left out
+		if (!(area > 0.0f))
+			continue;
+		Triangle tri;
+		XMStoreFloat3(&tri.P0, p0);
+		XMStoreFloat3(&tri.E1, e1);
+		XMStoreFloat3(&tri.E2, e2);
+		tri.N0 = mesh.Normals[i0];
+		tri.N1 = mesh.Normals[i1];
+		tri.N2 = mesh.Normals[i2];
+		m_triangles.push_back(tri);
+		areas.push_back(area);
+		m_area += area;
+	}
+
+	//Vose's construction: scaled probabilities below 1 are topped up by a single triangle above 1
+	auto n = m_triangles.size();
+	m_probability.resize(n);
+	m_alias.resize(n);
+	vector<uint32_t> small, large;
+	for (size_t i = 0; i < n; ++i)
+	{
+		m_probability[i] = areas[i] * n / m_area;
+		m_alias[i] = static_cast<uint32_t>(i);
+		(m_probability[i] < 1.0f ? small : large).push_back(static_cast<uint32_t>(i));
+	}
+	while (!small.empty() && !large.empty())
+	{
+		auto s = small.back(), l = large.back();
+		small.pop_back();
+		m_alias[s] = l;
+		m_probability[l] -= 1.0f - m_probability[s];
+		if (m_probability[l] < 1.0f)
+		{
+			large.pop_back();
+			small.push_back(l);
+		}
+	}
+	//leftovers differ from 1 only by rounding errors
+	for (auto i : small)
+		m_probability[i] = 1.0f;
+	for (auto i : large)
+		m_probability[i] = 1.0f;
+}
+
+shared_ptr<const MeshSurfaceSampler> MeshSurfaceSampler::FromFile(const wstring& meshPath)
+{
+	static mutex cacheMutex;
+	static map<wstring, weak_ptr<const MeshSurfaceSampler>> cache;
+	lock_guard<mutex> lock(cacheMutex);
+	auto& entry = cache[meshPath];
+	auto sampler = entry.lock();
+	if (!sampler)
+	{
+		sampler = make_shared<const MeshSurfaceSampler>(MeshData::Load(meshPath));
+		entry = sampler;
+	}
+	return sampler;
+}
+
+MeshSurfaceSampler::SurfacePoint MeshSurfaceSampler::Sample(float u0, float u1, float u2, float u3) const
+{
+	SurfacePoint p{};
+	if (m_triangles.empty())
+		return p;
+	auto n = m_triangles.size();
+	auto i = min(static_cast<size_t>(u0 * n), n - 1);
+	auto& t = m_triangles[u1 < m_probability[i] ? i : m_alias[i]];
+	//folding the unit square onto the triangle keeps the distribution uniform
+	if (u2 + u3 > 1.0f)
+	{
+		u2 = 1.0f - u2;
+		u3 = 1.0f - u3;
+	}
+	auto pos = XMVectorAdd(XMLoadFloat3(&t.P0), XMVectorAdd(XMVectorScale(XMLoadFloat3(&t.E1), u2), XMVectorScale(XMLoadFloat3(&t.E2), u3)));
+	auto normal = XMVectorAdd(XMVectorScale(XMLoadFloat3(&t.N0), 1.0f - u2 - u3),
+		XMVectorAdd(XMVectorScale(XMLoadFloat3(&t.N1), u2), XMVectorScale(XMLoadFloat3(&t.N2), u3)));
+	XMStoreFloat3(&p.Position, pos);
+	XMStoreFloat3(&p.Normal, XMVector3Normalize(normal));
+	return p;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "meshData.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Draws uniformly distributed points on the surface of a triangle mesh.
+		//A triangle is chosen with probability proportional to its area in O(1) using Walker's alias table,
+		//then a point inside it is chosen with uniform barycentric coordinates.
+		class MeshSurfaceSampler
+		{
+		public:
+			struct SurfacePoint
+			{
+				DirectX::XMFLOAT3 Position;
+				DirectX::XMFLOAT3 Normal;	//vertex normals interpolated at Position
+			};
+
+			explicit MeshSurfaceSampler(const MeshData& mesh);
+
+			//Sampler of a .mesh file, built on first use and shared while anything references it
+			static std::shared_ptr<const MeshSurfaceSampler> FromFile(const std::wstring& meshPath);
+
+			template<typename Random>
+			SurfacePoint Sample(Random& random) const
+			{
+				std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+				return Sample(dist(random), dist(random), dist(random), dist(random));
+			}
+			//Deterministic variant for four uniform numbers from [0,1)
+			SurfacePoint Sample(float u0, float u1, float u2, float u3) const;
+
+			float area() const { return m_area; }
+			size_t trianglesCount() const { return m_probability.size(); }
+
+		private:
+			struct Triangle
+			{
+				DirectX::XMFLOAT3 P0, E1, E2;	//first vertex and edges to the other two
+				DirectX::XMFLOAT3 N0, N1, N2;
+			};
+
+			std::vector<Triangle> m_triangles;
+			std::vector<float> m_probability;	//probability of keeping the triangle chosen uniformly
+			std::vector<uint32_t> m_alias;		//triangle taken instead otherwise
+			float m_area;
+		};
+	}
+}
@@ -0,0 +1,228 @@
+#include "motionPlanner.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+const size_t MotionPlanner::CHECK_CHUNK = 256;
+
+namespace
+{
+	float Distance(const PumaAngles& a, const PumaAngles& b)
+	{
+		auto sum = 0.0f;
+		for (size_t j = 0; j < a.size(); ++j)
+			sum += (b[j] - a[j]) * (b[j] - a[j]);
+		return sqrtf(sum);
+	}
+
+	PumaAngles Lerp(const PumaAngles& a, const PumaAngles& b, float t)
+	{
+		PumaAngles r;
+		for (size_t j = 0; j < a.size(); ++j)
+			r[j] = a[j] + (b[j] - a[j]) * t;
+		return r;
+	}
+
+	float Length(const vector<PumaAngles>& path)
+	{
+		auto length = 0.0f;
+		for (size_t i = 1; i < path.size(); ++i)
+			length += Distance(path[i - 1], path[i]);
+		return length;
+	}
+}
+
+void MotionPlanner::Tree::Reset(const PumaAngles& root)
+{
+	Points.Clear();
+	Parents.clear();
+	Add(root, -1);
+}
+
+int MotionPlanner::Tree::Add(const PumaAngles& point, int parent)
+{
+	Parents.push_back(parent);
+	return static_cast<int>(Points.Insert(point));
+}
+
+MotionPlanner::MotionPlanner(const PumaCollision& collision)
+	: MotionPlanner(collision, Settings())
+{ }
+
+MotionPlanner::MotionPlanner(const PumaCollision& collision, const Settings& settings)
+	: m_collision(collision), m_settings(settings), m_random(DEFAULT_SEED)
+{
+	for (auto& r : m_ranges)
+		r = { -XM_PI, XM_PI };
+}
+
+size_t MotionPlanner::EdgeSamples(const PumaAngles& a, const PumaAngles& b) const
+{
+	return max<size_t>(1, static_cast<size_t>(ceilf(Distance(a, b) / m_settings.Resolution)));
+}
+
+size_t MotionPlanner::FreeSamples(const PumaAngles& a, const PumaAngles& b, size_t samples, MotionPlannerStats& stats)
+{
+	//chunks stop the test soon after the first collision, while long edges still keep all threads busy
+	for (size_t first = 0; first < samples; first += CHECK_CHUNK)
+	{
+		auto count = min(CHECK_CHUNK, samples - first);
+		m_edge.resize(count);
+		m_collides.resize(count);
+		for (size_t i = 0; i < count; ++i)
+			m_edge[i] = Lerp(a, b, static_cast<float>(first + i + 1) / samples);
+		stats.tested += count;
+		if (m_collision.CollidingLinksBatch(count, m_edge.data(), m_collides.data(), m_settings.Links))
+			return first + (find_if(m_collides.begin(), m_collides.end(), [](uint8_t c) { return c != 0; }) - m_collides.begin());
+	}
+	return samples;
+}
+
+int MotionPlanner::Extend(Tree& tree, const PumaAngles& target, MotionPlannerStats& stats)
+{
+	auto nearest = static_cast<int>(tree.Points.Nearest(target));
+	auto from = tree.Points.point(nearest);
+	auto distance = Distance(from, target);
+	auto to = distance > m_settings.StepSize ? Lerp(from, target, m_settings.StepSize / distance) : target;
+	auto samples = EdgeSamples(from, to);
+	if (FreeSamples(from, to, samples, stats) < samples)
+		return -1;
+	return tree.Add(to, nearest);
+}
+
+bool MotionPlanner::Connect(Tree& tree, const PumaAngles& target, int& node, MotionPlannerStats& stats)
+{
+	node = static_cast<int>(tree.Points.Nearest(target));
+	auto from = tree.Points.point(node);
+	auto samples = EdgeSamples(from, target);
+	auto free = FreeSamples(from, target, samples, stats);
+	//nodes every StepSize along the free part, the target itself belongs to the other tree
+	auto stride = max<size_t>(1, static_cast<size_t>(m_settings.StepSize / m_settings.Resolution));
+	for (auto s = stride; s <= free && s < samples; s += stride)
+		node = tree.Add(Lerp(from, target, static_cast<float>(s) / samples), node);
+	return free == samples;
+}
+
+bool MotionPlanner::Plan(const PumaAngles& start, const PumaAngles& goal, vector<PumaAngles>& path,
+	MotionPlannerStats* stats)
+{
+	MotionPlannerStats local;
+	++local.queries;
+	path.clear();
+	local.tested += 2;
+	if (m_collision.CollidingLinks(start, m_settings.Links) || m_collision.CollidingLinks(goal, m_settings.Links))
+	{
+		if (stats)
+			stats->Add(local);
+		return false;
+	}
+
+	m_trees[0].Reset(start);
+	m_trees[1].Reset(goal);
+	array<uniform_real_distribution<float>, PumaKinematics::JOINTS_COUNT> sample;
+	for (size_t j = 0; j < sample.size(); ++j)
+		sample[j] = uniform_real_distribution<float>(m_ranges[j].Min, m_ranges[j].Max);
+	//the straight edge is tried first, so easy queries don't grow trees at all
+	auto samples = EdgeSamples(start, goal);
+	auto solved = FreeSamples(start, goal, samples, local) == samples;
+	if (solved)
+		path = { start, goal };
+	int connection;
+	for (auto iteration = 0U; !solved && iteration < m_settings.MaxIterations; ++iteration)
+	{
+		++local.iterations;
+		auto grown = iteration & 1;
+		PumaAngles q;
+		for (size_t j = 0; j < q.size(); ++j)
+			q[j] = sample[j](m_random);
+		auto node = Extend(m_trees[grown], q, local);
+		if (node < 0)
+			continue;
+		auto& other = m_trees[1 - grown];
+		if (Connect(other, m_trees[grown].Points.point(node), connection, local))
+		{
+			solved = true;
+			//the path runs through the new node of the grown tree and the connection of the other one
+			for (auto n = grown == 0 ? node : connection; n >= 0; n = m_trees[0].Parents[n])
+				path.push_back(m_trees[0].Points.point(n));
+			reverse(path.begin(), path.end());
+			for (auto n = grown == 0 ? connection : node; n >= 0; n = m_trees[1].Parents[n])
+				path.push_back(m_trees[1].Points.point(n));
+		}
+	}
+	local.nodes += m_trees[0].Points.size() + m_trees[1].Points.size();
+	if (solved)
+	{
+		++local.solved;
+		local.rawLength += Length(path);
+		Shortcut(path, local);
+		local.length += Length(path);
+	}
+	if (stats)
+		stats->Add(local);
+	return solved;
+}
+
+void MotionPlanner::Shortcut(vector<PumaAngles>& path, MotionPlannerStats& stats)
+{
+	vector<float> along(path.size());
+	auto measure = [&]
+	{
+		along.resize(path.size());
+		along[0] = 0.0f;
+		for (size_t i = 1; i < path.size(); ++i)
+			along[i] = along[i - 1] + Distance(path[i - 1], path[i]);
+	};
+	//point at distance s along the path and the index of its edge
+	auto at = [&](float s, size_t& edge)
+	{
+		edge = min<size_t>(upper_bound(along.begin(), along.end(), s) - along.begin(), path.size() - 1) - 1;
+		auto span = along[edge + 1] - along[edge];
+		return Lerp(path[edge], path[edge + 1], span > 0.0f ? (s - along[edge]) / span : 0.0f);
+	};
+	measure();
+	for (auto attempt = 0U; attempt < m_settings.ShortcutAttempts && path.size() > 2; ++attempt)
+	{
+		uniform_real_distribution<float> position(0.0f, along.back());
+		auto s0 = position(m_random), s1 = position(m_random);
+		if (s0 > s1)
+			swap(s0, s1);
+		size_t e0, e1;
+		auto p0 = at(s0, e0), p1 = at(s1, e1);
+		//points on one edge are already joined by a straight line
+		if (e0 == e1)
+			continue;
+		auto samples = EdgeSamples(p0, p1);
+		if (FreeSamples(p0, p1, samples, stats) < samples)
+			continue;
+		//edge e0 ends at p0, then p1 starts what is left of edge e1
+		path.erase(path.begin() + e0 + 1, path.begin() + e1 + 1);
+		path.insert(path.begin() + e0 + 1, { p0, p1 });
+		measure();
+		++stats.shortcuts;
+	}
+	//shortcuts ending at waypoints leave zero length edges
+	path.erase(unique(path.begin(), path.end()), path.end());
+}
+
+JointTrajectory MotionPlanner::Timed(const vector<PumaAngles>& path, const PathParameterization& timing) const
+{
+	vector<PumaAngles> samples;
+	if (!path.empty())
+		samples.push_back(path.front());
+	for (size_t i = 1; i < path.size(); ++i)
+	{
+		auto count = EdgeSamples(path[i - 1], path[i]);
+		for (size_t s = 1; s <= count; ++s)
+			samples.push_back(Lerp(path[i - 1], path[i], static_cast<float>(s) / count));
+	}
+	auto times = timing.Solve(samples);
+	JointTrajectory trajectory;
+	for (size_t i = 0; i < samples.size(); ++i)
+		trajectory.Append(times[i], samples[i]);
+	return trajectory;
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <array>
+#include <random>
+#include <vector>
+#include "dampedIK.h"
+#include "jointKdTree.h"
+#include "jointTrajectory.h"
+#include "pathParameterization.h"
+#include "pumaCollision.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Counters of MotionPlanner queries
+		struct MotionPlannerStats
+		{
+			size_t queries;
+			size_t solved;
+			size_t iterations;	//total over all queries
+			size_t nodes;		//tree nodes of both trees, total over all queries
+			size_t tested;		//configurations tested for collisions
+			size_t shortcuts;	//successful shortcuts of solved paths
+			float rawLength;	//joint space length of solved paths before shortcuts, summed
+			float length;		//and after them
+
+			MotionPlannerStats() : queries(0), solved(0), iterations(0), nodes(0), tested(0), shortcuts(0),
+				rawLength(0.0f), length(0.0f) { }
+
+			float successRate() const { return queries ? static_cast<float>(solved) / queries : 0.0f; }
+
+			void Add(const MotionPlannerStats& other)
+			{
+				queries += other.queries;
+				solved += other.solved;
+				iterations += other.iterations;
+				nodes += other.nodes;
+				tested += other.tested;
+				shortcuts += other.shortcuts;
+				rawLength += other.rawLength;
+				length += other.length;
+			}
+		};
+
+		//Collision-free joint space paths of the PUMA arm between two poses (RRT-Connect, Kuffner and LaValle).
+		//A tree grows from each end: one of them extends by at most StepSize towards a random sample, the other
+		//one then tries to connect straight to the new node, and they swap roles. Nearest nodes are found with
+		//k-d trees. Edges are tested every Resolution radians with PumaCollision, in chunks split between threads,
+		//so long connections and shortcuts are tested in parallel. The path found is shortened by random shortcuts.
+		//All random choices come from one engine, so a sequence of queries after Seed is reproducible.
+		class MotionPlanner
+		{
+		public:
+			struct Settings
+			{
+				unsigned int MaxIterations = 4000;
+				float StepSize = 0.3f;					//longest extension towards a sample, in joint space
+				float Resolution = 0.02f;				//spacing of configurations tested along edges
+				unsigned int ShortcutAttempts = 64;
+				unsigned int Links = PumaCollision::ALL_LINKS;	//mask of links tested for collisions
+			};
+
+			static const unsigned int DEFAULT_SEED = 1;
+
+			explicit MotionPlanner(const PumaCollision& collision);
+			MotionPlanner(const PumaCollision& collision, const Settings& settings);
+
+			void Seed(unsigned int seed) { m_random.seed(seed); }
+			//Ranges random samples are drawn from, [-pi, pi] for all joints by default
+			void SetRanges(const std::array<JointRange, PumaKinematics::JOINTS_COUNT>& ranges) { m_ranges = ranges; }
+
+			//Waypoints from start to goal joined by straight joint space edges. Returns false if start or goal
+			//collides or no path is found in MaxIterations; path is empty then. stats may be null.
+			bool Plan(const PumaAngles& start, const PumaAngles& goal, std::vector<PumaAngles>& path,
+				MotionPlannerStats* stats = nullptr);
+			//Waypoints sampled every Resolution and timed for the fastest motion within limits
+			JointTrajectory Timed(const std::vector<PumaAngles>& path, const PathParameterization& timing) const;
+
+			const Settings& settings() const { return m_settings; }
+
+		private:
+			static const size_t CHECK_CHUNK;	//configurations of an edge tested at once
+
+			struct Tree
+			{
+				JointKdTree Points;
+				std::vector<int> Parents;	//-1 for the root
+
+				void Reset(const PumaAngles& root);
+				int Add(const PumaAngles& point, int parent);
+			};
+
+			const PumaCollision& m_collision;
+			Settings m_settings;
+			std::array<JointRange, PumaKinematics::JOINTS_COUNT> m_ranges;
+			std::mt19937 m_random;
+			Tree m_trees[2];	//grown from the start and from the goal
+			std::vector<PumaAngles> m_edge;
+			std::vector<uint8_t> m_collides;
+
+			//Number of configurations tested on the edge from a to b, not counting a
+			size_t EdgeSamples(const PumaAngles& a, const PumaAngles& b) const;
+			//Leading configurations of the edge from a to b out of samples that don't collide
+			size_t FreeSamples(const PumaAngles& a, const PumaAngles& b, size_t samples, MotionPlannerStats& stats);
+			//Index of the node added towards target, -1 if the edge to it collides
+			int Extend(Tree& tree, const PumaAngles& target, MotionPlannerStats& stats);
+			//Adds nodes along the edge from the nearest node to target as far as it's free. Returns true if
+			//target is reached; node receives the last node added, or the nearest one.
+			bool Connect(Tree& tree, const PumaAngles& target, int& node, MotionPlannerStats& stats);
+			void Shortcut(std::vector<PumaAngles>& path, MotionPlannerStats& stats);
+		};
+	}
+}
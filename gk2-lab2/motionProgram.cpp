@@ -0,0 +1,285 @@
+#include "motionProgram.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include "pumaIKCache.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+const float MotionCompiler::MAX_GAP = 1e-4f;
+
+namespace
+{
+	//tool moves shorter than this only turn the tool, so they're compiled as joint moves
+	const float MIN_PATH_LENGTH = 1e-4f;
+	//normals closer to opposite than this can't be interpolated along a path
+	const float MIN_NORMAL_DOT = -0.9f;
+
+	bool ParseNumber(const string& token, float& value)
+	{
+		char* end;
+		value = strtof(token.c_str(), &end);
+		return !token.empty() && *end == '\0' && isfinite(value);
+	}
+
+	XMFLOAT3 Vector(const vector<float>& args, size_t first)
+	{
+		return XMFLOAT3(args[first], args[first + 1], args[first + 2]);
+	}
+
+	bool Normalize(XMFLOAT3& normal)
+	{
+		auto n = XMLoadFloat3(&normal);
+		if (XMVectorGetX(XMVector3LengthSq(n)) < 1e-12f)
+			return false;
+		XMStoreFloat3(&normal, XMVector3Normalize(n));
+		return true;
+	}
+
+	float Dot(XMFLOAT3 a, XMFLOAT3 b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	//Appends keys of segment after the end of trajectory; the first key repeats the last one of trajectory
+	void AppendKeys(JointTrajectory& trajectory, const JointTrajectory& segment)
+	{
+		auto offset = trajectory.duration();
+		for (size_t k = trajectory.empty() ? 0 : 1; k < segment.keysCount(); ++k)
+			trajectory.Append(offset + segment.times()[k], segment.angles()[k]);
+	}
+
+	float LargestGap(const PumaAngles& a, const PumaAngles& b)
+	{
+		auto gap = 0.0f;
+		for (size_t j = 0; j < a.size(); ++j)
+			gap = max(gap, fabsf(a[j] - b[j]));
+		return gap;
+	}
+}
+
+unsigned int MotionProgram::LineAt(float time) const
+{
+	if (m_segments.empty())
+		return 0;
+	auto next = upper_bound(m_segments.begin(), m_segments.end(), time,
+		[](float t, const MotionSegment& s) { return t < s.Start; });
+	return next == m_segments.begin() ? m_segments.front().Line : prev(next)->Line;
+}
+
+MotionCompiler::MotionCompiler(const JointLimits& limits)
+	: m_timing(limits)
+{ }
+
+bool MotionCompiler::Parse(const string& source, vector<Command>& commands, vector<MotionProgramError>& errors)
+{
+	struct Syntax
+	{
+		const char* Keyword;
+		Opcode Op;
+		size_t MinArgs, MaxArgs;
+	};
+	//MOVEJ is told apart by the number of arguments
+	static const Syntax SYNTAX[] = {
+		{ "MOVEJ", Opcode::MoveJoints, 5, 5 },
+		{ "MOVEJ", Opcode::MovePose, 6, 6 },
+		{ "MOVEL", Opcode::MoveLine, 3, 6 },
+		{ "CIRC", Opcode::MoveArc, 6, 9 },
+		{ "WAIT", Opcode::Wait, 1, 1 },
+		{ "SPEED", Opcode::Speed, 1, 1 }
+	};
+
+	auto errorsCount = errors.size();
+	istringstream input(source);
+	string text;
+	for (auto line = 1U; getline(input, text); ++line)
+	{
+		text = text.substr(0, text.find('#'));
+		istringstream tokens(text);
+		string keyword;
+		if (!(tokens >> keyword))
+			continue;
+		transform(keyword.begin(), keyword.end(), keyword.begin(), [](unsigned char c) { return static_cast<char>(toupper(c)); });
+		Command command{ Opcode::Wait, line, {} };
+		string token;
+		auto numbers = true;
+		while (tokens >> token)
+		{
+			float value;
+			if (!ParseNumber(token, value))
+			{
+				errors.push_back({ line, "'" + token + "' is not a number" });
+				numbers = false;
+				break;
+			}
+			command.Args.push_back(value);
+		}
+		if (!numbers)
+			continue;
+		auto known = false, matched = false;
+		for (auto& syntax : SYNTAX)
+		{
+			if (keyword != syntax.Keyword)
+				continue;
+			known = true;
+			//optional arguments come in triples
+			auto extra = command.Args.size() - syntax.MinArgs;
+			if (command.Args.size() >= syntax.MinArgs && command.Args.size() <= syntax.MaxArgs && extra % 3 == 0)
+			{
+				command.Op = syntax.Op;
+				matched = true;
+				break;
+			}
+		}
+		if (!known)
+			errors.push_back({ line, "unknown command '" + keyword + "'" });
+		else if (!matched)
+			errors.push_back({ line, keyword + " can't take " + to_string(command.Args.size()) + " arguments" });
+		else if ((command.Op == Opcode::Wait || command.Op == Opcode::Speed) && command.Args[0] < 0.0f)
+			errors.push_back({ line, keyword + " must not be negative" });
+		else
+			commands.push_back(move(command));
+	}
+	return errors.size() == errorsCount;
+}
+
+bool MotionCompiler::MoveTool(const Command& command, float speed, PumaAngles& current, vector<JointTrajectory>& moves,
+	vector<MotionProgramError>& errors) const
+{
+	auto& args = command.Args;
+	XMFLOAT3 from, fromNormal;
+	PumaKinematics::EndEffector(current, from, fromNormal);
+	auto targetArg = command.Op == Opcode::MoveArc ? 3U : 0U;
+	auto target = Vector(args, targetArg);
+	auto normal = args.size() > targetArg + 3 ? Vector(args, targetArg + 3) : fromNormal;
+	if (!Normalize(normal))
+	{
+		errors.push_back({ command.Line, "normal must not be zero" });
+		return true;
+	}
+	PumaIKCache ik;
+	auto length = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&target), XMLoadFloat3(&from))));
+	if (command.Op == Opcode::MovePose || (command.Op == Opcode::MoveLine && length < MIN_PATH_LENGTH))
+	{
+		PumaAngles angles;
+		if (!ik.Solve(target, normal, current, angles))
+		{
+			errors.push_back({ command.Line, "target out of reach" });
+			return false;
+		}
+		moves.push_back(m_timing.Retime(JointTrajectory::JointMove(current, angles, 1.0f)));
+		current = angles;
+		return true;
+	}
+	if (Dot(normal, fromNormal) < MIN_NORMAL_DOT)
+	{
+		errors.push_back({ command.Line, "tool can't turn around along a path, turn it with MOVEJ first" });
+		return true;
+	}
+
+	unique_ptr<CartesianPath> path;
+	if (command.Op == Opcode::MoveLine)
+		path = make_unique<LinePath>(from, target, fromNormal, normal);
+	else
+	{
+		auto via = Vector(args, 0);
+		if (ArcPath::Collinear(from, via, target))
+		{
+			errors.push_back({ command.Line, "arc points are collinear" });
+			return true;
+		}
+		path = make_unique<ArcPath>(from, via, target, fromNormal, normal);
+	}
+	JointTrajectory move;
+	float failedAt = 0.0f;
+	auto planned = speed > 0.0f ? m_planner.Plan(*path, path->length() / speed, current, move, &failedAt)
+		: m_planner.Plan(*path, m_timing, current, move, &failedAt);
+	if (planned)
+	{
+		moves.push_back(move);
+		current = move.angles().back();
+		return true;
+	}
+	//later commands are still checked if the arm can get to the end of the path some other way
+	PumaAngles angles;
+	if (!ik.Solve(target, normal, current, angles))
+	{
+		errors.push_back({ command.Line, "target out of reach" });
+		return false;
+	}
+	ostringstream message;
+	message << "path can't be followed from " << lroundf(failedAt * 100.0f) << "% of the way";
+	errors.push_back({ command.Line, message.str() });
+	current = angles;
+	return true;
+}
+
+bool MotionCompiler::Compile(const string& source, const PumaAngles& start, MotionProgram& program,
+	vector<MotionProgramError>& errors) const
+{
+	vector<Command> commands;
+	if (!Parse(source, commands, errors))
+		return false;
+
+	auto errorsCount = errors.size();
+	MotionProgram result;
+	auto& trajectory = result.m_trajectory;
+	auto current = start;
+	auto speed = 0.0f;
+	vector<JointTrajectory> moves;
+	for (auto& command : commands)
+	{
+		moves.clear();
+		auto reachable = true;
+		switch (command.Op)
+		{
+		case Opcode::Speed:
+			speed = command.Args[0];
+			break;
+		case Opcode::Wait:
+		{
+			JointTrajectory wait;
+			wait.Append(0.0f, current);
+			wait.Append(command.Args[0], current);
+			moves.push_back(wait);
+			break;
+		}
+		case Opcode::MoveJoints:
+		{
+			PumaAngles target;
+			for (size_t j = 0; j < target.size(); ++j)
+				target[j] = XMConvertToRadians(command.Args[j]);
+			moves.push_back(m_timing.Retime(JointTrajectory::JointMove(current, target, 1.0f)));
+			current = target;
+			break;
+		}
+		default:
+			reachable = MoveTool(command, speed, current, moves, errors);
+			break;
+		}
+		//the configuration after a target out of reach is unknown, so the rest can't be planned
+		if (!reachable)
+			break;
+		if (moves.empty())
+			continue;
+
+		result.m_segments.push_back({ command.Line, trajectory.duration() });
+		for (auto& segment : moves)
+		{
+			auto end = trajectory.empty() ? start : trajectory.angles().back();
+			//the planner may start a path in another turn of the roll or wrist, the arm is brought there first
+			if (LargestGap(end, segment.angles().front()) > MAX_GAP)
+				AppendKeys(trajectory, m_timing.Retime(JointTrajectory::JointMove(end, segment.angles().front(), 1.0f)));
+			AppendKeys(trajectory, segment);
+		}
+	}
+	if (errors.size() != errorsCount)
+		return false;
+	program = move(result);
+	return true;
+}
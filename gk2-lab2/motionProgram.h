@@ -0,0 +1,100 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "jointTrajectory.h"
+#include "pathParameterization.h"
+#include "trajectoryPlanner.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		struct MotionProgramError
+		{
+			unsigned int Line;	//1-based line of the source
+			std::string Message;
+		};
+
+		//Command of the source starting at a time of the compiled trajectory
+		struct MotionSegment
+		{
+			unsigned int Line;
+			float Start;
+		};
+
+		//Motion program compiled to a single joint trajectory, so playing it back only interpolates keys
+		class MotionProgram
+		{
+		public:
+			const JointTrajectory& trajectory() const { return m_trajectory; }
+			const std::vector<MotionSegment>& segments() const { return m_segments; }
+			float duration() const { return m_trajectory.duration(); }
+
+			//Source line of the command executed at time, 0 if the program is empty
+			unsigned int LineAt(float time) const;
+
+		private:
+			friend class MotionCompiler;
+
+			JointTrajectory m_trajectory;
+			std::vector<MotionSegment> m_segments;
+		};
+
+		//Compiles robot motion scripts ahead of time. One command per line, # starts a comment, keywords
+		//are case insensitive. Lengths are in meters, joint angles in degrees, times in seconds; normals are
+		//normals of the touched surface, i.e. reversed tool directions (see PumaKinematics).
+		//	MOVEJ a0 a1 a2 a3 a4			joint move to the angles
+		//	MOVEJ x y z nx ny nz			joint move to the configuration closest to the current one reaching the pose
+		//	MOVEL x y z [nx ny nz]			straight tool move, keeping the current normal if none is given
+		//	CIRC vx vy vz x y z [nx ny nz]	tool move along the arc through the via point to the end point
+		//	WAIT t							stays still
+		//	SPEED v							tool speed of the following MOVEL and CIRC, 0 to move as fast as
+		//									joint limits allow (the default)
+		//Joint moves always run as fast as joint limits allow. All IK and timing happens in Compile, which
+		//reports syntax errors of all lines, then targets and paths out of reach.
+		class MotionCompiler
+		{
+		public:
+			explicit MotionCompiler(const JointLimits& limits = JointLimits::Puma());
+
+			//Tool paths with samples the map rules out fail before running IK; null disables the check
+			void SetReachability(std::shared_ptr<const ReachabilityMap> map) { m_planner.SetReachability(std::move(map)); }
+
+			//Program starting at start. Returns false and fills errors if the source has errors; planning stops
+			//at the first target out of reach, since the arm's configuration after it is unknown.
+			bool Compile(const std::string& source, const PumaAngles& start, MotionProgram& program,
+				std::vector<MotionProgramError>& errors) const;
+
+		private:
+			enum class Opcode
+			{
+				MoveJoints,
+				MovePose,
+				MoveLine,
+				MoveArc,
+				Wait,
+				Speed
+			};
+
+			struct Command
+			{
+				Opcode Op;
+				unsigned int Line;
+				std::vector<float> Args;
+			};
+
+			static const float MAX_GAP;	//largest joint difference between segments left without a joint move
+
+			TrajectoryPlanner m_planner;
+			PathParameterization m_timing;
+
+			static bool Parse(const std::string& source, std::vector<Command>& commands, std::vector<MotionProgramError>& errors);
+			//MOVEJ to a pose, MOVEL or CIRC from current; moves receive the motion and current its end. Paths that
+			//can't be followed are reported, and current moves to their end if it's reachable some other way.
+			//Returns false if the target is out of reach.
+			bool MoveTool(const Command& command, float speed, PumaAngles& current, std::vector<JointTrajectory>& moves,
+				std::vector<MotionProgramError>& errors) const;
+		};
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace mini
+{
+	//Number of worker threads used by ParallelFor
+	inline unsigned int ParallelThreadsCount()
+	{
+		//querying the system is slow on some platforms and nested loops ask often
+		static const unsigned int count = std::max(std::thread::hardware_concurrency(), 1U);
+		return count;
+	}
+
+	//Splits [0, count) into contiguous ranges and calls f(begin, end) for each of them on a separate thread.
+	//Returns after all ranges are processed. f must be safe to call concurrently for disjoint ranges.
+	template<typename F>
+	void ParallelFor(size_t count, F&& f, size_t minRange = 1)
+	{
+		auto threads = std::min<size_t>(ParallelThreadsCount(), (count + minRange - 1) / std::max<size_t>(minRange, 1));
+		if (threads <= 1)
+		{
+			if (count > 0)
+				f(size_t(0), count);
+			return;
+		}
+		std::vector<std::thread> workers;
+		workers.reserve(threads - 1);
+		auto range = (count + threads - 1) / threads;
+		for (size_t t = 1; t < threads; ++t)
+		{
+			auto begin = t * range, end = std::min(count, begin + range);
+			if (begin < end)
+				workers.emplace_back([&f, begin, end] { f(begin, end); });
+		}
+		f(size_t(0), std::min(count, range));
+		for (auto& w : workers)
+			w.join();
+	}
+}
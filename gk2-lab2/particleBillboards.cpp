@@ -0,0 +1,116 @@
+#include "particleBillboards.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	//Corners in the order emitted by particleGS.hlsl triangle strip
+	const XMFLOAT2 CORNER_TEX[4] = { { 0.0f, 1.0f }, { 1.0f, 1.0f }, { 0.0f, 0.0f }, { 1.0f, 0.0f } };
+}
+
+void ParticleBillboards::ExpandScalar(const vector<ParticleVertex>& particles, FXMMATRIX viewMtx,
+	float timeToLive, vector<ParticleQuadVertex>& quads)
+{
+	quads.resize(particles.size() * VERTS_PER_QUAD);
+	auto o = quads.begin();
+	for (auto& p : particles)
+	{
+		XMFLOAT3 pos;
+		XMStoreFloat3(&pos, XMVector3TransformCoord(XMLoadFloat3(&p.Pos), viewMtx));
+		float sina, cosa;
+		XMScalarSinCos(&sina, &cosa, p.Angle);
+		auto dx = (cosa - sina) * 0.5f * p.Size;
+		auto dy = (cosa + sina) * 0.5f * p.Size;
+		const XMFLOAT2 offsets[4] = { { -dx, -dy }, { -dy, dx }, { dy, -dx }, { dx, dy } };
+		for (auto i = 0U; i < VERTS_PER_QUAD; ++i, ++o)
+		{
+			o->Pos = XMFLOAT3(pos.x + offsets[i].x, pos.y + offsets[i].y, pos.z);
+			o->Tex1 = CORNER_TEX[i];
+			o->Tex2 = XMFLOAT2(p.Age / timeToLive, 0.5f);
+		}
+	}
+}
+
+void ParticleBillboards::Expand(const vector<ParticleVertex>& particles, FXMMATRIX viewMtx,
+	float timeToLive, vector<ParticleQuadVertex>& quads)
+{
+	quads.resize(particles.size() * VERTS_PER_QUAD);
+	XMFLOAT4X4 v;
+	XMStoreFloat4x4(&v, viewMtx);
+	const auto half = XMVectorReplicate(0.5f);
+	const auto invTtl = XMVectorReplicate(1.0f / timeToLive);
+
+	auto n = particles.size();
+	auto full = n & ~size_t(3);
+	auto o = quads.data();
+	for (size_t i = 0; i < n; i += 4)
+	{
+		//gather four particles into SoA registers; the last group is padded with its first particle
+		const ParticleVertex* p[4];
+		for (auto k = 0U; k < 4U; ++k)
+			p[k] = &particles[i + k < n ? i + k : i];
+		auto x = XMVectorSet(p[0]->Pos.x, p[1]->Pos.x, p[2]->Pos.x, p[3]->Pos.x);
+		auto y = XMVectorSet(p[0]->Pos.y, p[1]->Pos.y, p[2]->Pos.y, p[3]->Pos.y);
+		auto z = XMVectorSet(p[0]->Pos.z, p[1]->Pos.z, p[2]->Pos.z, p[3]->Pos.z);
+		auto angle = XMVectorSet(p[0]->Angle, p[1]->Angle, p[2]->Angle, p[3]->Angle);
+		auto size = XMVectorSet(p[0]->Size, p[1]->Size, p[2]->Size, p[3]->Size);
+		auto age = XMVectorSet(p[0]->Age, p[1]->Age, p[2]->Age, p[3]->Age);
+
+		//view matrix is affine, so w stays 1
+		auto vx = XMVectorMultiplyAdd(x, XMVectorReplicate(v._11), XMVectorMultiplyAdd(y, XMVectorReplicate(v._21),
+			XMVectorMultiplyAdd(z, XMVectorReplicate(v._31), XMVectorReplicate(v._41))));
+		auto vy = XMVectorMultiplyAdd(x, XMVectorReplicate(v._12), XMVectorMultiplyAdd(y, XMVectorReplicate(v._22),
+			XMVectorMultiplyAdd(z, XMVectorReplicate(v._32), XMVectorReplicate(v._42))));
+		auto vz = XMVectorMultiplyAdd(x, XMVectorReplicate(v._13), XMVectorMultiplyAdd(y, XMVectorReplicate(v._23),
+			XMVectorMultiplyAdd(z, XMVectorReplicate(v._33), XMVectorReplicate(v._43))));
+
+		XMVECTOR sina, cosa;
+		XMVectorSinCos(&sina, &cosa, angle);
+		auto hs = XMVectorMultiply(size, half);
+		auto dx = XMVectorMultiply(XMVectorSubtract(cosa, sina), hs);
+		auto dy = XMVectorMultiply(XMVectorAdd(cosa, sina), hs);
+		auto tex = XMVectorMultiply(age, invTtl);
+
+		//corner positions in SoA form, same order as CORNER_TEX
+		const XMVECTOR cx[4] = { XMVectorSubtract(vx, dx), XMVectorSubtract(vx, dy), XMVectorAdd(vx, dy), XMVectorAdd(vx, dx) };
+		const XMVECTOR cy[4] = { XMVectorSubtract(vy, dy), XMVectorAdd(vy, dx), XMVectorSubtract(vy, dx), XMVectorAdd(vy, dy) };
+		XMFLOAT4A fx[4], fy[4], fz, ft;
+		for (auto c = 0U; c < 4U; ++c)
+		{
+			XMStoreFloat4A(&fx[c], cx[c]);
+			XMStoreFloat4A(&fy[c], cy[c]);
+		}
+		XMStoreFloat4A(&fz, vz);
+		XMStoreFloat4A(&ft, tex);
+
+		auto count = i < full ? 4U : static_cast<unsigned int>(n - i);
+		for (auto k = 0U; k < count; ++k)
+			for (auto c = 0U; c < 4U; ++c, ++o)
+			{
+				o->Pos = XMFLOAT3((&fx[c].x)[k], (&fy[c].x)[k], (&fz.x)[k]);
+				o->Tex1 = CORNER_TEX[c];
+				o->Tex2 = XMFLOAT2((&ft.x)[k], 0.5f);
+			}
+	}
+}
+
+vector<unsigned int> ParticleBillboards::QuadIndices(size_t quadsCount)
+{
+	//the strip 0,1,2,3 from the geometry shader as two triangles with the same winding
+	vector<unsigned int> indices(quadsCount * INDICES_PER_QUAD);
+	auto k = 0U;
+	for (auto i = 0U; i < quadsCount; ++i)
+	{
+		auto b = i * VERTS_PER_QUAD;
+		indices[k++] = b;
+		indices[k++] = b + 1;
+		indices[k++] = b + 2;
+		indices[k++] = b + 2;
+		indices[k++] = b + 1;
+		indices[k++] = b + 3;
+	}
+	return indices;
+}
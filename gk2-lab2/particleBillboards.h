@@ -0,0 +1,40 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include "particleSystem.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Corner of an expanded particle quad, position in view space
+		struct ParticleQuadVertex
+		{
+			DirectX::XMFLOAT3 Pos;
+			DirectX::XMFLOAT2 Tex1;	//billboard texture coordinates
+			DirectX::XMFLOAT2 Tex2;	//(age / time to live, 0.5) for the opacity lookup
+			static const D3D11_INPUT_ELEMENT_DESC Layout[3];
+
+			ParticleQuadVertex() : Pos(0.0f, 0.0f, 0.0f), Tex1(0.0f, 0.0f), Tex2(0.0f, 0.0f) { }
+		};
+
+		//CPU replacement for particleGS.hlsl - expands particle points into camera facing,
+		//rotated quads drawn as an indexed triangle list (see QuadIndices).
+		class ParticleBillboards
+		{
+		public:
+			static constexpr unsigned int VERTS_PER_QUAD = 4;
+			static constexpr unsigned int INDICES_PER_QUAD = 6;
+
+			//Vectorized expansion, processes four particles at a time. Output is resized to 4 vertices per particle.
+			static void Expand(const std::vector<ParticleVertex>& particles, DirectX::FXMMATRIX viewMtx,
+				float timeToLive, std::vector<ParticleQuadVertex>& quads);
+			//Straight port of the geometry shader, one particle at a time
+			static void ExpandScalar(const std::vector<ParticleVertex>& particles, DirectX::FXMMATRIX viewMtx,
+				float timeToLive, std::vector<ParticleQuadVertex>& quads);
+
+			//Triangle list indices for the given number of quads
+			static std::vector<unsigned int> QuadIndices(size_t quadsCount);
+		};
+	}
+}
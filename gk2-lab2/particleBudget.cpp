@@ -0,0 +1,94 @@
+#include "particleBudget.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+const float ParticleBudget::FULL_DETAIL_DISTANCE = 3.0f;
+const float ParticleBudget::MIN_EMISSION_SCALE = 0.125f;
+const float ParticleBudget::MIN_COVERAGE = 1e-4f;
+
+ParticleBudget::ParticleBudget(size_t budget)
+	: m_budget(budget)
+{ }
+
+float ParticleBudget::ScreenCoverage(XMFLOAT3 center, float radius, XMFLOAT4 cameraPosition, const XMFLOAT4X4& projMtx)
+{
+	auto d = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&center), XMLoadFloat4(&cameraPosition))));
+	if (d <= radius)
+		return 1.0f;
+	//projected radius in normalized device coordinates, _11 and _22 hold cot(fov/2) scaled by aspect ratio
+	auto rx = projMtx._11 * radius / d;
+	auto ry = projMtx._22 * radius / d;
+	//fraction of the [-1,1]x[-1,1] screen square covered by the projected disc
+	return min(XM_PI * rx * ry / 4.0f, 1.0f);
+}
+
+void ParticleBudget::Distribute(const vector<ParticleSystem*>& emitters, XMFLOAT4 cameraPosition, const XMFLOAT4X4& projMtx)
+{
+	m_lods.clear();
+	auto radius = ParticleSystem::BoundingRadius();
+	auto totalCoverage = 0.0f;
+	for (auto e : emitters)
+	{
+		EmitterLod lod;
+		lod.emitter = e;
+		lod.coverage = ScreenCoverage(e->emitterPosition(), radius, cameraPosition, projMtx);
+		auto pos = e->emitterPosition();
+		auto d = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&pos), XMLoadFloat4(&cameraPosition))));
+		//fewer but larger particles far away keep the plume's look while cutting the particle count
+		lod.emissionScale = clamp(FULL_DETAIL_DISTANCE / max(d, FULL_DETAIL_DISTANCE), MIN_EMISSION_SCALE, 1.0f);
+		lod.sizeScale = 1.0f / sqrtf(lod.emissionScale);
+		lod.demand = lod.coverage < MIN_COVERAGE ? 0 :
+			static_cast<size_t>(ceilf(ParticleSystem::SteadyStateCount() * lod.emissionScale));
+		lod.capacity = 0;
+		if (lod.demand > 0)
+			totalCoverage += lod.coverage;
+		m_lods.push_back(lod);
+	}
+
+	//most visible emitters first
+	sort(m_lods.begin(), m_lods.end(), [](const EmitterLod& l1, const EmitterLod& l2) { return l1.coverage > l2.coverage; });
+
+	auto remaining = m_budget;
+	if (totalCoverage > 0.0f)
+		for (auto& lod : m_lods)
+		{
+			if (lod.demand == 0)
+				continue;
+			auto share = static_cast<size_t>(m_budget * (lod.coverage / totalCoverage));
+			lod.capacity = min({ lod.demand, share, remaining });
+			remaining -= lod.capacity;
+		}
+	for (auto& lod : m_lods)
+	{
+		auto extra = min(lod.demand - lod.capacity, remaining);
+		lod.capacity += extra;
+		remaining -= extra;
+	}
+
+	m_stats = ParticleBudgetStats();
+	m_stats.budget = m_budget;
+	m_stats.allocated = m_budget - remaining;
+	for (auto& lod : m_lods)
+	{
+		//emitters which didn't get all they asked for also emit slower instead of dropping particles in bursts
+		auto emission = lod.demand > 0 ? lod.emissionScale * lod.capacity / lod.demand : 0.0f;
+		lod.emitter->SetLevelOfDetail(emission, lod.sizeScale, lod.capacity);
+	}
+}
+
+const ParticleBudgetStats& ParticleBudget::Collect(const vector<ParticleSystem*>& emitters)
+{
+	m_stats.used = 0;
+	m_stats.dropped = 0;
+	for (auto e : emitters)
+	{
+		m_stats.used += e->particlesCount();
+		m_stats.dropped += e->droppedCount();
+	}
+	return m_stats;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include "particleSystem.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Statistics of a single frame, set by ParticleBudget::Distribute and Collect
+		struct ParticleBudgetStats
+		{
+			size_t budget;		//total number of particles allowed in all emitters
+			size_t allocated;	//capacity handed out to the emitters
+			size_t used;		//particles alive after the emitters were updated
+			size_t dropped;		//particles not spawned because an emitter ran out of capacity
+
+			ParticleBudgetStats() : budget(0), allocated(0), used(0), dropped(0) { }
+		};
+
+		//Distributes a global particle budget between emitters.
+		//Emission rate and particle size of each emitter are scaled with the distance from the camera
+		//and the capacity is assigned by the emitters' screen coverage - first every visible emitter
+		//gets a share proportional to its coverage, then the remaining capacity goes to the most visible ones.
+		class ParticleBudget
+		{
+		public:
+			explicit ParticleBudget(size_t budget = ParticleSystem::MAX_PARTICLES);
+
+			//Sets level of detail of all emitters. Call before updating the emitters.
+			void Distribute(const std::vector<ParticleSystem*>& emitters, DirectX::XMFLOAT4 cameraPosition,
+				const DirectX::XMFLOAT4X4& projMtx);
+			//Collects number of used and dropped particles. Call after updating the emitters.
+			const ParticleBudgetStats& Collect(const std::vector<ParticleSystem*>& emitters);
+
+			const ParticleBudgetStats& lastFrameStats() const { return m_stats; }
+			size_t budget() const { return m_budget; }
+			void setBudget(size_t budget) { m_budget = budget; }
+
+		private:
+			static const float FULL_DETAIL_DISTANCE;	//emitters closer than this are simulated at full detail
+			static const float MIN_EMISSION_SCALE;		//lowest emission scale used for distant emitters
+			static const float MIN_COVERAGE;			//emitters covering less of the screen are not simulated
+
+			struct EmitterLod
+			{
+				ParticleSystem* emitter;
+				float coverage;
+				float emissionScale;
+				float sizeScale;
+				size_t demand;
+				size_t capacity;
+			};
+
+			size_t m_budget;
+			ParticleBudgetStats m_stats;
+			std::vector<EmitterLod> m_lods;
+
+			static float ScreenCoverage(DirectX::XMFLOAT3 center, float radius, DirectX::XMFLOAT4 cameraPosition,
+				const DirectX::XMFLOAT4X4& projMtx);
+		};
+	}
+}
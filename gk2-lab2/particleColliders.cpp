@@ -0,0 +1,168 @@
+#include "particleColliders.h"
+#include <cfloat>
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	float GetLane(FXMVECTOR v, unsigned int lane) { return XMVectorGetByIndex(v, lane); }
+
+	XMVECTOR SetLane(FXMVECTOR v, float f, unsigned int lane)
+	{
+		XMFLOAT4 tmp;
+		XMStoreFloat4(&tmp, v);
+		(&tmp.x)[lane] = f;
+		return XMLoadFloat4(&tmp);
+	}
+
+	//lane-wise bit mask of a comparison result
+	unsigned int LaneMask(FXMVECTOR cmp)
+	{
+		XMUINT4 m;
+		XMStoreUInt4(&m, cmp);
+		return (m.x ? 1U : 0U) | (m.y ? 2U : 0U) | (m.z ? 4U : 0U) | (m.w ? 8U : 0U);
+	}
+}
+
+ParticleColliders::ParticleColliders(float restitution, float friction)
+	: m_restitution(restitution), m_friction(friction), m_planesCount(0), m_boxesCount(0)
+{ }
+
+void ParticleColliders::AddPlane(XMFLOAT3 point, XMFLOAT3 normal)
+{
+	auto lane = static_cast<unsigned int>(m_planesCount % 4);
+	if (lane == 0)
+	{
+		//unused lanes hold planes no sphere can penetrate
+		auto never = XMVectorReplicate(FLT_MAX);
+		m_planes.push_back({ XMVectorZero(), XMVectorZero(), XMVectorZero(), never });
+	}
+	auto n = XMVector3Normalize(XMLoadFloat3(&normal));
+	auto d = -XMVectorGetX(XMVector3Dot(n, XMLoadFloat3(&point)));
+	auto& b = m_planes.back();
+	b.nx = SetLane(b.nx, XMVectorGetX(n), lane);
+	b.ny = SetLane(b.ny, XMVectorGetY(n), lane);
+	b.nz = SetLane(b.nz, XMVectorGetZ(n), lane);
+	b.d = SetLane(b.d, d, lane);
+	++m_planesCount;
+}
+
+void ParticleColliders::AddPlane(const XMFLOAT4X4& worldMtx)
+{
+	auto m = XMLoadFloat4x4(&worldMtx);
+	XMFLOAT3 point, normal;
+	XMStoreFloat3(&point, XMVector3TransformCoord(XMVectorZero(), m));
+	XMStoreFloat3(&normal, XMVector3TransformNormal(XMVectorSet(0.0f, 0.0f, -1.0f, 0.0f), m));
+	AddPlane(point, normal);
+}
+
+void ParticleColliders::AddBox(const XMFLOAT4X4& worldMtx, XMFLOAT3 halfExtents)
+{
+	auto lane = static_cast<unsigned int>(m_boxesCount % 4);
+	if (lane == 0)
+	{
+		//unused lanes hold empty boxes far away
+		BoxBlock b;
+		b.cx = b.cy = b.cz = XMVectorReplicate(FLT_MAX);
+		for (auto i = 0; i < 3; ++i)
+			b.ax[i] = b.ay[i] = b.az[i] = XMVectorZero();
+		b.hx = b.hy = b.hz = XMVectorReplicate(-FLT_MAX);
+		m_boxes.push_back(b);
+	}
+	auto m = XMLoadFloat4x4(&worldMtx);
+	auto& b = m_boxes.back();
+	auto c = m.r[3];
+	b.cx = SetLane(b.cx, XMVectorGetX(c), lane);
+	b.cy = SetLane(b.cy, XMVectorGetY(c), lane);
+	b.cz = SetLane(b.cz, XMVectorGetZ(c), lane);
+	XMFLOAT3 scale;
+	for (auto i = 0; i < 3; ++i)
+	{
+		//rows of a row-vector world matrix are the transformed local axes, scale is folded into extents
+		auto len = XMVectorGetX(XMVector3Length(m.r[i]));
+		auto axis = XMVectorScale(m.r[i], 1.0f / len);
+		(&scale.x)[i] = len;
+		b.ax[i] = SetLane(b.ax[i], XMVectorGetX(axis), lane);
+		b.ay[i] = SetLane(b.ay[i], XMVectorGetY(axis), lane);
+		b.az[i] = SetLane(b.az[i], XMVectorGetZ(axis), lane);
+	}
+	b.hx = SetLane(b.hx, halfExtents.x * scale.x, lane);
+	b.hy = SetLane(b.hy, halfExtents.y * scale.y, lane);
+	b.hz = SetLane(b.hz, halfExtents.z * scale.z, lane);
+	++m_boxesCount;
+}
+
+void ParticleColliders::Respond(XMVECTOR& pos, XMVECTOR& vel, FXMVECTOR normal, float penetration) const
+{
+	pos = XMVectorMultiplyAdd(normal, XMVectorReplicate(penetration), pos);
+	auto vn = XMVector3Dot(vel, normal);
+	if (XMVectorGetX(vn) >= 0.0f)
+		return;
+	auto normalVel = XMVectorMultiply(vn, normal);
+	auto tangentVel = XMVectorSubtract(vel, normalVel);
+	vel = XMVectorSubtract(XMVectorScale(tangentVel, 1.0f - m_friction), XMVectorScale(normalVel, m_restitution));
+}
+
+bool ParticleColliders::Collide(XMFLOAT3& position, XMFLOAT3& velocity, float radius) const
+{
+	auto pos = XMLoadFloat3(&position);
+	auto vel = XMLoadFloat3(&velocity);
+	auto hit = false;
+	auto r = XMVectorReplicate(radius);
+
+	for (auto& b : m_planes)
+	{
+		auto x = XMVectorSplatX(pos), y = XMVectorSplatY(pos), z = XMVectorSplatZ(pos);
+		auto dist = XMVectorMultiplyAdd(b.nx, x, XMVectorMultiplyAdd(b.ny, y, XMVectorMultiplyAdd(b.nz, z, b.d)));
+		auto mask = LaneMask(XMVectorLess(dist, r));
+		//contacts are rare, so they are resolved one lane at a time
+		for (auto lane = 0U; mask; ++lane, mask >>= 1)
+		{
+			if (!(mask & 1U))
+				continue;
+			auto n = XMVectorSet(GetLane(b.nx, lane), GetLane(b.ny, lane), GetLane(b.nz, lane), 0.0f);
+			Respond(pos, vel, n, radius - GetLane(dist, lane));
+			hit = true;
+		}
+	}
+
+	for (auto& b : m_boxes)
+	{
+		auto dx = XMVectorSubtract(XMVectorSplatX(pos), b.cx);
+		auto dy = XMVectorSubtract(XMVectorSplatY(pos), b.cy);
+		auto dz = XMVectorSubtract(XMVectorSplatZ(pos), b.cz);
+		XMVECTOR local[3];
+		for (auto i = 0; i < 3; ++i)
+			local[i] = XMVectorMultiplyAdd(dx, b.ax[i], XMVectorMultiplyAdd(dy, b.ay[i], XMVectorMultiply(dz, b.az[i])));
+		//penetration depth along each local axis, positive when inside the inflated box
+		auto px = XMVectorSubtract(XMVectorAdd(b.hx, r), XMVectorAbs(local[0]));
+		auto py = XMVectorSubtract(XMVectorAdd(b.hy, r), XMVectorAbs(local[1]));
+		auto pz = XMVectorSubtract(XMVectorAdd(b.hz, r), XMVectorAbs(local[2]));
+		auto inside = XMVectorAndInt(XMVectorGreater(px, XMVectorZero()),
+			XMVectorAndInt(XMVectorGreater(py, XMVectorZero()), XMVectorGreater(pz, XMVectorZero())));
+		auto mask = LaneMask(inside);
+		for (auto lane = 0U; mask; ++lane, mask >>= 1)
+		{
+			if (!(mask & 1U))
+				continue;
+			//leave the box through the face with the smallest penetration
+			float pen[3] = { GetLane(px, lane), GetLane(py, lane), GetLane(pz, lane) };
+			auto axis = pen[0] < pen[1] ? (pen[0] < pen[2] ? 0 : 2) : (pen[1] < pen[2] ? 1 : 2);
+			auto sign = GetLane(local[axis], lane) < 0.0f ? -1.0f : 1.0f;
+			auto n = XMVectorScale(XMVectorSet(GetLane(b.ax[axis], lane), GetLane(b.ay[axis], lane),
+				GetLane(b.az[axis], lane), 0.0f), sign);
+			Respond(pos, vel, n, pen[axis]);
+			hit = true;
+		}
+	}
+
+	if (hit)
+	{
+		XMStoreFloat3(&position, pos);
+		XMStoreFloat3(&velocity, vel);
+	}
+	return hit;
+}
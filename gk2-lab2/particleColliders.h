@@ -0,0 +1,54 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Static collision geometry for particles: infinite planes and oriented boxes.
+		//Colliders are kept in SoA blocks of four, so a particle is tested against
+		//four planes or four boxes with a single set of vector operations.
+		class ParticleColliders
+		{
+		public:
+			explicit ParticleColliders(float restitution = 0.1f, float friction = 0.3f);
+
+			//Plane through point with normal pointing to the side where particles live
+			void AddPlane(DirectX::XMFLOAT3 point, DirectX::XMFLOAT3 normal);
+			//Plane of a mesh lying in local XY plane with normal (0,0,-1), e.g. Mesh::Rectangle
+			void AddPlane(const DirectX::XMFLOAT4X4& worldMtx);
+			//Box of given half extents in local space transformed by worldMtx (rotation and translation only)
+			void AddBox(const DirectX::XMFLOAT4X4& worldMtx, DirectX::XMFLOAT3 halfExtents);
+
+			//Pushes a sphere out of all colliders and reflects its velocity.
+			//Returns true if any collider was hit.
+			bool Collide(DirectX::XMFLOAT3& position, DirectX::XMFLOAT3& velocity, float radius) const;
+
+			size_t planesCount() const { return m_planesCount; }
+			size_t boxesCount() const { return m_boxesCount; }
+
+		private:
+			struct PlaneBlock
+			{
+				DirectX::XMVECTOR nx, ny, nz, d;
+			};
+
+			struct BoxBlock
+			{
+				DirectX::XMVECTOR cx, cy, cz;		//centers
+				DirectX::XMVECTOR ax[3], ay[3], az[3];	//local axes in world space
+				DirectX::XMVECTOR hx, hy, hz;		//half extents
+			};
+
+			float m_restitution;
+			float m_friction;
+			size_t m_planesCount;
+			size_t m_boxesCount;
+			std::vector<PlaneBlock> m_planes;
+			std::vector<BoxBlock> m_boxes;
+
+			void Respond(DirectX::XMVECTOR& pos, DirectX::XMVECTOR& vel, DirectX::FXMVECTOR normal, float penetration) const;
+		};
+	}
+}
@@ -0,0 +1,28 @@
+cbuffer cbProj : register(b2) //Vertex Shader constant buffer slot 2
+{
+	matrix projMatrix;
+};
+
+struct VSInput
+{
+	float3 pos : POSITION;
+	float2 tex1 : TEXCOORD0;
+	float2 tex2 : TEXCOORD1;
+};
+
+struct PSInput
+{
+	float4 pos : SV_POSITION;
+	float2 tex1: TEXCOORD0;
+	float2 tex2: TEXCOORD1;
+};
+
+//Particle quads expanded on the CPU (ParticleBillboards) are already in view space
+PSInput main(VSInput i)
+{
+	PSInput o = (PSInput)0;
+	o.pos = mul(projMatrix, float4(i.pos, 1.0f));
+	o.tex1 = i.tex1;
+	o.tex2 = i.tex2;
+	return o;
+}
@@ -1,20 +1,12 @@
 #include "particleSystem.h"
-#include "dxDevice.h"
-#include "exceptions.h"
+#include <algorithm>
+#include <iterator>
 
 using namespace mini;
 using namespace gk2;
 using namespace DirectX;
 using namespace std;
 
-const D3D11_INPUT_ELEMENT_DESC ParticleVertex::Layout[4] =
-{
-	{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	{ "TEXCOORD", 0, DXGI_FORMAT_R32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	{ "TEXCOORD", 1, DXGI_FORMAT_R32_FLOAT, 0, 16, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	{ "TEXCOORD", 2, DXGI_FORMAT_R32_FLOAT, 0, 20, D3D11_INPUT_PER_VERTEX_DATA, 0 }
-};
-
 const XMFLOAT3 ParticleSystem::EMITTER_DIR = XMFLOAT3(0.0f, 1.0f, 0.0f);
 const float ParticleSystem::TIME_TO_LIVE = 4.0f;
 const float ParticleSystem::EMISSION_RATE = 10.0f;
@@ -26,37 +18,164 @@ const float ParticleSystem::PARTICLE_SCALE = 1.0f;
 const float ParticleSystem::MIN_ANGLE_VEL = -XM_PI;
 const float ParticleSystem::MAX_ANGLE_VEL = XM_PI;
 const int ParticleSystem::MAX_PARTICLES = 500;
+const float ParticleSystem::FIXED_TIME_STEP = 1.0f / 60.0f;
+const int ParticleSystem::MAX_SUBSTEPS = 4;
+const float ParticleSystem::TURBULENCE_STRENGTH = 0.15f;
+const float ParticleSystem::REPULSION_STRENGTH = 0.5f;
+const float ParticleSystem::REPULSION_RADIUS = 0.1f;
 
-ParticleSystem::ParticleSystem(DirectX::XMFLOAT3 emmiterPosition)
-	: m_emitterPos(emmiterPosition), m_particlesToCreate(0.0f), m_random(random_device{}())
+ParticleSystem::ParticleSystem(DirectX::XMFLOAT3 emmiterPosition, size_t maxParticles)
+	: m_emitterPos(emmiterPosition), m_particlesToCreate(0.0f), m_maxParticles(maxParticles), m_capacity(maxParticles),
+	m_random(random_device{}())
 { }
 
 vector<ParticleVertex> ParticleSystem::Update(float dt, DirectX::XMFLOAT4 cameraPosition)
 {
-	size_t removeCount = 0;
+	return Update(dt, cameraPosition, ViewFrustum());
+}
+
+vector<ParticleVertex> ParticleSystem::Update(float dt, DirectX::XMFLOAT4 cameraPosition, const ViewFrustum& frustum)
+{
+	m_droppedCount = 0;
+	m_accumulator += dt;
+	auto steps = 0;
+	for (; m_accumulator >= FIXED_TIME_STEP && steps < MAX_SUBSTEPS; ++steps)
+	{
+		Step(FIXED_TIME_STEP);
+		m_accumulator -= FIXED_TIME_STEP;
+	}
+	//after a long hitch the simulation slows down instead of spending unbounded time catching up
+	if (steps == MAX_SUBSTEPS)
+		m_accumulator = min(m_accumulator, FIXED_TIME_STEP);
+	auto vertices = GetParticleVerts(frustum, m_accumulator / FIXED_TIME_STEP);
+	SortParticleVerts(vertices, cameraPosition);
+	return vertices;
+}
+
+void ParticleSystem::Step(float dt)
+{
+	SimulateParticles(dt);
+	TurbulenceParticles(dt);
+	RepelParticles(dt);
+	CollideParticles();
+	ExpireParticles();
+	SpawnParticles(dt);
+}
+
+void ParticleSystem::SimulateParticles(float dt)
+{
 	for (auto& p : m_particles)
 	{
+		p.PreviousVertex = p.Vertex;
 		UpdateParticle(p, dt);
-		if (p.Vertex.Age >= TIME_TO_LIVE)
-			++removeCount;
 	}
-	m_particles.erase(m_particles.begin(), m_particles.begin() + removeCount);
+}
+
+void ParticleSystem::TurbulenceParticles(float dt)
+{
+	if (!m_turbulence)
+		return;
+	//smoke leaves the emitter in a straight stream and swirls more as it rises
+	auto scale = m_turbulenceStrength * dt / TIME_TO_LIVE;
+	for (auto& p : m_particles)
+	{
+		auto pos = XMLoadFloat3(&p.Vertex.Pos);
+		auto offset = XMVectorScale(m_turbulence->Sample(pos), scale * p.Vertex.Age);
+		XMStoreFloat3(&p.Vertex.Pos, XMVectorAdd(pos, offset));
+	}
+}
+
+void ParticleSystem::RepelParticles(float dt)
+{
+	if (m_repulsionStrength <= 0.0f || m_particles.size() < 2)
+		return;
+	m_grid.Build(&m_particles[0].Vertex.Pos, m_particles.size(), sizeof(Particle));
+	m_repulsion.assign(m_particles.size(), XMFLOAT3(0.0f, 0.0f, 0.0f));
+	//neighbours only read positions, so velocity changes can be accumulated per particle in parallel
+	auto radius = m_repulsionRadius;
+	auto scale = m_repulsionStrength * dt;
+	m_grid.ForEachNeighbour(radius, [&](size_t i, size_t j, float d2)
+	{
+		if (d2 <= 0.0f)
+			return;
+		auto& pi = m_particles[i].Vertex.Pos;
+		auto& pj = m_particles[j].Vertex.Pos;
+		auto d = sqrtf(d2);
+		//push falls off linearly from the full strength at zero distance to zero at radius
+		auto push = scale * (1.0f - d / radius) / d;
+		auto& r = m_repulsion[i];
+		r.x += (pi.x - pj.x) * push;
+		r.y += (pi.y - pj.y) * push;
+		r.z += (pi.z - pj.z) * push;
+	});
+	for (size_t i = 0; i < m_particles.size(); ++i)
+	{
+		auto& v = m_particles[i].Velocities.Velocity;
+		XMStoreFloat3(&v, XMVectorAdd(XMLoadFloat3(&v), XMLoadFloat3(&m_repulsion[i])));
+	}
+}
+
+void ParticleSystem::CollideParticles()
+{
+	if (!m_colliders)
+		return;
+	for (auto& p : m_particles)
+		m_colliders->Collide(p.Vertex.Pos, p.Velocities.Velocity, 0.5f * p.Vertex.Size);
+}
 
-	m_particlesToCreate += dt * EMISSION_RATE;
+void ParticleSystem::ExpireParticles()
+{
+	//particles are spawned in order, so the oldest ones are at the front
+	auto firstAlive = find_if(m_particles.begin(), m_particles.end(), [](const Particle& p) { return p.Vertex.Age < TIME_TO_LIVE; });
+	m_particles.erase(m_particles.begin(), firstAlive);
+}
+
+void ParticleSystem::SpawnParticles(float dt)
+{
+	m_particlesToCreate += dt * EMISSION_RATE * m_emissionScale;
 	while (m_particlesToCreate >= 1.0f)
 	{
 		--m_particlesToCreate;
-		if (m_particles.size() < MAX_PARTICLES)
+		if (m_particles.size() < m_capacity)
 			m_particles.push_back(RandomParticle());
+		else
+			++m_droppedCount;
 	}
-	return GetParticleVerts(cameraPosition);
+}
+
+void ParticleSystem::SetLevelOfDetail(float emissionScale, float sizeScale, size_t capacity)
+{
+	m_emissionScale = max(emissionScale, 0.0f);
+	m_sizeScale = max(sizeScale, 0.0f);
+	m_capacity = min(capacity, m_maxParticles);
+}
+
+void ParticleSystem::SetRepulsion(float strength, float radius)
+{
+	m_repulsionStrength = max(strength, 0.0f);
+	m_repulsionRadius = radius;
+	m_grid.SetCellSize(radius);
+}
+
+void ParticleSystem::SetEmitterSurface(shared_ptr<const MeshSurfaceSampler> surface, const XMFLOAT4X4& worldMtx)
+{
+	m_emitterSurface = move(surface);
+	m_emitterMtx = worldMtx;
+}
+
+float ParticleSystem::BoundingRadius()
+{
+	//particles travel at most MAX_VELOCITY*TIME_TO_LIVE and grow to the size reached at the end of their life;
+	//turbulence speed grows linearly with age, so it adds at most half of TURBULENCE_STRENGTH*TIME_TO_LIVE
+	auto finalSize = PARTICLE_SIZE * (1.0f + PARTICLE_SCALE * TIME_TO_LIVE);
+	return (MAX_VELOCITY + 0.5f * TURBULENCE_STRENGTH) * TIME_TO_LIVE + finalSize;
 }
 
 XMFLOAT3 ParticleSystem::RandomVelocity()
 {
-	static const uniform_real_distribution<float> angleDist(0, XM_2PI);
-	static const uniform_real_distribution<float> magnitudeDist(0, tan(MAX_ANGLE));
-	static const uniform_real_distribution<float> velDist(MIN_VELOCITY, MAX_VELOCITY);
+	uniform_real_distribution<float> angleDist(0, XM_2PI);
+	uniform_real_distribution<float> magnitudeDist(0, tan(MAX_ANGLE));
+	uniform_real_distribution<float> velDist(MIN_VELOCITY, MAX_VELOCITY);
 	float angle = angleDist(m_random);
 	float magnitude = magnitudeDist(m_random);
 	XMFLOAT3 v{ cos(angle)*magnitude, 1.0f, sin(angle)*magnitude };
@@ -68,49 +187,92 @@ XMFLOAT3 ParticleSystem::RandomVelocity()
 	return v;
 }
 
+XMFLOAT3 ParticleSystem::RandomVelocity(FXMVECTOR normal)
+{
+	//express velocity drawn around the y axis in a basis with the normal in place of y
+	auto velocity = RandomVelocity();
+	auto v = XMLoadFloat3(&velocity);
+	auto n = XMVector3Normalize(normal);
+	auto helper = fabsf(XMVectorGetX(n)) < 0.9f ? XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f) : XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+	auto t = XMVector3Normalize(XMVector3Cross(helper, n));
+	auto b = XMVector3Cross(n, t);
+	XMFLOAT3 result;
+	XMStoreFloat3(&result, XMVectorAdd(XMVectorScale(t, XMVectorGetX(v)),
+		XMVectorAdd(XMVectorScale(n, XMVectorGetY(v)), XMVectorScale(b, XMVectorGetZ(v)))));
+	return result;
+}
+
 Particle ParticleSystem::RandomParticle()
 {
-	static const uniform_real_distribution<float> anglularVelDist(MIN_ANGLE_VEL, MAX_ANGLE_VEL);
+	uniform_real_distribution<float> anglularVelDist(MIN_ANGLE_VEL, MAX_ANGLE_VEL);
 	Particle p;
-	p.Vertex.Pos = m_emitterPos;
+	if (m_emitterSurface)
+	{
+		auto point = m_emitterSurface->Sample(m_random);
+		auto mtx = XMLoadFloat4x4(&m_emitterMtx);
+		XMStoreFloat3(&p.Vertex.Pos, XMVector3TransformCoord(XMLoadFloat3(&point.Position), mtx));
+		p.Velocities.Velocity = RandomVelocity(XMVector3TransformNormal(XMLoadFloat3(&point.Normal), mtx));
+	}
+	else
+	{
+		p.Vertex.Pos = m_emitterPos;
+		p.Velocities.Velocity = RandomVelocity();
+	}
 	p.Vertex.Age = 0.0f;
 	p.Vertex.Angle = 0.0f;
-	p.Vertex.Size = PARTICLE_SIZE;
-	p.Velocities.Velocity = RandomVelocity();
+	p.Vertex.Size = PARTICLE_SIZE * m_sizeScale;
 	p.Velocities.AngularVelocity = anglularVelDist(m_random);
+	p.PreviousVertex = p.Vertex;
 
 	return p;
 }
 
-void ParticleSystem::UpdateParticle(Particle& p, float dt)
+void ParticleSystem::UpdateParticle(Particle& p, float dt) const
 {
 	auto pos = XMLoadFloat3(&p.Vertex.Pos);
 	auto vel = XMLoadFloat3(&p.Velocities.Velocity);
 	p.Vertex.Age += dt;
 	XMStoreFloat3(&p.Vertex.Pos, XMVectorAdd(pos, vel * dt));
-	p.Vertex.Size += PARTICLE_SCALE * PARTICLE_SIZE * dt;
+	p.Vertex.Size += PARTICLE_SCALE * PARTICLE_SIZE * m_sizeScale * dt;
 	p.Vertex.Angle += p.Velocities.AngularVelocity * dt;
 }
 
-vector<ParticleVertex> ParticleSystem::GetParticleVerts(DirectX::XMFLOAT4 cameraPosition)
+ParticleVertex ParticleSystem::Interpolate(const ParticleVertex& v1, const ParticleVertex& v2, float alpha)
 {
-	XMFLOAT4 cameraTarget(0.0f, 0.0f, 0.0f, 1.0f);
+	ParticleVertex v;
+	XMStoreFloat3(&v.Pos, XMVectorLerp(XMLoadFloat3(&v1.Pos), XMLoadFloat3(&v2.Pos), alpha));
+	v.Age = v1.Age + (v2.Age - v1.Age) * alpha;
+	v.Angle = v1.Angle + (v2.Angle - v1.Angle) * alpha;
+	v.Size = v1.Size + (v2.Size - v1.Size) * alpha;
+	return v;
+}
 
+vector<ParticleVertex> ParticleSystem::GetParticleVerts(const ViewFrustum& frustum, float alpha) const
+{
 	vector<ParticleVertex> vertices;
 	vertices.reserve(m_particles.size());
-	transform(m_particles.begin(), m_particles.end(), std::back_inserter(vertices), [](const Particle& p) { return p.Vertex; });
+	//particle size bounds its rotated billboard, so it's a safe culling radius
+	for (auto& p : m_particles)
+	{
+		auto v = Interpolate(p.PreviousVertex, p.Vertex, alpha);
+		if (frustum.IntersectsSphere(XMLoadFloat3(&v.Pos), v.Size))
+			vertices.push_back(v);
+	}
+	return vertices;
+}
+
+void ParticleSystem::SortParticleVerts(vector<ParticleVertex>& vertices, DirectX::XMFLOAT4 cameraPosition)
+{
+	XMFLOAT4 cameraTarget(0.0f, 0.0f, 0.0f, 1.0f);
+
 	XMVECTOR camPos = XMLoadFloat4(&cameraPosition);
 	XMVECTOR camDir = XMVectorSubtract(XMLoadFloat4(&cameraTarget), camPos);
 	sort(vertices.begin(), vertices.end(), [camPos, camDir](auto& p1, auto& p2)
 	{
-		auto p1Pos = XMLoadFloat3(&(p1.Pos));
-		p1Pos.m128_f32[3] = 1.0f;
-		auto p2Pos = XMLoadFloat3(&(p2.Pos));
-		p2Pos.m128_f32[3] = 1.0f;
-		auto d1 = XMVector3Dot(p1Pos - camPos, camDir).m128_f32[0];
-		auto d2 = XMVector3Dot(p2Pos - camPos, camDir).m128_f32[0];
+		auto p1Pos = XMVectorSetW(XMLoadFloat3(&(p1.Pos)), 1.0f);
+		auto p2Pos = XMVectorSetW(XMLoadFloat3(&(p2.Pos)), 1.0f);
+		auto d1 = XMVectorGetX(XMVector3Dot(p1Pos - camPos, camDir));
+		auto d2 = XMVectorGetX(XMVector3Dot(p2Pos - camPos, camDir));
 		return d1 > d2;
 	});
-
-	return vertices;
-}
\ No newline at end of file
+}
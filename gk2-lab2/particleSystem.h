@@ -2,7 +2,15 @@
 #include <DirectXMath.h>
 #include <vector>
 #include <random>
-#include <d3d11.h>
+#include <memory>
+#include "frustum.h"
+#include "particleColliders.h"
+#include "turbulenceField.h"
+#include "spatialHashGrid.h"
+#include "meshSurfaceSampler.h"
+
+//Defined in d3d11.h; layouts are defined in vertexTypes.cpp, so the simulation builds without Direct3D
+struct D3D11_INPUT_ELEMENT_DESC;
 
 namespace mini
 {
@@ -30,6 +38,7 @@ namespace mini
 		struct Particle
 		{
 			ParticleVertex Vertex;
+			ParticleVertex PreviousVertex;	//state before the last simulation step, used for interpolation
 			ParticleVelocities Velocities;
 		};
 
@@ -40,14 +49,71 @@ namespace mini
 
 			ParticleSystem(ParticleSystem&& other) = default;
 
-			ParticleSystem(DirectX::XMFLOAT3 emmiterPosition);
+			explicit ParticleSystem(DirectX::XMFLOAT3 emmiterPosition, size_t maxParticles = MAX_PARTICLES);
 
 			ParticleSystem& operator=(ParticleSystem&& other) = default;
 
+			//Advances the simulation in steps of FIXED_TIME_STEP (at most MAX_SUBSTEPS per call)
+			//and returns particles interpolated between the last two steps.
 			std::vector<ParticleVertex> Update(float dt, DirectX::XMFLOAT4 cameraPosition);
+			//Returns only particles intersecting the view frustum, sorted back to front
+			std::vector<ParticleVertex> Update(float dt, DirectX::XMFLOAT4 cameraPosition, const ViewFrustum& frustum);
+
+			//Scales emission rate and particle size and limits the number of live particles.
+			//Set every frame by ParticleBudget.
+			void SetLevelOfDetail(float emissionScale, float sizeScale, size_t capacity);
+			//Particles bounce off the colliders during each simulation step. Pass nullptr to disable.
+			void SetColliders(std::shared_ptr<const ParticleColliders> colliders) { m_colliders = std::move(colliders); }
+			//Particles are carried by the field scaled by strength, growing with particle age. Pass nullptr to disable.
+			void SetTurbulence(std::shared_ptr<const TurbulenceField> field, float strength = TURBULENCE_STRENGTH)
+			{
+				m_turbulence = std::move(field);
+				m_turbulenceStrength = strength;
+			}
+			//Particles are born on the surface of the mesh transformed by worldMtx (rotation, translation
+			//and uniform scale) and fly away along its normal. Pass nullptr to emit from the emitter position.
+			void SetEmitterSurface(std::shared_ptr<const MeshSurfaceSampler> surface, const DirectX::XMFLOAT4X4& worldMtx);
+			//Moves the surface emitter, e.g. with the robot link it's attached to
+			void SetEmitterTransform(const DirectX::XMFLOAT4X4& worldMtx) { m_emitterMtx = worldMtx; }
+			//Particles closer than radius push each other apart. Strength 0 disables the repulsion.
+			void SetRepulsion(float strength = REPULSION_STRENGTH, float radius = REPULSION_RADIUS);
+			void Seed(unsigned int seed) { m_random.seed(seed); }
+
+			//Single simulation step, i.e. SimulateParticles, TurbulenceParticles, RepelParticles, CollideParticles,
+			//ExpireParticles and SpawnParticles
+			void Step(float dt);
+			//Stages of the update, public so they can be profiled separately
+			void SimulateParticles(float dt);
+			void TurbulenceParticles(float dt);
+			void RepelParticles(float dt);
+			void CollideParticles();
+			void ExpireParticles();
+			void SpawnParticles(float dt);
+			//Particles interpolated between the last two steps that intersect the frustum
+			std::vector<ParticleVertex> GetParticleVerts(const ViewFrustum& frustum, float alpha) const;
+			//Sorts particles back to front as seen from the camera
+			static void SortParticleVerts(std::vector<ParticleVertex>& vertices, DirectX::XMFLOAT4 cameraPosition);
 
 			size_t particlesCount() const { return m_particles.size(); }
+			size_t maxParticles() const { return m_maxParticles; }
+			size_t droppedCount() const { return m_droppedCount; }
+			DirectX::XMFLOAT3 emitterPosition() const { return m_emitterPos; }
+			float emissionScale() const { return m_emissionScale; }
+			//Position between the last two steps used by the last Update, pass it to GetParticleVerts
+			float interpolation() const { return m_accumulator / FIXED_TIME_STEP; }
+
+			//Number of live particles at full detail once emission and expiration even out
+			static float SteadyStateCount() { return EMISSION_RATE * TIME_TO_LIVE; }
+			static float TimeToLive() { return TIME_TO_LIVE; }
+			//Radius of a sphere around the emitter containing all particles
+			static float BoundingRadius();
+
 			static const int MAX_PARTICLES;		//maximal number of particles in the system
+			static const float FIXED_TIME_STEP;	//length of a single simulation step in seconds
+			static const int MAX_SUBSTEPS;		//maximal number of simulation steps per update
+			static const float TURBULENCE_STRENGTH;	//default speed of turbulent motion at the end of particle's life
+			static const float REPULSION_STRENGTH;	//default acceleration between two overlapping particles
+			static const float REPULSION_RADIUS;	//default distance at which particles stop repelling
 
 		private:
 			static const DirectX::XMFLOAT3 EMITTER_DIR;	//mean direction of particles' velocity
@@ -63,15 +129,33 @@ namespace mini
 
 			DirectX::XMFLOAT3 m_emitterPos;
 			float m_particlesToCreate;
+			float m_accumulator = 0.0f;	//simulation time not consumed by fixed steps yet
+
+			float m_emissionScale = 1.0f;
+			float m_sizeScale = 1.0f;
+			size_t m_maxParticles = MAX_PARTICLES;
+			size_t m_capacity = MAX_PARTICLES;
+			size_t m_droppedCount = 0;	//particles not spawned during last update because of m_capacity
 
 			std::vector<Particle> m_particles;
+			std::shared_ptr<const ParticleColliders> m_colliders;
+			std::shared_ptr<const TurbulenceField> m_turbulence;
+			std::shared_ptr<const MeshSurfaceSampler> m_emitterSurface;
+			DirectX::XMFLOAT4X4 m_emitterMtx;
+			float m_turbulenceStrength = 0.0f;
+			float m_repulsionStrength = 0.0f;
+			float m_repulsionRadius = REPULSION_RADIUS;
+			SpatialHashGrid m_grid;	//rebuilt by every RepelParticles
+			std::vector<DirectX::XMFLOAT3> m_repulsion;
 
 			std::default_random_engine m_random;
 
 			DirectX::XMFLOAT3 RandomVelocity();
+			//Random velocity around the direction of normal instead of EMITTER_DIR
+			DirectX::XMFLOAT3 RandomVelocity(DirectX::FXMVECTOR normal);
 			Particle RandomParticle();
-			static void UpdateParticle(Particle& p, float dt);
-			std::vector<ParticleVertex> GetParticleVerts(DirectX::XMFLOAT4 cameraPosition);
+			void UpdateParticle(Particle& p, float dt) const;
+			static ParticleVertex Interpolate(const ParticleVertex& v1, const ParticleVertex& v2, float alpha);
 		};
 	}
 }
\ No newline at end of file
@@ -0,0 +1,204 @@
+#include "pathParameterization.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace mini;
+using namespace gk2;
+using namespace std;
+
+namespace
+{
+	const float EPSILON = 1e-9f;
+	//bound of the path acceleration for parts of a path where no joint moves
+	const float IDLE_ACCELERATION = 1e3f;
+
+	float Distance(const PumaAngles& a, const PumaAngles& b)
+	{
+		auto sum = 0.0f;
+		for (size_t j = 0; j < a.size(); ++j)
+			sum += (b[j] - a[j]) * (b[j] - a[j]);
+		return sqrtf(sum);
+	}
+}
+
+JointLimits JointLimits::Puma()
+{
+	//heavier proximal joints are slower
+	return { { 2.0f, 1.5f, 2.0f, 4.0f, 4.0f }, { 4.0f, 3.0f, 4.0f, 8.0f, 8.0f } };
+}
+
+PathParameterization::PathParameterization(const JointLimits& limits)
+	: m_limits(limits)
+{ }
+
+void PathParameterization::AccelerationRange(const Derivatives& d, float x, float& minAcc, float& maxAcc) const
+{
+	//joint acceleration is q' * s'' + q'' * x and must stay within +-MaxAcceleration
+	minAcc = -FLT_MAX;
+	maxAcc = FLT_MAX;
+	for (size_t j = 0; j < d.First.size(); ++j)
+	{
+		auto a = m_limits.MaxAcceleration[j];
+		auto centripetal = d.Second[j] * x;
+		if (fabsf(d.First[j]) < EPSILON)
+		{
+			//joint doesn't move along the path here, so only x is constrained
+			if (fabsf(centripetal) > a)
+			{
+				minAcc = FLT_MAX;
+				maxAcc = -FLT_MAX;
+				return;
+			}
+			continue;
+		}
+		auto lo = (-a - centripetal) / d.First[j], hi = (a - centripetal) / d.First[j];
+		if (lo > hi)
+			swap(lo, hi);
+		minAcc = max(minAcc, lo);
+		maxAcc = min(maxAcc, hi);
+	}
+}
+
+float PathParameterization::MaxSpeedSquared(const Derivatives& d) const
+{
+	auto xMax = FLT_MAX;
+	for (size_t j = 0; j < d.First.size(); ++j)
+		if (fabsf(d.First[j]) > EPSILON)
+		{
+			auto v = m_limits.MaxVelocity[j] / fabsf(d.First[j]);
+			xMax = min(xMax, v * v);
+		}
+	//the feasible acceleration range only shrinks as x grows, so its end is found by bisection
+	float minAcc, maxAcc;
+	AccelerationRange(d, xMax, minAcc, maxAcc);
+	if (minAcc <= maxAcc)
+		return xMax;
+	auto lo = 0.0f, hi = xMax == FLT_MAX ? 1e6f : xMax;
+	for (auto i = 0; i < BISECTION_STEPS; ++i)
+	{
+		auto mid = 0.5f * (lo + hi);
+		AccelerationRange(d, mid, minAcc, maxAcc);
+		(minAcc <= maxAcc ? lo : hi) = mid;
+	}
+	return lo;
+}
+
+vector<float> PathParameterization::Solve(const vector<PumaAngles>& path) const
+{
+	auto n = path.size();
+	vector<float> times(n, 0.0f);
+	if (n < 2)
+		return times;
+
+	vector<float> ds(n - 1);
+	for (size_t i = 0; i + 1 < n; ++i)
+		ds[i] = Distance(path[i], path[i + 1]);
+
+	//finite difference derivatives with respect to arc length, between the nearest samples at other positions,
+	//so repeated samples don't hide the curvature of the path around them
+	vector<Derivatives> d(n);
+	for (size_t i = 0, prev = 0; i < n; ++i)
+	{
+		if (i > 0 && ds[i - 1] > EPSILON)
+			prev = i - 1;
+		auto next = i;
+		while (next + 1 < n && ds[next] <= EPSILON)
+			++next;
+		next = next + 1 < n ? next + 1 : i;
+		auto back = 0.0f, forth = 0.0f;
+		for (auto k = prev; k < i; ++k)
+			back += ds[k];
+		for (auto k = i; k < next; ++k)
+			forth += ds[k];
+		for (size_t j = 0; j < path[i].size(); ++j)
+		{
+			d[i].First[j] = back + forth > EPSILON ? (path[next][j] - path[prev][j]) / (back + forth) : 0.0f;
+			d[i].Second[j] = 0.0f;
+			if (back > EPSILON && forth > EPSILON)
+			{
+				auto forward = (path[next][j] - path[i][j]) / forth;
+				auto backward = (path[i][j] - path[prev][j]) / back;
+				d[i].Second[j] = 2.0f * (forward - backward) / (back + forth);
+			}
+		}
+	}
+
+	//backward pass: controllable sets [0, reachable_i] of x from which the end can still be reached at rest
+	vector<float> reachable(n);
+	reachable.back() = 0.0f;
+	for (auto i = n - 1; i > 0; --i)
+	{
+		auto k = i - 1;
+		auto step = 2.0f * ds[k];
+		auto feasible = [&](float x)
+		{
+			float minAcc, maxAcc;
+			AccelerationRange(d[k], x, minAcc, maxAcc);
+			if (step > EPSILON)
+			{
+				//x_{k+1} = x_k + 2 ds s'' must end in [0, reachable_{k+1}]
+				minAcc = max(minAcc, -x / step);
+				maxAcc = min(maxAcc, (reachable[i] - x) / step);
+			}
+			else if (x > reachable[i])
+				return false;
+			return minAcc <= maxAcc;
+		};
+		//the set contains 0 (standing still) and is convex, so its end is found by bisection
+		auto hi = MaxSpeedSquared(d[k]);
+		if (hi == FLT_MAX)
+			hi = reachable[i] + step * IDLE_ACCELERATION;
+		if (feasible(hi))
+		{
+			reachable[k] = hi;
+			continue;
+		}
+		auto lo = 0.0f;
+		for (auto it = 0; it < BISECTION_STEPS; ++it)
+		{
+			auto mid = 0.5f * (lo + hi);
+			(feasible(mid) ? lo : hi) = mid;
+		}
+		reachable[k] = lo;
+	}
+
+	//forward pass: accelerate as hard as possible while staying in the controllable sets
+	vector<float> x(n);
+	x.front() = 0.0f;
+	for (size_t i = 0; i + 1 < n; ++i)
+	{
+		float minAcc, maxAcc;
+		AccelerationRange(d[i], x[i], minAcc, maxAcc);
+		auto next = ds[i] > EPSILON ? x[i] + 2.0f * ds[i] * maxAcc : x[i];
+		x[i + 1] = max(0.0f, min(next, reachable[i + 1]));
+	}
+
+	for (size_t i = 0; i + 1 < n; ++i)
+	{
+		auto speed = sqrtf(x[i]) + sqrtf(x[i + 1]);
+		float dt;
+		if (ds[i] <= EPSILON)
+			dt = 0.0f;
+		else if (speed > EPSILON)
+			dt = 2.0f * ds[i] / speed;
+		else
+		{
+			//segment starting and ending at rest: accelerate over one half and brake over the other
+			float minAcc, maxAcc;
+			AccelerationRange(d[i], 0.0f, minAcc, maxAcc);
+			dt = 2.0f * sqrtf(ds[i] / max(min(maxAcc, -minAcc), EPSILON));
+		}
+		times[i + 1] = times[i] + dt;
+	}
+	return times;
+}
+
+JointTrajectory PathParameterization::Retime(const JointTrajectory& trajectory) const
+{
+	auto times = Solve(trajectory.angles());
+	JointTrajectory result;
+	for (size_t i = 0; i < times.size(); ++i)
+		result.Append(times[i], trajectory.angles()[i]);
+	return result;
+}
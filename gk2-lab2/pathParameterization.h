@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include "jointTrajectory.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		struct JointLimits
+		{
+			PumaAngles MaxVelocity;		//radians per second
+			PumaAngles MaxAcceleration;	//radians per second squared
+
+			static JointLimits Puma();
+		};
+
+		//Fastest timing of a joint space path under per joint velocity and acceleration limits.
+		//The path is parametrized by its joint space arc length s. Between samples the path acceleration u = s''
+		//is constant, so the squared path speed x = (ds/dt)^2 changes by 2 u ds, and joint limits become linear
+		//constraints on (u, x). As in TOPP-RA a backward pass computes for every sample the largest x from which
+		//the end can still be reached at rest, then a forward pass accelerates as hard as these sets allow.
+		//Both passes are linear in the number of samples.
+		class PathParameterization
+		{
+		public:
+			explicit PathParameterization(const JointLimits& limits);
+
+			//Times of path samples for motion starting and ending at rest, the first time is 0
+			std::vector<float> Solve(const std::vector<PumaAngles>& path) const;
+			//Same path with keys moved to their fastest times
+			JointTrajectory Retime(const JointTrajectory& trajectory) const;
+
+			const JointLimits& limits() const { return m_limits; }
+
+		private:
+			static const int BISECTION_STEPS = 24;
+
+			JointLimits m_limits;
+
+			struct Derivatives
+			{
+				PumaAngles First, Second;	//dq/ds, d2q/ds2
+			};
+
+			//Range of path accelerations allowed by acceleration limits at squared speed x; empty if min > max
+			void AccelerationRange(const Derivatives& d, float x, float& minAcc, float& maxAcc) const;
+			//Largest x allowed at a sample by velocity and acceleration limits
+			float MaxSpeedSquared(const Derivatives& d) const;
+		};
+	}
+}
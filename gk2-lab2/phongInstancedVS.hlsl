@@ -0,0 +1,44 @@
+cbuffer cbView : register(b1) //Vertex Shader constant buffer slot 1
+{
+	matrix viewMatrix;
+	matrix invViewMatrix;
+};
+
+cbuffer cbProj : register(b2) //Vertex Shader constant buffer slot 2
+{
+	matrix projMatrix;
+};
+
+struct VSInput
+{
+	float3 pos : POSITION;
+	float3 norm : NORMAL0;
+	//rows of the instance world matrix as stored by XMFLOAT4X4
+	float4 world0 : WORLD0;
+	float4 world1 : WORLD1;
+	float4 world2 : WORLD2;
+	float4 world3 : WORLD3;
+};
+
+struct PSInput
+{
+	float4 pos : SV_POSITION;
+	float3 worldPos : POSITION0;
+	float3 norm : NORMAL0;
+	float3 viewVec : TEXCOORD0;
+};
+
+//Same as phongVS, but the world matrix comes from the instance buffer instead of cbWorld
+PSInput main(VSInput i)
+{
+	PSInput o;
+	float4x4 worldMatrix = float4x4(i.world0, i.world1, i.world2, i.world3);
+	o.worldPos = mul(float4(i.pos, 1.0f), worldMatrix).xyz;
+	o.pos = mul(viewMatrix, float4(o.worldPos, 1.0f));
+	o.pos = mul(projMatrix, o.pos);
+	o.norm = mul(float4(i.norm, 0.0f), worldMatrix).xyz;
+	o.norm = normalize(o.norm);
+	float3 camPos = mul(invViewMatrix, float4(0.0f, 0.0f, 0.0f, 1.0f)).xyz;
+	o.viewVec = camPos - o.worldPos;
+	return o;
+}
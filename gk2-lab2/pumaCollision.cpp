@@ -0,0 +1,336 @@
+#include "pumaCollision.h"
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	const int BOX_SEARCH_STEPS = 24;
+	const int POWER_ITERATIONS = 32;
+
+	//Squared distance between segments p0p1 and q0q1 (Ericson, Real-Time Collision Detection 5.1.9)
+	float SegmentsDistanceSq(FXMVECTOR p0, FXMVECTOR p1, FXMVECTOR q0, GXMVECTOR q1)
+	{
+		auto d1 = XMVectorSubtract(p1, p0), d2 = XMVectorSubtract(q1, q0), r = XMVectorSubtract(p0, q0);
+		auto a = XMVectorGetX(XMVector3LengthSq(d1)), e = XMVectorGetX(XMVector3LengthSq(d2));
+		auto f = XMVectorGetX(XMVector3Dot(d2, r));
+		float s, t;
+		if (a <= FLT_EPSILON && e <= FLT_EPSILON)
+			s = t = 0.0f;
+		else if (a <= FLT_EPSILON)
+		{
+			s = 0.0f;
+			t = clamp(f / e, 0.0f, 1.0f);
+		}
+		else
+		{
+			auto c = XMVectorGetX(XMVector3Dot(d1, r));
+			if (e <= FLT_EPSILON)
+			{
+				t = 0.0f;
+				s = clamp(-c / a, 0.0f, 1.0f);
+			}
+			else
+			{
+				auto b = XMVectorGetX(XMVector3Dot(d1, d2));
+				auto denom = a * e - b * b;
+				s = denom > 0.0f ? clamp((b * f - c * e) / denom, 0.0f, 1.0f) : 0.0f;
+				t = (b * s + f) / e;
+				if (t < 0.0f)
+				{
+					t = 0.0f;
+					s = clamp(-c / a, 0.0f, 1.0f);
+				}
+				else if (t > 1.0f)
+				{
+					t = 1.0f;
+					s = clamp((b - c) / a, 0.0f, 1.0f);
+				}
+			}
+		}
+		auto p = XMVectorMultiplyAdd(d1, XMVectorReplicate(s), p0);
+		auto q = XMVectorMultiplyAdd(d2, XMVectorReplicate(t), q0);
+		return XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(p, q)));
+	}
+
+	//Squared distance from segment q0q1 to the box [-halfExtents, halfExtents]. The distance is convex along
+	//the segment, so a golden section search finds its minimum; the search stops early below stopBelow.
+	float SegmentBoxDistanceSq(FXMVECTOR q0, FXMVECTOR q1, FXMVECTOR halfExtents, float stopBelow)
+	{
+		auto distanceSq = [&](float t)
+		{
+			auto q = XMVectorLerp(q0, q1, t);
+			auto outside = XMVectorMax(XMVectorSubtract(XMVectorAbs(q), halfExtents), XMVectorZero());
+			return XMVectorGetX(XMVector3LengthSq(outside));
+		};
+		const auto ratio = 0.618034f;
+		auto best = min(distanceSq(0.0f), distanceSq(1.0f));
+		float lo = 0.0f, hi = 1.0f;
+		auto m0 = hi - ratio, m1 = lo + ratio;
+		auto f0 = distanceSq(m0), f1 = distanceSq(m1);
+		for (auto step = 0; step < BOX_SEARCH_STEPS && best >= stopBelow; ++step)
+		{
+			best = min(best, min(f0, f1));
+			if (f0 < f1)
+			{
+				hi = m1; m1 = m0; f1 = f0;
+				m0 = hi - ratio * (hi - lo);
+				f0 = distanceSq(m0);
+			}
+			else
+			{
+				lo = m0; m0 = m1; f0 = f1;
+				m1 = lo + ratio * (hi - lo);
+				f1 = distanceSq(m1);
+			}
+		}
+		return min(best, min(f0, f1));
+	}
+}
+
+Capsule Capsule::Fit(const MeshData& mesh)
+{
+	auto& points = mesh.Positions;
+	if (points.empty())
+		return { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, 0.0f };
+
+	auto mean = XMVectorZero();
+	for (auto& p : points)
+		mean = XMVectorAdd(mean, XMLoadFloat3(&p));
+	mean = XMVectorScale(mean, 1.0f / points.size());
+	float cov[3][3] = {};
+	for (auto& p : points)
+	{
+		XMFLOAT3 d;
+		XMStoreFloat3(&d, XMVectorSubtract(XMLoadFloat3(&p), mean));
+		for (auto i = 0; i < 3; ++i)
+			for (auto j = 0; j < 3; ++j)
+				cov[i][j] += (&d.x)[i] * (&d.x)[j];
+	}
+
+	//principal axes: eigenvectors of the covariance matrix found by power iteration with deflation
+	XMFLOAT3 axes[3];
+	for (auto k = 0; k < 2; ++k)
+	{
+		float v[3] = { 1.0f, 0.7f, 0.4f }, lambda = 0.0f;
+		for (auto it = 0; it < POWER_ITERATIONS; ++it)
+		{
+			float next[3];
+			for (auto i = 0; i < 3; ++i)
+				next[i] = cov[i][0] * v[0] + cov[i][1] * v[1] + cov[i][2] * v[2];
+			lambda = sqrtf(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+			if (lambda == 0.0f)
+				break;
+			for (auto i = 0; i < 3; ++i)
+				v[i] = next[i] / lambda;
+		}
+		XMStoreFloat3(&axes[k], XMVector3Normalize(XMVectorSet(v[0], v[1], v[2], 0.0f)));
+		for (auto i = 0; i < 3; ++i)
+			for (auto j = 0; j < 3; ++j)
+				cov[i][j] -= lambda * v[i] * v[j];
+	}
+	XMStoreFloat3(&axes[2], XMVector3Normalize(XMVector3Cross(XMLoadFloat3(&axes[0]), XMLoadFloat3(&axes[1]))));
+
+	//the longest axis doesn't give the smallest capsule for flat meshes, so all three are tried
+	Capsule best;
+	auto bestVolume = FLT_MAX;
+	vector<XMFLOAT2> local(points.size());	//position along the axis, squared distance from it
+	for (auto& a : axes)
+	{
+		auto axis = XMLoadFloat3(&a);
+		if (XMVector3IsNaN(axis))
+			continue;
+		//radius covers the farthest vertex from the axis, then the segment shrinks as much as the caps allow
+		auto radiusSq = 0.0f;
+		for (size_t i = 0; i < points.size(); ++i)
+		{
+			auto d = XMVectorSubtract(XMLoadFloat3(&points[i]), mean);
+			auto t = XMVectorGetX(XMVector3Dot(d, axis));
+			auto distSq = max(XMVectorGetX(XMVector3LengthSq(d)) - t * t, 0.0f);
+			local[i] = { t, distSq };
+			radiusSq = max(radiusSq, distSq);
+		}
+		auto begin = FLT_MAX, end = -FLT_MAX;
+		for (auto& l : local)
+		{
+			auto cap = sqrtf(max(radiusSq - l.y, 0.0f));
+			begin = min(begin, l.x + cap);
+			end = max(end, l.x - cap);
+		}
+		//every vertex fits in a sphere centered between the two if they cross
+		if (begin > end)
+			begin = end = 0.5f * (begin + end);
+		auto radius = sqrtf(radiusSq);
+		auto volume = XM_PI * radiusSq * (end - begin + 4.0f / 3.0f * radius);
+		if (volume >= bestVolume)
+			continue;
+		bestVolume = volume;
+		XMStoreFloat3(&best.P0, XMVectorMultiplyAdd(axis, XMVectorReplicate(begin), mean));
+		XMStoreFloat3(&best.P1, XMVectorMultiplyAdd(axis, XMVectorReplicate(end), mean));
+		best.Radius = radius;
+	}
+	return best;
+}
+
+PumaCollision::PumaCollision(float margin)
+	: m_margin(margin), m_capsules{}, m_selfPairs{}
+{ }
+
+void PumaCollision::FitLinks(const MeshData (&meshes)[LINKS_COUNT])
+{
+	for (auto i = 0U; i < LINKS_COUNT; ++i)
+		m_capsules[i] = Capsule::Fit(meshes[i]);
+	//neighbouring links always touch at their joint, others only if their proxies overlap by design
+	for (auto i = 0U; i < LINKS_COUNT; ++i)
+	{
+		m_selfPairs[i] = 0;
+		for (auto j = i + 2; j < LINKS_COUNT; ++j)
+		{
+			auto& a = m_capsules[i];
+			auto& b = m_capsules[j];
+			auto r = a.Radius + b.Radius + m_margin;
+			if (SegmentsDistanceSq(XMLoadFloat3(&a.P0), XMLoadFloat3(&a.P1), XMLoadFloat3(&b.P0), XMLoadFloat3(&b.P1)) > r * r)
+				m_selfPairs[i] |= 1U << j;
+		}
+	}
+}
+
+void PumaCollision::AddPlane(XMFLOAT3 point, XMFLOAT3 normal)
+{
+	auto n = XMVector3Normalize(XMLoadFloat3(&normal));
+	Plane p;
+	XMStoreFloat3(&p.Normal, n);
+	p.D = -XMVectorGetX(XMVector3Dot(n, XMLoadFloat3(&point)));
+	m_planes.push_back(p);
+}
+
+void PumaCollision::AddPlane(const XMFLOAT4X4& worldMtx)
+{
+	auto m = XMLoadFloat4x4(&worldMtx);
+	XMFLOAT3 point, normal;
+	XMStoreFloat3(&point, XMVector3TransformCoord(XMVectorZero(), m));
+	XMStoreFloat3(&normal, XMVector3TransformNormal(XMVectorSet(0.0f, 0.0f, -1.0f, 0.0f), m));
+	AddPlane(point, normal);
+}
+
+void PumaCollision::AddBox(const XMFLOAT4X4& worldMtx, XMFLOAT3 halfExtents)
+{
+	auto m = XMLoadFloat4x4(&worldMtx);
+	Box b;
+	XMStoreFloat3(&b.Center, m.r[3]);
+	for (auto i = 0; i < 3; ++i)
+	{
+		//rows of a row-vector world matrix are the transformed local axes, scale is folded into extents
+		auto len = XMVectorGetX(XMVector3Length(m.r[i]));
+		XMStoreFloat3(&b.Axes[i], XMVectorScale(m.r[i], 1.0f / len));
+		(&b.HalfExtents.x)[i] = (&halfExtents.x)[i] * len;
+	}
+	m_boxes.push_back(b);
+}
+
+void PumaCollision::Transform(const XMFLOAT4X4 (&linkMtx)[LINKS_COUNT], Capsule (&world)[LINKS_COUNT]) const
+{
+	for (auto i = 0U; i < LINKS_COUNT; ++i)
+	{
+		auto m = XMLoadFloat4x4(&linkMtx[i]);
+		XMStoreFloat3(&world[i].P0, XMVector3TransformCoord(XMLoadFloat3(&m_capsules[i].P0), m));
+		XMStoreFloat3(&world[i].P1, XMVector3TransformCoord(XMLoadFloat3(&m_capsules[i].P1), m));
+		world[i].Radius = m_capsules[i].Radius + m_margin;
+	}
+}
+
+unsigned int PumaCollision::Test(const Capsule (&world)[LINKS_COUNT], unsigned int links) const
+{
+	unsigned int result = 0;
+	for (auto i = 0U; i < LINKS_COUNT; ++i)
+	{
+		if (!(links & (1U << i)))
+			continue;
+		auto& c = world[i];
+		auto p0 = XMLoadFloat3(&c.P0), p1 = XMLoadFloat3(&c.P1);
+		auto hit = false;
+
+		//the capsule is on the allowed side if both ends of its segment are at least radius away
+		for (auto& plane : m_planes)
+		{
+			auto n = XMLoadFloat3(&plane.Normal);
+			auto d0 = XMVectorGetX(XMVector3Dot(n, p0)), d1 = XMVectorGetX(XMVector3Dot(n, p1));
+			if (min(d0, d1) + plane.D < c.Radius)
+			{
+				hit = true;
+				break;
+			}
+		}
+
+		for (auto b = m_boxes.begin(); !hit && b != m_boxes.end(); ++b)
+		{
+			auto center = XMLoadFloat3(&b->Center);
+			//box space with the box at the origin; the axes are orthonormal, so the transpose is the inverse
+			auto axes = XMMatrixTranspose(XMMATRIX(XMLoadFloat3(&b->Axes[0]), XMLoadFloat3(&b->Axes[1]),
+				XMLoadFloat3(&b->Axes[2]), XMVectorZero()));
+			auto q0 = XMVector3TransformNormal(XMVectorSubtract(p0, center), axes);
+			auto q1 = XMVector3TransformNormal(XMVectorSubtract(p1, center), axes);
+			hit = SegmentBoxDistanceSq(q0, q1, XMLoadFloat3(&b->HalfExtents), c.Radius * c.Radius) < c.Radius * c.Radius;
+		}
+		if (hit)
+			result |= 1U << i;
+	}
+
+	for (auto i = 0U; i < LINKS_COUNT; ++i)
+		for (auto j = i + 2; j < LINKS_COUNT; ++j)
+		{
+			auto pair = (1U << i) | (1U << j);
+			if (!(m_selfPairs[i] & (1U << j)) || !(links & pair) || (result & pair & links) == (pair & links))
+				continue;
+			auto& a = world[i];
+			auto& o = world[j];
+			auto r = a.Radius + o.Radius - m_margin;
+			if (SegmentsDistanceSq(XMLoadFloat3(&a.P0), XMLoadFloat3(&a.P1), XMLoadFloat3(&o.P0), XMLoadFloat3(&o.P1)) < r * r)
+				result |= pair & links;
+		}
+	return result;
+}
+unsigned int PumaCollision::CollidingLinks(const XMFLOAT4X4 (&linkMtx)[LINKS_COUNT], unsigned int links) const
+{
+	Capsule world[LINKS_COUNT];
+	Transform(linkMtx, world);
+	return Test(world, links);
+}
+
+unsigned int PumaCollision::CollidingLinks(const PumaAngles& angles, unsigned int links) const
+{
+	XMFLOAT4X4 linkMtx[LINKS_COUNT];
+	XMStoreFloat4x4(&linkMtx[0], XMMatrixIdentity());
+	PumaKinematics::LinkMatrices(angles, reinterpret_cast<XMFLOAT4X4(&)[PumaKinematics::JOINTS_COUNT]>(linkMtx[1]));
+	return CollidingLinks(linkMtx, links);
+}
+
+size_t PumaCollision::CollidingLinksBatch(size_t count, const PumaAngles* angles, uint8_t* collides, unsigned int links) const
+{
+	atomic<size_t> colliding{ 0 };
+	ParallelFor(count, [&](size_t begin, size_t end)
+	{
+		auto chain = PumaKinematics::Chain();
+		XMFLOAT4X4 linkMtx[LINKS_COUNT];
+		XMStoreFloat4x4(&linkMtx[0], XMMatrixIdentity());
+		size_t local = 0;
+		for (auto i = begin; i < end; ++i)
+		{
+			chain.SetAngles(angles[i].data());
+			chain.Update();
+			copy(chain.linkMatrices(), chain.linkMatrices() + PumaKinematics::JOINTS_COUNT, linkMtx + 1);
+			collides[i] = static_cast<uint8_t>(CollidingLinks(linkMtx, links));
+			if (collides[i])
+				++local;
+		}
+		colliding += local;
+	}, 64);
+	return colliding;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+#include "meshData.h"
+#include "pumaKinematics.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Segment swept by a sphere
+		struct Capsule
+		{
+			DirectX::XMFLOAT3 P0, P1;
+			float Radius;
+
+			//Smallest capsule containing all mesh vertices among the tightest ones along each of their three principal axes
+			static Capsule Fit(const MeshData& mesh);
+		};
+
+		//Collision proxies of the PUMA links tested against static room geometry.
+		//Every link mesh is wrapped in a capsule at load time, so tests against planes are closed form and
+		//tests against boxes minimize the convex distance from the capsule axis to the box. Link pairs
+		//that are not neighbours are tested against each other too, unless they overlap in the rest pose.
+		class PumaCollision
+		{
+		public:
+			static const unsigned int LINKS_COUNT = PumaKinematics::JOINTS_COUNT + 1;	//base and links moved by the joints
+			static const unsigned int TOOL_LINK = LINKS_COUNT - 1;
+			static const unsigned int ALL_LINKS = (1U << LINKS_COUNT) - 1;
+
+			explicit PumaCollision(float margin = 0.0f);
+
+			//meshes - the link meshes in the rest pose, in the order of RoomDemo::m_puma
+			void FitLinks(const MeshData (&meshes)[LINKS_COUNT]);
+
+			//Plane through point with normal pointing to the side the arm is allowed in
+			void AddPlane(DirectX::XMFLOAT3 point, DirectX::XMFLOAT3 normal);
+			//Plane of a mesh lying in local XY plane with normal (0,0,-1), e.g. Mesh::Rectangle
+			void AddPlane(const DirectX::XMFLOAT4X4& worldMtx);
+			//Box of given half extents in local space transformed by worldMtx (rotation and translation only)
+			void AddBox(const DirectX::XMFLOAT4X4& worldMtx, DirectX::XMFLOAT3 halfExtents);
+
+			//Links among the links mask that touch the room or another link, as a mask with bit per link.
+			//linkMtx - world matrices of all links, as RoomDemo::m_pumaMtx
+			unsigned int CollidingLinks(const DirectX::XMFLOAT4X4 (&linkMtx)[LINKS_COUNT], unsigned int links = ALL_LINKS) const;
+			unsigned int CollidingLinks(const PumaAngles& angles, unsigned int links = ALL_LINKS) const;
+			//Tests count configurations split between threads; collides[i] is set to the mask of colliding links.
+			//Consecutive configurations sharing leading joint angles reuse their link matrices.
+			//Returns the number of configurations in collision.
+			size_t CollidingLinksBatch(size_t count, const PumaAngles* angles, uint8_t* collides, unsigned int links = ALL_LINKS) const;
+
+			const Capsule& capsule(unsigned int link) const { return m_capsules[link]; }
+
+		private:
+			struct Plane
+			{
+				DirectX::XMFLOAT3 Normal;
+				float D;
+			};
+
+			struct Box
+			{
+				DirectX::XMFLOAT3 Center;
+				DirectX::XMFLOAT3 Axes[3];	//unit local axes in world space
+				DirectX::XMFLOAT3 HalfExtents;
+			};
+
+			float m_margin;
+			Capsule m_capsules[LINKS_COUNT];
+			unsigned int m_selfPairs[LINKS_COUNT];	//for each link, mask of later links it's tested against
+			std::vector<Plane> m_planes;
+			std::vector<Box> m_boxes;
+
+			//Capsules in world space
+			void Transform(const DirectX::XMFLOAT4X4 (&linkMtx)[LINKS_COUNT], Capsule (&world)[LINKS_COUNT]) const;
+			unsigned int Test(const Capsule (&world)[LINKS_COUNT], unsigned int links) const;
+		};
+	}
+}
@@ -0,0 +1,78 @@
+#include "pumaDynamics.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+const float PumaDynamics::DENSITY = 1000.0f;
+
+namespace
+{
+	array<RigidBodyInertia, PumaKinematics::JOINTS_COUNT> MeshInertias(const MeshData (&meshes)[PumaDynamics::LINKS_COUNT],
+		float density)
+	{
+		array<RigidBodyInertia, PumaKinematics::JOINTS_COUNT> links;
+		for (size_t j = 0; j < links.size(); ++j)
+			links[j] = RigidBodyInertia::FromMesh(meshes[j + 1], density);
+		return links;
+	}
+}
+
+PumaDynamics::PumaDynamics(const array<RigidBodyInertia, PumaKinematics::JOINTS_COUNT>& links)
+	: ChainDynamics(PumaKinematics::Chain(), links)
+{ }
+
+PumaDynamics::PumaDynamics(const MeshData (&meshes)[LINKS_COUNT], float density)
+	: PumaDynamics(MeshInertias(meshes, density))
+{ }
+
+void PumaDynamics::Torques(const JointTrajectory& trajectory, float step, TrajectoryTorques& result) const
+{
+	result.Step = step;
+	result.Peak.fill(0.0f);
+	auto& times = trajectory.times();
+	auto& angles = trajectory.angles();
+	auto keys = times.size();
+	//velocity at a key is the average of the slopes of its two segments, each weighted by the duration of the other
+	//one, which is exact if the acceleration is constant across the key. The arm rests at the first and last key.
+	vector<PumaAngles> velocities(keys, PumaAngles{});
+	for (size_t k = 1; k + 1 < keys; ++k)
+	{
+		auto before = times[k] - times[k - 1], after = times[k + 1] - times[k];
+		if (before <= 0.0f || after <= 0.0f)
+			continue;
+		for (size_t j = 0; j < PumaKinematics::JOINTS_COUNT; ++j)
+			velocities[k][j] = ((angles[k][j] - angles[k - 1][j]) * after / before
+				+ (angles[k + 1][j] - angles[k][j]) * before / after) / (before + after);
+	}
+
+	auto count = trajectory.empty() ? 0 : static_cast<size_t>(ceilf(trajectory.duration() / step)) + 1;
+	vector<PumaAngles> q(count), qd(count, PumaAngles{}), qdd(count, PumaAngles{});
+	size_t cursor = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		auto time = min(i * step, trajectory.duration());
+		q[i] = trajectory.Sample(time, cursor);
+		if (keys < 2)
+			continue;
+		//the acceleration is constant between keys, so it doesn't depend on step
+		auto k = min(cursor, keys - 2);
+		auto span = times[k + 1] - times[k];
+		if (span <= 0.0f)
+			continue;
+		auto t = clamp(time - times[k], 0.0f, span);
+		for (size_t j = 0; j < PumaKinematics::JOINTS_COUNT; ++j)
+		{
+			qdd[i][j] = (velocities[k + 1][j] - velocities[k][j]) / span;
+			qd[i][j] = velocities[k][j] + qdd[i][j] * t;
+		}
+	}
+	result.Torques.resize(count);
+	InverseDynamicsBatch(count, q.data(), qd.data(), qdd.data(), result.Torques.data());
+	for (auto& tau : result.Torques)
+		for (size_t j = 0; j < tau.size(); ++j)
+			result.Peak[j] = max(result.Peak[j], fabsf(tau[j]));
+}
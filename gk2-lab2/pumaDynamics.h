@@ -0,0 +1,39 @@
+#pragma once
+#include <vector>
+#include "chainDynamics.h"
+#include "jointTrajectory.h"
+#include "pumaKinematics.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Joint torques needed to follow a trajectory, sampled every Step seconds
+		struct TrajectoryTorques
+		{
+			float Step;
+			std::vector<PumaAngles> Torques;
+			PumaAngles Peak;	//largest magnitude of every joint's torque
+		};
+
+		//Dynamics of the PUMA arm with inertias of the link meshes or configured ones
+		class PumaDynamics : public ChainDynamics<PumaKinematics::JOINTS_COUNT>
+		{
+		public:
+			static const unsigned int LINKS_COUNT = PumaKinematics::JOINTS_COUNT + 1;	//base and links moved by the joints
+
+			explicit PumaDynamics(const std::array<RigidBodyInertia, PumaKinematics::JOINTS_COUNT>& links);
+			//meshes - the link meshes in the rest pose, in the order of RoomDemo::m_puma; the base doesn't move
+			//and is skipped. Links are treated as solids of uniform density (kg/m^3).
+			explicit PumaDynamics(const MeshData (&meshes)[LINKS_COUNT], float density = DENSITY);
+
+			//Torques along the trajectory sampled every step seconds. Keys are taken as samples of a motion starting
+			//and ending at rest with constant accelerations between keys, like the timing of PathParameterization,
+			//so velocities and accelerations follow from the keys and step only has to be short enough not to skip
+			//segments between them.
+			void Torques(const JointTrajectory& trajectory, float step, TrajectoryTorques& result) const;
+
+			static const float DENSITY;
+		};
+	}
+}
@@ -0,0 +1,130 @@
+#include "pumaIKCache.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+const float PumaIKCache::MAX_STEP = 0.5f;
+const float PumaIKCache::CELL_SIZE = 0.05f;
+
+namespace
+{
+	float WrapAngle(float a)
+	{
+		return a - XM_2PI * floorf((a + XM_PI) / XM_2PI);
+	}
+
+	//Unwraps angles to the turn nearest to current and returns the largest joint change
+	float Unwrap(const PumaAngles& current, PumaAngles& angles)
+	{
+		auto step = 0.0f;
+		for (size_t j = 0; j < angles.size(); ++j)
+		{
+			auto d = WrapAngle(angles[j] - current[j]);
+			angles[j] = current[j] + d;
+			step = max(step, fabsf(d));
+		}
+		return step;
+	}
+}
+
+PumaIKCache::PumaIKCache(float maxStep, float cellSize)
+	: m_maxStep(maxStep), m_invCellSize(1.0f / cellSize), m_branch(NO_BRANCH), m_table(TABLE_SIZE, Entry{ 0, NO_BRANCH })
+{ }
+
+uint32_t PumaIKCache::Key(XMFLOAT3 position, XMFLOAT3 normal) const
+{
+	auto cell = [this](float x) { return static_cast<uint32_t>(static_cast<int>(floorf(x * m_invCellSize))); };
+	//normals are quantized coarsely, a branch usually covers a wide cone of them
+	auto dir = [](float x) { return static_cast<uint32_t>(lroundf(2.0f * x) + 2); };
+	return (cell(position.x) * 73856093U) ^ (cell(position.y) * 19349663U) ^ (cell(position.z) * 83492791U) ^
+		((dir(normal.x) * 25 + dir(normal.y) * 5 + dir(normal.z)) * 2654435761U);
+}
+
+bool PumaIKCache::SolveNear(XMFLOAT3 position, XMFLOAT3 normal, unsigned int branch, float maxStep,
+	const PumaAngles& current, PumaAngles& angles, unsigned int& solved) const
+{
+	const unsigned int branches[4] = { branch, branch ^ PumaKinematics::WristFlip,
+		branch ^ PumaKinematics::ElbowFlip, branch ^ PumaKinematics::ShoulderFlip };
+	PumaAngles solutions[4];
+	auto mask = PumaKinematics::SolveBranches(position, normal, branches, solutions);
+	auto best = maxStep;
+	auto found = false;
+	for (auto lane = 0U; lane < 4; ++lane)
+	{
+		if (!(mask & (1U << lane)))
+			continue;
+		auto step = Unwrap(current, solutions[lane]);
+		if (step <= best)
+		{
+			best = step;
+			angles = solutions[lane];
+			solved = branches[lane];
+			found = true;
+		}
+	}
+	return found;
+}
+
+bool PumaIKCache::Solve(XMFLOAT3 position, XMFLOAT3 normal, const PumaAngles& current, PumaAngles& angles)
+{
+	++m_stats.queries;
+	auto key = Key(position, normal);
+	auto& entry = m_table[key & (TABLE_SIZE - 1)];
+	auto solved = NO_BRANCH;
+	if (m_branch != NO_BRANCH && SolveNear(position, normal, m_branch, m_maxStep, current, angles, solved))
+		++m_stats.coherent;
+	//after a jump no branch is near, so the one used in the cell before is taken however far it is
+	else if (entry.Branch != NO_BRANCH && entry.Key == key &&
+		SolveNear(position, normal, entry.Branch, FLT_MAX, current, angles, solved))
+		++m_stats.tableHits;
+	else
+	{
+		PumaAngles solutions[PumaKinematics::MAX_SOLUTIONS];
+		unsigned int branches[PumaKinematics::MAX_SOLUTIONS];
+		auto count = PumaKinematics::SolveAll(position, normal, solutions, branches);
+		if (count == 0)
+		{
+			++m_stats.unreachable;
+			return false;
+		}
+		++m_stats.fullSolves;
+		auto best = FLT_MAX;
+		for (auto i = 0U; i < count; ++i)
+		{
+			auto step = Unwrap(current, solutions[i]);
+			if (step < best)
+			{
+				best = step;
+				angles = solutions[i];
+				solved = branches[i];
+			}
+		}
+	}
+	m_branch = solved;
+	entry = { key, static_cast<uint8_t>(solved) };
+	return true;
+}
+
+size_t PumaIKCache::SolveSequence(size_t count, const XMFLOAT3* positions, const XMFLOAT3* normals,
+	const PumaAngles& start, PumaAngles* angles, uint8_t* reachable)
+{
+	auto current = start;
+	size_t solved = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		reachable[i] = Solve(positions[i], normals[i], current, angles[i]) ? 1 : 0;
+		if (reachable[i])
+		{
+			current = angles[i];
+			++solved;
+		}
+		else
+			angles[i] = current;
+	}
+	return solved;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+#include "pumaKinematics.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Counters of PumaIKCache::Solve calls since the last reset
+		struct PumaIKCacheStats
+		{
+			size_t queries;
+			size_t coherent;	//solved in the branch of the previous solution or a neighbouring one
+			size_t tableHits;	//solved in the branch remembered for the target's cell
+			size_t fullSolves;	//needed all eight branches
+			size_t unreachable;
+
+			PumaIKCacheStats() : queries(0), coherent(0), tableHits(0), fullSolves(0), unreachable(0) { }
+
+			//Fraction of queries answered without solving all branches
+			float hitRate() const { return queries ? static_cast<float>(coherent + tableHits) / queries : 0.0f; }
+		};
+
+		//IK front-end for targets that move continuously, e.g. along a path or under interactive control.
+		//Consecutive targets are close, so the branch of the previous solution and the three branches differing
+		//from it by a single flip are solved in one vector block and the one closest to the current configuration
+		//is taken. If none of them is within a step of it, e.g. after a jump, the branch last used in the target's
+		//cell of a small hash table and its neighbours are tried without the step limit, and only then all branches.
+		//Angles are unwrapped to the nearest turn of the current ones.
+		//Not thread safe; use one cache per thread.
+		class PumaIKCache
+		{
+		public:
+			explicit PumaIKCache(float maxStep = MAX_STEP, float cellSize = CELL_SIZE);
+
+			//Solution closest to current; returns false if the target is out of reach
+			bool Solve(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 normal, const PumaAngles& current, PumaAngles& angles);
+			//Solves count targets in order, each from the solution of the previous one, starting from start.
+			//reachable[i] is set to 1 for targets in reach (unreachable ones repeat the previous angles).
+			//Returns the number of reachable targets.
+			size_t SolveSequence(size_t count, const DirectX::XMFLOAT3* positions, const DirectX::XMFLOAT3* normals,
+				const PumaAngles& start, PumaAngles* angles, uint8_t* reachable);
+
+			//Forgets the previous branch, e.g. when the arm was moved by other means; the table is kept
+			void Reset() { m_branch = NO_BRANCH; }
+			void ResetStats() { m_stats = PumaIKCacheStats(); }
+
+			const PumaIKCacheStats& stats() const { return m_stats; }
+			unsigned int branch() const { return m_branch; }
+
+			static const float MAX_STEP;	//largest joint change accepted without a full solve
+			static const float CELL_SIZE;	//size of the table cells
+
+		private:
+			static const unsigned int NO_BRANCH = PumaKinematics::MAX_SOLUTIONS;
+			static const size_t TABLE_SIZE = 4096;	//power of two
+
+			struct Entry
+			{
+				uint32_t Key;
+				uint8_t Branch;
+			};
+
+			float m_maxStep;
+			float m_invCellSize;
+			unsigned int m_branch;
+			std::vector<Entry> m_table;
+			PumaIKCacheStats m_stats;
+
+			uint32_t Key(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 normal) const;
+			//Closest solution among branch and its single flip neighbours if within maxStep of current
+			bool SolveNear(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 normal, unsigned int branch, float maxStep,
+				const PumaAngles& current, PumaAngles& angles, unsigned int& solved) const;
+		};
+	}
+}
@@ -0,0 +1,121 @@
+#include "pumaInstances.h"
+#include "parallel.h"
+#include <algorithm>
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+PumaInstancePacker::PumaInstancePacker()
+{
+	auto chain = PumaKinematics::Chain();
+	for (size_t j = 0; j < chain.jointsCount(); ++j)
+		m_joints.push_back(chain.joint(j));
+}
+
+void XM_CALLCONV PumaInstancePacker::Multiply(const MatrixBlock& a, const MatrixBlock& b, MatrixBlock& result)
+{
+	MatrixBlock r;
+	for (auto i = 0; i < 4; ++i)
+		for (auto k = 0; k < 3; ++k)
+		{
+			auto sum = XMVectorMultiply(a.m[i][0], b.m[0][k]);
+			sum = XMVectorMultiplyAdd(a.m[i][1], b.m[1][k], sum);
+			sum = XMVectorMultiplyAdd(a.m[i][2], b.m[2][k], sum);
+			//the last column of affine matrices is (0,0,0,1), so only the translation row adds b's translation
+			r.m[i][k] = i == 3 ? XMVectorAdd(sum, b.m[3][k]) : sum;
+		}
+	result = r;
+}
+
+void XM_CALLCONV PumaInstancePacker::LocalBlock(size_t joint, FXMVECTOR angles, MatrixBlock& result) const
+{
+	auto& a = m_joints[joint].Axis;
+	auto& p = m_joints[joint].Pivot;
+	XMVECTOR s, c;
+	XMVectorSinCos(&s, &c, angles);
+	auto oneMinusC = XMVectorSubtract(XMVectorSplatOne(), c);
+	const float axis[3] = { a.x, a.y, a.z };
+	//XMMatrixRotationNormal: R[i][k] = c d(i,k) + (1 - c) a[i] a[k] + s e(i,k,m) a[m]
+	for (auto i = 0; i < 3; ++i)
+		for (auto k = 0; k < 3; ++k)
+		{
+			auto r = XMVectorScale(oneMinusC, axis[i] * axis[k]);
+			if (i == k)
+				r = XMVectorAdd(r, c);
+			else
+			{
+				auto m = 3 - i - k;
+				//e(i,k,m) is 1 for cyclic (i,k,m) and -1 otherwise
+				auto sign = (k == (i + 1) % 3) ? 1.0f : -1.0f;
+				r = XMVectorAdd(r, XMVectorScale(s, sign * axis[m]));
+			}
+			result.m[i][k] = r;
+		}
+	//rotation about the pivot: translation p - p R
+	const float pivot[3] = { p.x, p.y, p.z };
+	for (auto k = 0; k < 3; ++k)
+	{
+		auto t = XMVectorReplicate(pivot[k]);
+		for (auto i = 0; i < 3; ++i)
+			t = XMVectorSubtract(t, XMVectorScale(result.m[i][k], pivot[i]));
+		result.m[3][k] = t;
+	}
+}
+
+void PumaInstancePacker::Pack(size_t count, const PumaAngles* angles, const XMFLOAT4X4* placements, XMFLOAT4X4* instances) const
+{
+	auto blocks = (count + LANES - 1) / LANES;
+	ParallelFor(blocks, [&](size_t begin, size_t end)
+	{
+		for (auto b = begin; b < end; ++b)
+		{
+			//the last, partial block repeats its first robot in the unused lanes
+			auto first = LANES * b, lanes = min(LANES, count - first);
+			size_t robot[LANES];
+			for (size_t l = 0; l < LANES; ++l)
+				robot[l] = first + (l < lanes ? l : 0);
+
+			MatrixBlock base;
+			for (auto i = 0; i < 4; ++i)
+				for (auto k = 0; k < 3; ++k)
+				{
+					float v[LANES];
+					for (size_t l = 0; l < LANES; ++l)
+						v[l] = placements ? placements[robot[l]].m[i][k] : (i == k ? 1.0f : 0.0f);
+					base.m[i][k] = XMVectorSet(v[0], v[1], v[2], v[3]);
+				}
+
+			MatrixBlock links[LINKS_COUNT];
+			links[0] = base;
+			for (size_t j = 0; j < m_joints.size(); ++j)
+			{
+				auto a = XMVectorSet(angles[robot[0]][j], angles[robot[1]][j], angles[robot[2]][j], angles[robot[3]][j]);
+				MatrixBlock local;
+				LocalBlock(j, a, local);
+				auto parent = m_joints[j].Parent;
+				//links of the chain are world matrices of the robot at the origin, the base placement goes last
+				Multiply(local, links[parent < 0 ? 0 : parent + 1], links[j + 1]);
+			}
+
+			for (auto link = 0U; link < LINKS_COUNT; ++link)
+			{
+				XMFLOAT4 rows[4][3];
+				for (auto i = 0; i < 4; ++i)
+					for (auto k = 0; k < 3; ++k)
+						XMStoreFloat4(&rows[i][k], links[link].m[i][k]);
+				for (size_t l = 0; l < lanes; ++l)
+				{
+					auto& out = instances[FirstInstance(link, count) + first + l];
+					for (auto i = 0; i < 4; ++i)
+					{
+						for (auto k = 0; k < 3; ++k)
+							out.m[i][k] = (&rows[i][k].x)[l];
+						out.m[i][3] = i == 3 ? 1.0f : 0.0f;
+					}
+				}
+			}
+		}
+	}, 64);
+}
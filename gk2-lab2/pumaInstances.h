@@ -0,0 +1,50 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include "pumaKinematics.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Packs world matrices of the links of many PUMA arms into instance data for Mesh::RenderInstanced.
+		//Instances are grouped by link: link 0 of all robots first, then link 1 of all robots and so on, so every
+		//link mesh is drawn with a single call starting at FirstInstance. Forward kinematics runs for four robots
+		//at once, one per vector lane, and blocks of robots are split between threads. Doesn't need Direct3D.
+		class PumaInstancePacker
+		{
+		public:
+			static const unsigned int LINKS_COUNT = PumaKinematics::JOINTS_COUNT + 1;	//base and links moved by the joints
+
+			PumaInstancePacker();
+
+			//placements - world matrix of every robot's base, null places all of them at the origin
+			//instances - LINKS_COUNT * count matrices
+			void Pack(size_t count, const PumaAngles* angles, const DirectX::XMFLOAT4X4* placements,
+				DirectX::XMFLOAT4X4* instances) const;
+			void Pack(size_t count, const PumaAngles* angles, const DirectX::XMFLOAT4X4* placements,
+				std::vector<DirectX::XMFLOAT4X4>& instances) const
+			{
+				instances.resize(LINKS_COUNT * count);
+				Pack(count, angles, placements, instances.data());
+			}
+
+			static size_t FirstInstance(unsigned int link, size_t count) { return link * count; }
+
+		private:
+			static const size_t LANES = 4;
+
+			//Affine matrix of four robots: rows of the upper 3x4 part of XMFLOAT4X4, one robot per lane
+			struct MatrixBlock
+			{
+				DirectX::XMVECTOR m[4][3];
+			};
+
+			std::vector<JointDescriptor> m_joints;
+
+			static void XM_CALLCONV Multiply(const MatrixBlock& a, const MatrixBlock& b, MatrixBlock& result);
+			//Rotation of the joint by four angles about its pivot
+			void XM_CALLCONV LocalBlock(size_t joint, DirectX::FXMVECTOR angles, MatrixBlock& result) const;
+		};
+	}
+}
@@ -0,0 +1,228 @@
+#include "pumaKinematics.h"
+#include "parallel.h"
+#include <algorithm>
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+const float PumaKinematics::L1 = 0.91f;
+const float PumaKinematics::L2 = 0.81f;
+const float PumaKinematics::L3 = 0.33f;
+const float PumaKinematics::DY = 0.27f;
+const float PumaKinematics::DZ = 0.26f;
+
+namespace
+{
+	struct TargetBlock
+	{
+		XMVECTOR px, py, pz, nx, ny, nz;
+	};
+
+	//Lane-wise signs of a branch: -1 where the branch bit is set, 1 otherwise
+	XMVECTOR BranchSigns(const unsigned int (&branches)[4], unsigned int bit)
+	{
+		return XMVectorSet(branches[0] & bit ? -1.0f : 1.0f, branches[1] & bit ? -1.0f : 1.0f,
+			branches[2] & bit ? -1.0f : 1.0f, branches[3] & bit ? -1.0f : 1.0f);
+	}
+
+	//Angles of four targets at once, each lane in its own branch. Returns mask of reachable lanes.
+	XMVECTOR SolveBlock(const TargetBlock& t, const unsigned int (&branches)[4], XMVECTOR (&a)[PumaKinematics::JOINTS_COUNT])
+	{
+		const auto l1 = PumaKinematics::L1, l2 = PumaKinematics::L2, l3 = PumaKinematics::L3;
+		const auto dy = PumaKinematics::DY, dz = PumaKinematics::DZ;
+		auto shoulder = BranchSigns(branches, PumaKinematics::ShoulderFlip);
+		auto elbow = BranchSigns(branches, PumaKinematics::ElbowFlip);
+		auto wrist = BranchSigns(branches, PumaKinematics::WristFlip);
+		auto zero = XMVectorZero();
+
+		auto nLenSq = XMVectorAdd(XMVectorMultiply(t.nx, t.nx), XMVectorAdd(XMVectorMultiply(t.ny, t.ny), XMVectorMultiply(t.nz, t.nz)));
+		auto valid = XMVectorGreater(nLenSq, zero);
+		auto nInv = XMVectorReciprocalSqrt(XMVectorSelect(XMVectorSplatOne(), nLenSq, valid));
+		auto nx = XMVectorMultiply(t.nx, nInv), ny = XMVectorMultiply(t.ny, nInv), nz = XMVectorMultiply(t.nz, nInv);
+
+		//wrist center lies l3 from the tip along the normal
+		auto cx = XMVectorMultiplyAdd(nx, XMVectorReplicate(l3), t.px);
+		auto cy = XMVectorMultiplyAdd(ny, XMVectorReplicate(l3), t.py);
+		auto cz = XMVectorMultiplyAdd(nz, XMVectorReplicate(l3), t.pz);
+
+		//base: wrist center is at distance u along -x and dz along -z in the arm's plane
+		auto uSq = XMVectorSubtract(XMVectorAdd(XMVectorMultiply(cx, cx), XMVectorMultiply(cz, cz)), XMVectorReplicate(dz * dz));
+		//small tolerances accept targets at the boundary of the workspace despite rounding errors
+		valid = XMVectorAndInt(valid, XMVectorGreaterOrEqual(uSq, XMVectorReplicate(-1e-5f)));
+		auto u = XMVectorMultiply(XMVectorNegate(shoulder), XMVectorSqrt(XMVectorMax(uSq, zero)));
+		auto vdz = XMVectorReplicate(dz);
+		a[0] = XMVectorATan2(XMVectorNegate(XMVectorAdd(XMVectorMultiply(vdz, cx), XMVectorMultiply(u, cz))),
+			XMVectorSubtract(XMVectorMultiply(u, cx), XMVectorMultiply(vdz, cz)));
+
+		//shoulder and elbow: planar two link arm reaching (x, y) from the shoulder
+		auto x = XMVectorNegate(u);
+		auto y = XMVectorSubtract(XMVectorReplicate(dy), cy);
+		auto cos2 = XMVectorScale(XMVectorSubtract(XMVectorAdd(XMVectorMultiply(x, x), XMVectorMultiply(y, y)),
+			XMVectorReplicate(l1 * l1 + l2 * l2)), 1.0f / (2.0f * l1 * l2));
+		valid = XMVectorAndInt(valid, XMVectorInBounds(cos2, XMVectorReplicate(1.0f + 1e-5f)));
+		a[2] = XMVectorMultiply(elbow, XMVectorACos(XMVectorClamp(cos2, XMVectorReplicate(-1.0f), XMVectorSplatOne())));
+		XMVECTOR sinA2, cosA2;
+		XMVectorSinCos(&sinA2, &cosA2, a[2]);
+		a[1] = XMVectorSubtract(XMVectorATan2(y, x), XMVectorATan2(XMVectorScale(sinA2, l2),
+			XMVectorMultiplyAdd(cosA2, XMVectorReplicate(l2), XMVectorReplicate(l1))));
+		a[1] = XMVectorModAngles(a[1]);
+
+		//tool direction -n expressed in the forearm frame
+		XMVECTOR s0, c0, s12, c12;
+		XMVectorSinCos(&s0, &c0, a[0]);
+		XMVectorSinCos(&s12, &c12, XMVectorAdd(a[1], a[2]));
+		auto dx = XMVectorNegate(nx), dyv = XMVectorNegate(ny), dzv = XMVectorNegate(nz);
+		auto bx = XMVectorSubtract(XMVectorMultiply(dx, c0), XMVectorMultiply(dzv, s0));
+		auto bz = XMVectorAdd(XMVectorMultiply(dx, s0), XMVectorMultiply(dzv, c0));
+		auto fx = XMVectorAdd(XMVectorMultiply(bx, c12), XMVectorMultiply(dyv, s12));
+		auto fy = XMVectorSubtract(XMVectorMultiply(dyv, c12), XMVectorMultiply(bx, s12));
+		auto fz = bz;
+
+		//tool direction in the forearm frame is (-cos a4, -sin a4 cos a3, -sin a4 sin a3)
+		auto s4 = XMVectorSqrt(XMVectorAdd(XMVectorMultiply(fy, fy), XMVectorMultiply(fz, fz)));
+		a[4] = XMVectorATan2(XMVectorMultiply(wrist, s4), XMVectorNegate(fx));
+		a[3] = XMVectorATan2(XMVectorMultiply(wrist, XMVectorNegate(fz)), XMVectorMultiply(wrist, XMVectorNegate(fy)));
+		//with the wrist straight roll is arbitrary, so it's left at 0
+		a[3] = XMVectorSelect(a[3], zero, XMVectorLess(s4, XMVectorReplicate(1e-6f)));
+		return valid;
+	}
+
+	PumaAngles GetLane(const XMVECTOR (&a)[PumaKinematics::JOINTS_COUNT], unsigned int lane)
+	{
+		PumaAngles angles;
+		for (auto j = 0U; j < PumaKinematics::JOINTS_COUNT; ++j)
+			angles[j] = XMVectorGetByIndex(a[j], lane);
+		return angles;
+	}
+
+	TargetBlock Replicate(XMFLOAT3 position, XMFLOAT3 normal)
+	{
+		return { XMVectorReplicate(position.x), XMVectorReplicate(position.y), XMVectorReplicate(position.z),
+			XMVectorReplicate(normal.x), XMVectorReplicate(normal.y), XMVectorReplicate(normal.z) };
+	}
+}
+
+KinematicChain PumaKinematics::Chain()
+{
+	return KinematicChain({
+		{ { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 0.0f }, -1 },			//base
+		{ { 0.0f, 0.0f, 1.0f }, { 0.0f, DY, 0.0f }, 0 },			//shoulder
+		{ { 0.0f, 0.0f, 1.0f }, { -L1, DY, 0.0f }, 1 },				//elbow
+		{ { 1.0f, 0.0f, 0.0f }, { 0.0f, DY, -DZ }, 2 },				//forearm roll
+		{ { 0.0f, 0.0f, 1.0f }, { -L1 - L2, DY, 0.0f }, 3 } });		//wrist
+}
+
+void PumaKinematics::LinkMatrices(const PumaAngles& angles, XMFLOAT4X4 (&mtx)[JOINTS_COUNT])
+{
+	static const auto chain = Chain();
+	chain.ForwardKinematics(1, angles.data(), mtx);
+}
+
+void PumaKinematics::EndEffector(const PumaAngles& angles, XMFLOAT3& position, XMFLOAT3& normal)
+{
+	XMFLOAT4X4 mtx[JOINTS_COUNT];
+	LinkMatrices(angles, mtx);
+	auto tool = XMLoadFloat4x4(&mtx[JOINTS_COUNT - 1]);
+	XMStoreFloat3(&position, XMVector3TransformCoord(XMVectorSet(-L1 - L2 - L3, DY, -DZ, 1.0f), tool));
+	XMStoreFloat3(&normal, XMVector3TransformNormal(XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), tool));
+}
+
+bool PumaKinematics::Solve(XMFLOAT3 position, XMFLOAT3 normal, unsigned int branch, PumaAngles& angles)
+{
+	const unsigned int branches[4] = { branch, branch, branch, branch };
+	XMVECTOR a[JOINTS_COUNT];
+	auto valid = SolveBlock(Replicate(position, normal), branches, a);
+	angles = GetLane(a, 0);
+	return XMVectorGetIntX(valid) != 0;
+}
+
+unsigned int PumaKinematics::SolveBranches(XMFLOAT3 position, XMFLOAT3 normal, const unsigned int (&branches)[4],
+	PumaAngles (&angles)[4])
+{
+	XMVECTOR a[JOINTS_COUNT];
+	auto valid = SolveBlock(Replicate(position, normal), branches, a);
+	auto mask = 0U;
+	for (auto lane = 0U; lane < 4; ++lane)
+	{
+		angles[lane] = GetLane(a, lane);
+		if (XMVectorGetIntByIndex(valid, lane))
+			mask |= 1U << lane;
+	}
+	return mask;
+}
+
+unsigned int PumaKinematics::SolveAll(XMFLOAT3 position, XMFLOAT3 normal, PumaAngles (&angles)[MAX_SOLUTIONS], unsigned int* branches)
+{
+	//all eight branches of a single target in two blocks
+	auto target = Replicate(position, normal);
+	auto count = 0U;
+	for (auto first = 0U; first < MAX_SOLUTIONS; first += 4)
+	{
+		const unsigned int blockBranches[4] = { first, first + 1, first + 2, first + 3 };
+		XMVECTOR a[JOINTS_COUNT];
+		auto valid = SolveBlock(target, blockBranches, a);
+		for (auto lane = 0U; lane < 4; ++lane)
+		{
+			if (!XMVectorGetIntByIndex(valid, lane))
+				continue;
+			if (branches)
+				branches[count] = blockBranches[lane];
+			angles[count++] = GetLane(a, lane);
+		}
+	}
+	return count;
+}
+
+size_t PumaKinematics::SolveBatch(size_t count, const PumaTargetsSoA& targets, unsigned int branch,
+	const PumaAnglesSoA& angles, uint8_t* reachable)
+{
+	const unsigned int branches[4] = { branch, branch, branch, branch };
+	auto blocks = (count + 3) / 4;
+	ParallelFor(blocks, [&](size_t begin, size_t end)
+	{
+		for (auto b = begin; b < end; ++b)
+		{
+			auto first = 4 * b, lanes = min<size_t>(4, count - first);
+			TargetBlock t;
+			XMVECTOR a[JOINTS_COUNT];
+			XMVECTOR valid;
+			if (lanes == 4)
+			{
+				t = { XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(targets.px + first)),
+					XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(targets.py + first)),
+					XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(targets.pz + first)),
+					XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(targets.nx + first)),
+					XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(targets.ny + first)),
+					XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(targets.nz + first)) };
+				valid = SolveBlock(t, branches, a);
+				for (auto j = 0U; j < JOINTS_COUNT; ++j)
+					XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(angles.a[j] + first), a[j]);
+			}
+			else
+			{
+				//last, partial block goes through a padded copy
+				float in[6][4] = {};
+				const float* src[6] = { targets.px, targets.py, targets.pz, targets.nx, targets.ny, targets.nz };
+				for (auto c = 0; c < 6; ++c)
+					copy(src[c] + first, src[c] + first + lanes, in[c]);
+				t = { XMLoadFloat4(reinterpret_cast<XMFLOAT4*>(in[0])), XMLoadFloat4(reinterpret_cast<XMFLOAT4*>(in[1])),
+					XMLoadFloat4(reinterpret_cast<XMFLOAT4*>(in[2])), XMLoadFloat4(reinterpret_cast<XMFLOAT4*>(in[3])),
+					XMLoadFloat4(reinterpret_cast<XMFLOAT4*>(in[4])), XMLoadFloat4(reinterpret_cast<XMFLOAT4*>(in[5])) };
+				valid = SolveBlock(t, branches, a);
+				for (auto j = 0U; j < JOINTS_COUNT; ++j)
+				{
+					XMFLOAT4 out;
+					XMStoreFloat4(&out, a[j]);
+					copy(&out.x, &out.x + lanes, angles.a[j] + first);
+				}
+			}
+			XMUINT4 mask;
+			XMStoreUInt4(&mask, valid);
+			for (size_t lane = 0; lane < lanes; ++lane)
+				reachable[first + lane] = (&mask.x)[lane] ? 1 : 0;
+		}
+	}, 256);
+	return static_cast<size_t>(count_if(reachable, reachable + count, [](uint8_t r) { return r != 0; }));
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <DirectXMath.h>
+#include <array>
+#include <cstdint>
+#include "kinematicChain.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Joint angles of the PUMA arm, in the order of RoomDemo::a: base yaw, shoulder, elbow, forearm roll, wrist
+		using PumaAngles = std::array<float, 5>;
+
+		//Structure of arrays of IK targets. Tool tip is placed at p and points against n,
+		//i.e. n is the normal of the surface being touched.
+		struct PumaTargetsSoA
+		{
+			const float *px, *py, *pz;
+			const float *nx, *ny, *nz;
+		};
+
+		//Structure of arrays of IK results, one array per joint
+		struct PumaAnglesSoA
+		{
+			float* a[5];
+		};
+
+		//Closed-form forward and inverse kinematics of the PUMA arm drawn by RoomDemo.
+		//In the rest pose the shoulder is at height DY, upper arm L1 and forearm L2 point along -x,
+		//the forearm is offset by DZ along -z and the tool reaches L3 beyond the wrist.
+		class PumaKinematics
+		{
+		public:
+			//Bits of a branch index selecting one of the MAX_SOLUTIONS solutions
+			enum Branch : unsigned int
+			{
+				ShoulderFlip = 1,	//base turned by about half a turn with the arm reaching back over the shoulder
+				ElbowFlip = 2,		//elbow bent the other way
+				WristFlip = 4		//forearm rolled by half a turn and wrist bent the other way
+			};
+
+			static const unsigned int JOINTS_COUNT = 5;
+			static const unsigned int MAX_SOLUTIONS = 8;
+
+			static const float L1;	//upper arm length
+			static const float L2;	//forearm length
+			static const float L3;	//wrist to tool tip
+			static const float DY;	//shoulder height
+			static const float DZ;	//forearm offset from the shoulder plane
+
+			//Joints of the arm; link matrices of the chain are world matrices of m_puma[1..5], link 0 doesn't move
+			static KinematicChain Chain();
+			//World matrices of links 1-5 for given angles
+			static void LinkMatrices(const PumaAngles& angles, DirectX::XMFLOAT4X4 (&mtx)[JOINTS_COUNT]);
+			//Tool tip position and normal of the surface it's touching, i.e. reversed tool direction
+			static void EndEffector(const PumaAngles& angles, DirectX::XMFLOAT3& position, DirectX::XMFLOAT3& normal);
+
+			//Solution of the given branch. Returns false if the target is out of reach.
+			static bool Solve(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 normal, unsigned int branch, PumaAngles& angles);
+			//Solutions of four branches of a single target at once. Returns mask with bit per reachable lane.
+			static unsigned int SolveBranches(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 normal,
+				const unsigned int (&branches)[4], PumaAngles (&angles)[4]);
+			//All reachable solutions; branches receives branch index of each of them (may be null).
+			//Returns the number of solutions.
+			static unsigned int SolveAll(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 normal,
+				PumaAngles (&angles)[MAX_SOLUTIONS], unsigned int* branches = nullptr);
+			//Solves count targets in the given branch, four at a time with vector instructions and in parallel.
+			//reachable[i] is set to 1 for targets in reach and 0 otherwise (angles are undefined then).
+			//Returns the number of reachable targets.
+			static size_t SolveBatch(size_t count, const PumaTargetsSoA& targets, unsigned int branch,
+				const PumaAnglesSoA& angles, uint8_t* reachable);
+		};
+	}
+}
@@ -0,0 +1,239 @@
+#include "reachabilityMap.h"
+#include "pumaKinematics.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+const float ReachabilityMap::CELL_SIZE = 0.05f;
+const uint32_t ReachabilityMap::FILE_TAG = 0x314D5250; //"PRM1"
+
+namespace
+{
+	//Farthest the tool tip gets from the shoulder, with some margin
+	const float REACH = PumaKinematics::L1 + PumaKinematics::L2 + PumaKinematics::L3 + PumaKinematics::DZ;
+	//largest number of cells along the reach, keeps cell counts of foreign files from overflowing
+	const float MAX_CELLS = 65536.0f;
+
+	//Number of cells of size cellSize covering length
+	unsigned int Cells(float length, float cellSize)
+	{
+		return static_cast<unsigned int>(ceilf(length / cellSize));
+	}
+
+	//Yoshikawa measure sqrt(det(J J^T)) of the positional Jacobian, whose columns are axis x (tip - pivot)
+	float Manipulability(const KinematicChain& chain, FXMVECTOR tip)
+	{
+		XMFLOAT3 c[PumaKinematics::JOINTS_COUNT];
+		for (auto j = 0U; j < PumaKinematics::JOINTS_COUNT; ++j)
+		{
+			auto link = XMLoadFloat4x4(&chain.linkMatrix(j));
+			auto axis = XMVector3TransformNormal(XMLoadFloat3(&chain.joint(j).Axis), link);
+			auto pivot = XMVector3TransformCoord(XMLoadFloat3(&chain.joint(j).Pivot), link);
+			XMStoreFloat3(&c[j], XMVector3Cross(axis, XMVectorSubtract(tip, pivot)));
+		}
+		float xx = 0, xy = 0, xz = 0, yy = 0, yz = 0, zz = 0;
+		for (auto& v : c)
+		{
+			xx += v.x * v.x; xy += v.x * v.y; xz += v.x * v.z;
+			yy += v.y * v.y; yz += v.y * v.z; zz += v.z * v.z;
+		}
+		auto det = xx * (yy * zz - yz * yz) - xy * (xy * zz - yz * xz) + xz * (xy * yz - yy * xz);
+		return sqrtf(max(det, 0.0f));
+	}
+}
+
+ReachabilityMap::ReachabilityMap()
+	: m_cellSize(CELL_SIZE), m_bottom(0.0f), m_radialCells(0), m_verticalCells(0), m_maxManipulability(0.0f)
+{ }
+
+ReachabilityMap ReachabilityMap::Build(float cellSize, const ReachabilitySweep& sweep)
+{
+	ReachabilityMap map;
+	map.m_cellSize = cellSize;
+	map.m_bottom = PumaKinematics::DY - REACH;
+	map.m_radialCells = Cells(REACH, cellSize);
+	map.m_verticalCells = Cells(2.0f * REACH, cellSize);
+	auto cells = static_cast<size_t>(map.m_radialCells) * map.m_verticalCells;
+	vector<float> manipulability(cells, 0.0f);
+	map.m_orientations.assign(cells, 0);
+
+	const XMFLOAT3 toolTip(-PumaKinematics::L1 - PumaKinematics::L2 - PumaKinematics::L3, PumaKinematics::DY, -PumaKinematics::DZ);
+	auto sample = [](unsigned int i, unsigned int steps, float range) { return range * i / max(steps, 1U); };
+	mutex merge;
+	//the base joint stays at 0, tips are binned by their distance from the axis it turns about
+	ParallelFor(sweep.ShoulderSteps, [&](size_t begin, size_t end)
+	{
+		vector<float> localManipulability(cells, 0.0f);
+		vector<uint32_t> localOrientations(cells, 0);
+		//inner loops change only the last joints, so the chain recomputes just their links
+		auto chain = PumaKinematics::Chain();
+		for (auto s = begin; s < end; ++s)
+		{
+			chain.SetAngle(1, sample(static_cast<unsigned int>(s), sweep.ShoulderSteps, XM_2PI) - XM_PI);
+			for (auto e = 0U; e < sweep.ElbowSteps; ++e)
+			{
+				chain.SetAngle(2, sample(e, sweep.ElbowSteps, XM_2PI) - XM_PI);
+				for (auto r = 0U; r < sweep.RollSteps; ++r)
+				{
+					chain.SetAngle(3, sample(r, sweep.RollSteps, XM_PI));
+					for (auto w = 0U; w < sweep.WristSteps; ++w)
+					{
+						chain.SetAngle(4, sample(w, sweep.WristSteps, XM_2PI) - XM_PI);
+						chain.Update();
+						auto tool = XMLoadFloat4x4(&chain.linkMatrix(PumaKinematics::JOINTS_COUNT - 1));
+						auto tip = XMVector3TransformCoord(XMLoadFloat3(&toolTip), tool);
+						XMFLOAT3 p, n;
+						XMStoreFloat3(&p, tip);
+						XMStoreFloat3(&n, XMVector3TransformNormal(XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), tool));
+						int ri, vi;
+						if (!map.Cell(p, ri, vi))
+							continue;
+						auto i = map.Index(ri, vi);
+						localManipulability[i] = max(localManipulability[i], ::Manipulability(chain, tip));
+						localOrientations[i] |= 1U << OrientationBin(p, n);
+					}
+				}
+			}
+		}
+		lock_guard<mutex> lock(merge);
+		for (size_t i = 0; i < cells; ++i)
+		{
+			manipulability[i] = max(manipulability[i], localManipulability[i]);
+			map.m_orientations[i] |= localOrientations[i];
+		}
+	});
+
+	map.m_maxManipulability = *max_element(manipulability.begin(), manipulability.end());
+	map.m_scores.assign(cells, 0);
+	for (size_t i = 0; i < cells; ++i)
+		if (map.m_orientations[i])
+		{
+			//reached voxels score at least 1, even at singular configurations
+			auto score = map.m_maxManipulability > 0.0f ? 255.0f * manipulability[i] / map.m_maxManipulability : 0.0f;
+			map.m_scores[i] = static_cast<uint8_t>(clamp(lroundf(score), 1L, 255L));
+		}
+	return map;
+}
+
+ReachabilityMap ReachabilityMap::Load(const wstring& path)
+{
+	ifstream input;
+	input.exceptions(ios::badbit | ios::failbit | ios::eofbit);
+	input.open(filesystem::path(path), ios::binary);
+	uint32_t tag;
+	input.read(reinterpret_cast<char*>(&tag), sizeof(tag));
+	if (tag != FILE_TAG)
+		input.setstate(ios::failbit);
+
+	ReachabilityMap map;
+	input.read(reinterpret_cast<char*>(&map.m_cellSize), sizeof(map.m_cellSize));
+	input.read(reinterpret_cast<char*>(&map.m_bottom), sizeof(map.m_bottom));
+	input.read(reinterpret_cast<char*>(&map.m_radialCells), sizeof(map.m_radialCells));
+	input.read(reinterpret_cast<char*>(&map.m_verticalCells), sizeof(map.m_verticalCells));
+	input.read(reinterpret_cast<char*>(&map.m_maxManipulability), sizeof(map.m_maxManipulability));
+	//the grid covers the reach of this arm, so its dimensions follow from the cell size; files of other grids
+	//and truncated files fail before the cell counts are used to allocate and read the cells
+	auto validSize = map.m_cellSize > REACH / MAX_CELLS && map.m_cellSize <= REACH;
+	if (!validSize || map.m_radialCells != Cells(REACH, map.m_cellSize) || map.m_verticalCells != Cells(2.0f * REACH, map.m_cellSize)
+		|| map.m_bottom != PumaKinematics::DY - REACH)
+		input.setstate(ios::failbit);
+	auto cells = static_cast<size_t>(map.m_radialCells) * map.m_verticalCells;
+	auto header = input.tellg();
+	input.seekg(0, ios::end);
+	if (input.tellg() - header != static_cast<streamoff>(cells * (sizeof(uint8_t) + sizeof(uint32_t))))
+		input.setstate(ios::failbit);
+	input.seekg(header);
+	map.m_scores.resize(cells);
+	map.m_orientations.resize(cells);
+	input.read(reinterpret_cast<char*>(map.m_scores.data()), cells * sizeof(uint8_t));
+	input.read(reinterpret_cast<char*>(map.m_orientations.data()), cells * sizeof(uint32_t));
+	return map;
+}
+
+void ReachabilityMap::Save(const wstring& path) const
+{
+	//File format (binary, little endian):
+	//tag, cell size, bottom, radial cells, vertical cells, max manipulability
+	//scores [radial * vertical bytes, radial index fastest]
+	//orientation masks [radial * vertical 32 bit words]
+	ofstream output;
+	output.exceptions(ios::badbit | ios::failbit);
+	output.open(filesystem::path(path), ios::binary);
+	output.write(reinterpret_cast<const char*>(&FILE_TAG), sizeof(FILE_TAG));
+	output.write(reinterpret_cast<const char*>(&m_cellSize), sizeof(m_cellSize));
+	output.write(reinterpret_cast<const char*>(&m_bottom), sizeof(m_bottom));
+	output.write(reinterpret_cast<const char*>(&m_radialCells), sizeof(m_radialCells));
+	output.write(reinterpret_cast<const char*>(&m_verticalCells), sizeof(m_verticalCells));
+	output.write(reinterpret_cast<const char*>(&m_maxManipulability), sizeof(m_maxManipulability));
+	output.write(reinterpret_cast<const char*>(m_scores.data()), m_scores.size() * sizeof(uint8_t));
+	output.write(reinterpret_cast<const char*>(m_orientations.data()), m_orientations.size() * sizeof(uint32_t));
+}
+
+bool ReachabilityMap::Cell(XMFLOAT3 position, int& radial, int& vertical) const
+{
+	auto r = sqrtf(position.x * position.x + position.z * position.z);
+	radial = static_cast<int>(r / m_cellSize);
+	vertical = static_cast<int>(floorf((position.y - m_bottom) / m_cellSize));
+	return radial < static_cast<int>(m_radialCells) && vertical >= 0 && vertical < static_cast<int>(m_verticalCells);
+}
+
+bool ReachabilityMap::Reachable(XMFLOAT3 position) const
+{
+	int r, v;
+	return Cell(position, r, v) && m_scores[Index(r, v)] != 0;
+}
+
+bool ReachabilityMap::Reachable(XMFLOAT3 position, XMFLOAT3 normal) const
+{
+	int r, v;
+	return Cell(position, r, v) && (m_orientations[Index(r, v)] >> OrientationBin(position, normal) & 1U) != 0;
+}
+
+bool ReachabilityMap::MayReach(XMFLOAT3 position) const
+{
+	int r, v;
+	if (!Cell(position, r, v) && (r > static_cast<int>(m_radialCells) || v < -1 || v > static_cast<int>(m_verticalCells)))
+		return false;
+	for (auto dv = -1; dv <= 1; ++dv)
+		for (auto dr = -1; dr <= 1; ++dr)
+		{
+			int nr = r + dr, nv = v + dv;
+			if (nr >= 0 && nr < static_cast<int>(m_radialCells) && nv >= 0 && nv < static_cast<int>(m_verticalCells)
+				&& m_scores[Index(nr, nv)] != 0)
+				return true;
+		}
+	return false;
+}
+
+float ReachabilityMap::Manipulability(XMFLOAT3 position) const
+{
+	int r, v;
+	return Cell(position, r, v) ? m_scores[Index(r, v)] / 255.0f : 0.0f;
+}
+
+unsigned int ReachabilityMap::OrientationBin(float radial, float up, float tangential)
+{
+	//components at least half of the largest one round to +-1, the rest to 0
+	auto largest = max(fabsf(radial), max(fabsf(up), fabsf(tangential)));
+	if (largest == 0.0f)
+		return 13;
+	auto round = [largest](float c) { return c >= 0.5f * largest ? 2U : (c <= -0.5f * largest ? 0U : 1U); };
+	return round(radial) * 9 + round(up) * 3 + round(tangential);
+}
+
+unsigned int ReachabilityMap::OrientationBin(XMFLOAT3 position, XMFLOAT3 normal)
+{
+	//radial direction is undefined on the axis, any one is as good there
+	auto r = sqrtf(position.x * position.x + position.z * position.z);
+	auto rx = r > 0.0f ? position.x / r : 1.0f, rz = r > 0.0f ? position.z / r : 0.0f;
+	//tangential direction is up x radial
+	return OrientationBin(normal.x * rx + normal.z * rz, normal.y, normal.x * rz - normal.z * rx);
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Number of samples of each joint swept by ReachabilityMap::Build. The base joint is covered by symmetry.
+		struct ReachabilitySweep
+		{
+			unsigned int ShoulderSteps = 256;	//full turn
+			unsigned int ElbowSteps = 192;		//full turn
+			unsigned int RollSteps = 8;			//half a turn, the other half repeats tool orientations
+			unsigned int WristSteps = 24;		//full turn
+		};
+
+		//Workspace of the PUMA arm precomputed by sweeping its joint space with forward kinematics.
+		//The base joint turns the whole arm about the y axis, so the workspace is rotationally symmetric and its
+		//voxels are rings around that axis, indexed by distance from the axis and by height. Each voxel keeps the
+		//best manipulability of tool tips that fell into it and a mask of tool orientations that reached it,
+		//expressed relative to the radial direction. Queries take a few arithmetic operations and no IK.
+		class ReachabilityMap
+		{
+		public:
+			//Empty map, nothing is reachable
+			ReachabilityMap();
+
+			//Sweeps the joint space in parallel; takes about a second with default settings
+			static ReachabilityMap Build(float cellSize = CELL_SIZE, const ReachabilitySweep& sweep = ReachabilitySweep());
+			//Throws std::ios_base::failure if the file can't be read or isn't a complete map of this arm
+			static ReachabilityMap Load(const std::wstring& path);
+			void Save(const std::wstring& path) const;
+
+			//True if a swept tool tip fell into the voxel of position
+			bool Reachable(DirectX::XMFLOAT3 position) const;
+			//Also requires the voxel to be reached with the tool pointing roughly against normal
+			bool Reachable(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 normal) const;
+			//False only if neither the voxel of position nor any of its neighbours was reached. Tolerates sampling
+			//gaps at the workspace boundary, so planners use it to reject targets before running IK.
+			bool MayReach(DirectX::XMFLOAT3 position) const;
+			//Yoshikawa manipulability of the tool tip position relative to the best one in the map, 0 if unreachable
+			float Manipulability(DirectX::XMFLOAT3 position) const;
+
+			float cellSize() const { return m_cellSize; }
+			unsigned int radialCells() const { return m_radialCells; }
+			unsigned int verticalCells() const { return m_verticalCells; }
+			float maxManipulability() const { return m_maxManipulability; }
+
+			static const float CELL_SIZE;
+			//Tool directions are binned by rounding them to the 26 directions towards faces, edges and corners of a cube
+			static const unsigned int ORIENTATION_BINS = 27;
+
+		private:
+			static const uint32_t FILE_TAG;
+
+			float m_cellSize;
+			float m_bottom;			//height of the lowest voxels
+			unsigned int m_radialCells, m_verticalCells;
+			float m_maxManipulability;
+			std::vector<uint8_t> m_scores;			//0 - not reached, 1-255 - manipulability scaled by m_maxManipulability
+			std::vector<uint32_t> m_orientations;	//bit per orientation bin
+
+			//Voxel containing position; returns false outside of the map
+			bool Cell(DirectX::XMFLOAT3 position, int& radial, int& vertical) const;
+			size_t Index(int radial, int vertical) const
+			{
+				return static_cast<size_t>(vertical) * m_radialCells + radial;
+			}
+
+			//Bin of a direction given in the frame of radial, up and tangential directions
+			static unsigned int OrientationBin(float radial, float up, float tangential);
+			//Bin of normal at position in the frame of its ring
+			static unsigned int OrientationBin(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 normal);
+		};
+	}
+}
@@ -0,0 +1,130 @@
+#include "rigidBody.h"
+#include <cassert>
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+RigidBodyInertia RigidBodyInertia::FromMesh(const MeshData& mesh, float density)
+{
+	//sum over tetrahedra spanned by the origin and every triangle; signed volumes cancel outside the mesh
+	double volume = 0.0, first[3] = {}, second[3][3] = {};
+	for (size_t t = 0; t < mesh.trianglesCount(); ++t)
+	{
+		double p[3][3];
+		for (auto k = 0; k < 3; ++k)
+		{
+			auto& v = mesh.Positions[mesh.Indices[3 * t + k]];
+			p[k][0] = v.x; p[k][1] = v.y; p[k][2] = v.z;
+		}
+		auto det = p[0][0] * (p[1][1] * p[2][2] - p[1][2] * p[2][1]) - p[0][1] * (p[1][0] * p[2][2] - p[1][2] * p[2][0]) +
+			p[0][2] * (p[1][0] * p[2][1] - p[1][1] * p[2][0]);
+		double s[3] = { p[0][0] + p[1][0] + p[2][0], p[0][1] + p[1][1] + p[2][1], p[0][2] + p[1][2] + p[2][2] };
+		volume += det / 6.0;
+		for (auto i = 0; i < 3; ++i)
+		{
+			first[i] += det / 24.0 * s[i];
+			//integral of x_i x_j over the tetrahedron
+			for (auto j = 0; j < 3; ++j)
+				second[i][j] += det / 120.0 * (p[0][i] * p[0][j] + p[1][i] * p[1][j] + p[2][i] * p[2][j] + s[i] * s[j]);
+		}
+	}
+	assert(volume > 0.0 && "mesh must be closed with triangles facing outwards");
+
+	RigidBodyInertia body;
+	auto mass = density * volume;
+	double c[3] = { first[0] / volume, first[1] / volume, first[2] / volume };
+	double covariance[3][3];
+	for (auto i = 0; i < 3; ++i)
+		for (auto j = 0; j < 3; ++j)
+			covariance[i][j] = density * second[i][j] - mass * c[i] * c[j];
+	auto trace = covariance[0][0] + covariance[1][1] + covariance[2][2];
+	for (auto i = 0; i < 3; ++i)
+		for (auto j = 0; j < 3; ++j)
+			body.Inertia.m[i][j] = static_cast<float>((i == j ? trace : 0.0) - covariance[i][j]);
+	body.Mass = static_cast<float>(mass);
+	body.CenterOfMass = { static_cast<float>(c[0]), static_cast<float>(c[1]), static_cast<float>(c[2]) };
+	return body;
+}
+
+RigidBodyInertia RigidBodyInertia::PointMass(float mass, XMFLOAT3 position)
+{
+	RigidBodyInertia body;
+	body.Mass = mass;
+	body.CenterOfMass = position;
+	XMStoreFloat3x3(&body.Inertia, XMMatrixScaling(0.0f, 0.0f, 0.0f));
+	return body;
+}
+
+RigidBodyInertia RigidBodyInertia::Transformed(const XMFLOAT4X4& mtx) const
+{
+	auto m = XMLoadFloat4x4(&mtx);
+	RigidBodyInertia body;
+	body.Mass = Mass;
+	XMStoreFloat3(&body.CenterOfMass, XMVector3TransformCoord(XMLoadFloat3(&CenterOfMass), m));
+	//rows of m are the rotated axes, so the tensor becomes m^T I m
+	m.r[3] = XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
+	XMStoreFloat3x3(&body.Inertia, XMMatrixMultiply(XMMatrixMultiply(XMMatrixTranspose(m), XMLoadFloat3x3(&Inertia)), m));
+	return body;
+}
+
+RigidBodyInertia RigidBodyInertia::Combined(const RigidBodyInertia& other) const
+{
+	RigidBodyInertia body;
+	body.Mass = Mass + other.Mass;
+	auto c0 = XMLoadFloat3(&CenterOfMass), c1 = XMLoadFloat3(&other.CenterOfMass);
+	auto c = body.Mass > 0.0f ? XMVectorScale(XMVectorAdd(XMVectorScale(c0, Mass), XMVectorScale(c1, other.Mass)), 1.0f / body.Mass)
+		: c0;
+	XMStoreFloat3(&body.CenterOfMass, c);
+	//parallel axis theorem for both parts
+	auto shifted = [c](const RigidBodyInertia& part)
+	{
+		XMFLOAT3 d;
+		XMStoreFloat3(&d, XMVectorSubtract(XMLoadFloat3(&part.CenterOfMass), c));
+		float dd[3] = { d.x, d.y, d.z };
+		auto lengthSq = d.x * d.x + d.y * d.y + d.z * d.z;
+		auto inertia = part.Inertia;
+		for (auto i = 0; i < 3; ++i)
+			for (auto j = 0; j < 3; ++j)
+				inertia.m[i][j] += part.Mass * ((i == j ? lengthSq : 0.0f) - dd[i] * dd[j]);
+		return inertia;
+	};
+	auto i0 = shifted(*this), i1 = shifted(other);
+	for (auto i = 0; i < 3; ++i)
+		for (auto j = 0; j < 3; ++j)
+			body.Inertia.m[i][j] = i0.m[i][j] + i1.m[i][j];
+	return body;
+}
+
+SpatialVector RigidBodyInertia::Momentum(const SpatialVector& v) const
+{
+	auto w = v.angular();
+	auto c = XMLoadFloat3(&CenterOfMass);
+	//linear momentum of the center of mass, angular momentum about the origin
+	auto h = XMVectorScale(XMVectorAdd(v.linear(), XMVector3Cross(w, c)), Mass);
+	auto l = XMVectorAdd(XMVector3TransformNormal(w, XMLoadFloat3x3(&Inertia)), XMVector3Cross(c, h));
+	return SpatialVector::Make(l, h);
+}
+
+SpatialMatrix RigidBodyInertia::Spatial() const
+{
+	//[Ic + m C C^T, m C; m C^T, m 1], C - cross product matrix of the center of mass
+	const float c[3] = { CenterOfMass.x, CenterOfMass.y, CenterOfMass.z };
+	const float cross[3][3] = { { 0.0f, -c[2], c[1] }, { c[2], 0.0f, -c[0] }, { -c[1], c[0], 0.0f } };
+	SpatialMatrix s;
+	for (auto i = 0; i < 3; ++i)
+	{
+		for (auto j = 0; j < 3; ++j)
+		{
+			auto cct = 0.0f;
+			for (auto k = 0; k < 3; ++k)
+				cct += cross[i][k] * cross[j][k];
+			s.m[i][j] = Inertia.m[i][j] + Mass * cct;
+			s.m[i][j + 3] = Mass * cross[i][j];
+			s.m[i + 3][j] = Mass * cross[j][i];
+			s.m[i + 3][j + 3] = i == j ? Mass : 0.0f;
+		}
+	}
+	return s;
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <DirectXMath.h>
+#include "meshData.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Spatial motion or force vector in Plucker coordinates: angular part first, then the linear part
+		//at the origin of the frame (velocity of the point at the origin, or the force).
+		struct SpatialVector
+		{
+			float v[6];
+
+			float& operator[](size_t i) { return v[i]; }
+			float operator[](size_t i) const { return v[i]; }
+
+			static SpatialVector Zero() { return { { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f } }; }
+			static SpatialVector Make(DirectX::FXMVECTOR angular, DirectX::FXMVECTOR linear)
+			{
+				SpatialVector s;
+				DirectX::XMStoreFloat3(reinterpret_cast<DirectX::XMFLOAT3*>(s.v), angular);
+				DirectX::XMStoreFloat3(reinterpret_cast<DirectX::XMFLOAT3*>(s.v + 3), linear);
+				return s;
+			}
+
+			DirectX::XMVECTOR angular() const { return DirectX::XMLoadFloat3(reinterpret_cast<const DirectX::XMFLOAT3*>(v)); }
+			DirectX::XMVECTOR linear() const { return DirectX::XMLoadFloat3(reinterpret_cast<const DirectX::XMFLOAT3*>(v + 3)); }
+
+			SpatialVector& operator+=(const SpatialVector& o)
+			{
+				for (auto i = 0; i < 6; ++i)
+					v[i] += o.v[i];
+				return *this;
+			}
+			SpatialVector operator+(const SpatialVector& o) const { auto r = *this; return r += o; }
+			SpatialVector operator*(float s) const
+			{
+				SpatialVector r;
+				for (auto i = 0; i < 6; ++i)
+					r.v[i] = v[i] * s;
+				return r;
+			}
+
+			//Power of a force on a motion, or a motion on a force
+			float Dot(const SpatialVector& o) const
+			{
+				auto sum = 0.0f;
+				for (auto i = 0; i < 6; ++i)
+					sum += v[i] * o.v[i];
+				return sum;
+			}
+			//this x m, rate of change of motion m moving with velocity this
+			SpatialVector CrossMotion(const SpatialVector& m) const
+			{
+				using namespace DirectX;
+				auto w = angular();
+				return Make(XMVector3Cross(w, m.angular()),
+					XMVectorAdd(XMVector3Cross(w, m.linear()), XMVector3Cross(linear(), m.angular())));
+			}
+			//this x* f, rate of change of force f moving with velocity this
+			SpatialVector CrossForce(const SpatialVector& f) const
+			{
+				using namespace DirectX;
+				auto w = angular();
+				return Make(XMVectorAdd(XMVector3Cross(w, f.angular()), XMVector3Cross(linear(), f.linear())),
+					XMVector3Cross(w, f.linear()));
+			}
+		};
+
+		//Symmetric 6x6 matrix mapping motions to forces, e.g. an articulated body inertia
+		struct SpatialMatrix
+		{
+			float m[6][6];
+
+			SpatialVector operator*(const SpatialVector& s) const
+			{
+				SpatialVector r;
+				for (auto i = 0; i < 6; ++i)
+				{
+					auto sum = 0.0f;
+					for (auto j = 0; j < 6; ++j)
+						sum += m[i][j] * s.v[j];
+					r.v[i] = sum;
+				}
+				return r;
+			}
+			SpatialMatrix& operator+=(const SpatialMatrix& o)
+			{
+				for (auto i = 0; i < 6; ++i)
+					for (auto j = 0; j < 6; ++j)
+						m[i][j] += o.m[i][j];
+				return *this;
+			}
+			//Subtracts u u^T / d
+			void SubtractOuter(const SpatialVector& u, float d)
+			{
+				for (auto i = 0; i < 6; ++i)
+					for (auto j = 0; j < 6; ++j)
+						m[i][j] -= u.v[i] * u.v[j] / d;
+			}
+		};
+
+		//Mass properties of a rigid body. The inertia tensor is taken about the center of mass.
+		struct RigidBodyInertia
+		{
+			float Mass;
+			DirectX::XMFLOAT3 CenterOfMass;
+			DirectX::XMFLOAT3X3 Inertia;
+
+			//Solid of uniform density bounded by a closed mesh with outward facing triangles
+			static RigidBodyInertia FromMesh(const MeshData& mesh, float density);
+			//Point mass, e.g. a payload held by the tool
+			static RigidBodyInertia PointMass(float mass, DirectX::XMFLOAT3 position);
+
+			//Moved by a rotation and translation (row vector convention, like link matrices)
+			RigidBodyInertia Transformed(const DirectX::XMFLOAT4X4& mtx) const;
+			//Both bodies as one
+			RigidBodyInertia Combined(const RigidBodyInertia& other) const;
+
+			//Momentum of the body moving with velocity v; both in coordinates of the frame the body is given in
+			SpatialVector Momentum(const SpatialVector& v) const;
+			SpatialMatrix Spatial() const;
+		};
+	}
+}
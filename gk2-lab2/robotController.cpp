@@ -0,0 +1,173 @@
+#include "robotController.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using namespace mini;
+using namespace gk2;
+using namespace std;
+
+const float RobotController::MAX_LAG = 0.1f;
+const float RobotController::MAX_SPIN_SHARE = 0.1f;
+
+namespace
+{
+	RobotState RestState(const PumaAngles& start)
+	{
+		RobotState state;
+		state.Tick = 0;
+		state.Time = 0.0;
+		state.Setpoint = state.Angles = start;
+		state.Velocities.fill(0.0f);
+		state.Playing = false;
+		return state;
+	}
+}
+
+RobotController::RobotController(const PumaAngles& start, const JointLimits& limits)
+	: RobotController(start, limits, Settings())
+{ }
+
+RobotController::RobotController(const PumaAngles& start, const JointLimits& limits, const Settings& settings)
+	: m_limits(limits), m_settings(settings), m_state(RestState(start)), m_jitterSum(0.0), m_commandsPending(false),
+	m_stop(false), m_published(m_state)
+{ }
+
+RobotController::~RobotController()
+{
+	Stop();
+}
+
+void RobotController::Start()
+{
+	if (running())
+		return;
+	m_stop = false;
+	m_thread = thread([this] { Loop(); });
+}
+
+void RobotController::Stop()
+{
+	if (!running())
+		return;
+	m_stop = true;
+	m_thread.join();
+}
+
+void RobotController::Play(JointTrajectory trajectory, bool loop)
+{
+	Post({ move(trajectory), loop, true });
+}
+
+void RobotController::Queue(JointTrajectory trajectory, bool loop)
+{
+	Post({ move(trajectory), loop, false });
+}
+
+void RobotController::Post(Command command)
+{
+	lock_guard<mutex> lock(m_commandsMutex);
+	m_commands.push_back(move(command));
+	m_commandsPending.store(true, memory_order_release);
+}
+
+void RobotController::ApplyCommands()
+{
+	//the lock is only taken by ticks that have something to apply
+	if (!m_commandsPending.load(memory_order_acquire))
+		return;
+	lock_guard<mutex> lock(m_commandsMutex);
+	for (auto& c : m_commands)
+	{
+		if (c.Replace)
+			m_player.Play(move(c.Trajectory), c.Loop);
+		else
+			m_player.Queue(move(c.Trajectory), c.Loop);
+	}
+	m_commands.clear();
+	m_commandsPending.store(false, memory_order_relaxed);
+}
+
+void RobotController::Step()
+{
+	auto dt = period();
+	auto previous = m_state.Setpoint;
+	m_state.Playing = m_player.Update(dt, m_state.Setpoint);
+	auto w = m_settings.ServoFrequency;
+	for (size_t j = 0; j < m_state.Angles.size(); ++j)
+	{
+		auto& q = m_state.Angles[j];
+		auto& qd = m_state.Velocities[j];
+		auto maxAcceleration = m_settings.Headroom * m_limits.MaxAcceleration[j];
+		//position loop with velocity feed forward commands the velocity loop, but never faster than the joint could
+		//stop from before passing the point where the setpoint itself can stop
+		auto error = m_state.Setpoint[j] - q;
+		auto setpointVelocity = (m_state.Setpoint[j] - previous[j]) / dt;
+		auto velocity = setpointVelocity + 0.5f * w * error;
+		auto stopping = sqrtf(2.0f * maxAcceleration * fabsf(error) + setpointVelocity * setpointVelocity);
+		velocity = clamp(velocity, -stopping, stopping);
+		velocity = clamp(velocity, -m_limits.MaxVelocity[j], m_limits.MaxVelocity[j]);
+		auto acceleration = clamp(2.0f * w * (velocity - qd), -maxAcceleration, maxAcceleration);
+		qd += acceleration * dt;
+		q += qd * dt;
+	}
+	++m_state.Tick;
+	m_state.Time = m_state.Tick * static_cast<double>(dt);
+}
+
+void RobotController::Publish()
+{
+	m_published.back() = m_state;
+	m_published.Publish();
+}
+
+void RobotController::Tick()
+{
+	assert(!running());
+	ApplyCommands();
+	Step();
+	Publish();
+}
+
+void RobotController::Loop()
+{
+	using LoopClock = chrono::steady_clock;
+	auto seconds = [](double s) { return chrono::duration_cast<LoopClock::duration>(chrono::duration<double>(s)); };
+	auto period = seconds(1.0 / m_settings.Rate);
+	auto spin = seconds(min(m_settings.SpinTime, MAX_SPIN_SHARE / m_settings.Rate));
+	auto maxLag = seconds(MAX_LAG);
+	auto& stats = m_state.Stats;
+	auto scheduled = LoopClock::now();
+	while (!m_stop.load(memory_order_relaxed))
+	{
+		if (scheduled - LoopClock::now() > spin)
+			this_thread::sleep_until(scheduled - spin);
+		auto start = LoopClock::now();
+		while (start < scheduled)
+		{
+			this_thread::yield();
+			start = LoopClock::now();
+		}
+		//after a long stall, e.g. in a debugger, the ticks are skipped instead of run in a burst
+		if (start - scheduled > maxLag)
+		{
+			++stats.resyncs;
+			scheduled = start;
+		}
+
+		ApplyCommands();
+		Step();
+		auto finished = LoopClock::now();
+
+		auto jitter = chrono::duration<float>(start - scheduled).count();
+		++stats.ticks;
+		if (finished > scheduled + period)
+			++stats.missed;
+		m_jitterSum += jitter;
+		stats.maxJitter = max(stats.maxJitter, jitter);
+		stats.meanJitter = static_cast<float>(m_jitterSum / stats.ticks);
+		stats.maxTickTime = max(stats.maxTickTime, chrono::duration<float>(finished - start).count());
+		Publish();
+		scheduled += period;
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "jointTrajectory.h"
+#include "pathParameterization.h"
+#include "tripleBuffer.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Timing of the control loop since it was started; all times in seconds
+		struct ControlLoopStats
+		{
+			uint64_t ticks;
+			uint64_t missed;		//ticks finished after the start of the next one was due
+			uint64_t resyncs;		//times the loop fell behind by more than MAX_LAG and skipped the missed ticks
+			float maxJitter;		//largest delay of a tick's start after its scheduled time
+			float meanJitter;
+			float maxTickTime;		//longest computation of a tick
+
+			ControlLoopStats() : ticks(0), missed(0), resyncs(0), maxJitter(0.0f), meanJitter(0.0f), maxTickTime(0.0f) { }
+
+			float missedRate() const { return ticks ? static_cast<float>(missed) / ticks : 0.0f; }
+		};
+
+		//Snapshot of the robot published by RobotController after every tick
+		struct RobotState
+		{
+			uint64_t Tick;
+			double Time;			//Tick times the control period
+			PumaAngles Setpoint;	//angles of the trajectory being played
+			PumaAngles Angles;		//angles reached by the servos
+			PumaAngles Velocities;
+			bool Playing;
+			ControlLoopStats Stats;
+		};
+
+		//Drives the PUMA joints at a fixed rate on its own thread, independent of the frame rate.
+		//Every tick advances the queued trajectories, which give the joint setpoints, and the servo of every
+		//joint: a position loop with velocity feed forward driving a velocity loop, critically damped for small
+		//errors. Velocities are limited by JointLimits and commanded no faster than the joint can still stop from,
+		//so setpoints jumping or accelerating harder than the servo can don't make it overshoot much.
+		//State snapshots go through a triple buffer, so the renderer reads the latest one without blocking
+		//the loop. The loop sleeps until shortly before a tick is due and spins for the rest, as sleeping alone
+		//is too coarse on most systems. Spinning is limited to a fraction of the period, so the thread stays mostly
+		//idle at any rate.
+		class RobotController
+		{
+		public:
+			struct Settings
+			{
+				float Rate = 1000.0f;		//ticks per second
+				float ServoFrequency = 40.0f;	//natural frequency of the servos, radians per second
+				float Headroom = 2.0f;		//servo acceleration limit relative to JointLimits, leaving room for feedback
+				float SpinTime = 0.0001f;	//time before a tick spent spinning instead of sleeping, at most MAX_SPIN_SHARE of a period
+			};
+
+			explicit RobotController(const PumaAngles& start, const JointLimits& limits = JointLimits::Puma());
+			RobotController(const PumaAngles& start, const JointLimits& limits, const Settings& settings);
+			~RobotController();
+
+			RobotController(const RobotController&) = delete;
+			RobotController& operator=(const RobotController&) = delete;
+
+			void Start();
+			//Returns after the current tick; queued trajectories and the state are kept
+			void Stop();
+			bool running() const { return m_thread.joinable(); }
+
+			//Same as TrajectoryPlayer, may be called from any thread; applied at the start of the next tick
+			void Play(JointTrajectory trajectory, bool loop = false);
+			void Queue(JointTrajectory trajectory, bool loop = false);
+
+			//Advances the robot by one period on the calling thread, e.g. for headless runs; not while running
+			void Tick();
+
+			//Latest published state; to be called from one thread only
+			const RobotState& Read() { return m_published.Read(); }
+
+			float period() const { return 1.0f / m_settings.Rate; }
+
+			static const float MAX_LAG;
+			static const float MAX_SPIN_SHARE;
+
+		private:
+			struct Command
+			{
+				JointTrajectory Trajectory;
+				bool Loop, Replace;
+			};
+
+			JointLimits m_limits;
+			Settings m_settings;
+			//used by the control thread only
+			TrajectoryPlayer m_player;
+			RobotState m_state;
+			double m_jitterSum;
+
+			std::mutex m_commandsMutex;
+			std::vector<Command> m_commands;
+			std::atomic<bool> m_commandsPending, m_stop;
+			TripleBuffer<RobotState> m_published;
+			std::thread m_thread;
+
+			void Post(Command command);
+			void ApplyCommands();
+			void Step();
+			void Publish();
+			void Loop();
+		};
+	}
+}
@@ -1,6 +1,8 @@
 ﻿#include "roomDemo.h"
+#include <algorithm>
 #include <array>
 #include "mesh.h"
+#include "motionPlanner.h"
 
 using namespace mini;
 using namespace gk2;
@@ -8,7 +10,7 @@ using namespace DirectX;
 using namespace std;
 
 
-RoomDemo::RoomDemo(HINSTANCE appInstance)
+RoomDemo::RoomDemo(HINSTANCE appInstance, bool cpuBillboards)
 	: DxApplication(appInstance, 1280, 720, L"Pokój"), 
 	//Constant Buffers
 	m_cbWorldMtx(m_device.CreateConstantBuffer<XMFLOAT4X4>()),
@@ -21,8 +23,13 @@ RoomDemo::RoomDemo(HINSTANCE appInstance)
 	m_smokeTexture(m_device.CreateShaderResourceView(L"resources/textures/smoke.png")),
 	m_opacityTexture(m_device.CreateShaderResourceView(L"resources/textures/smokecolors.png")),
 	m_lightMap(m_device.CreateShaderResourceView(L"resources/textures/light_cookie.png")),
+	//Robot
+	m_pumaChain(PumaKinematics::Chain()),
+	m_pumaController(HOME_POSE),
+	m_pumaContacts(0),
 	//Particles
-	m_particles{ {-1.3f, -0.6f, -0.14f} }
+	m_particles{ {-1.3f, -0.6f, -0.14f} },
+	m_statsTime(0.0f), m_droppedParticles(0)
 {
 	//Projection matrix
 	auto s = m_window.getClientSize();
@@ -81,23 +88,35 @@ RoomDemo::RoomDemo(HINSTANCE appInstance)
 	m_desk = Mesh::Rectangle(m_device, 2.0f);
 	m_box = Mesh::ShadedBox(m_device);
 
-	m_puma[0] = Mesh::LoadMesh(m_device, L"resources/meshes/mesh1.mesh");
-	m_puma[1] = Mesh::LoadMesh(m_device, L"resources/meshes/mesh2.mesh");
-	m_puma[2] = Mesh::LoadMesh(m_device, L"resources/meshes/mesh3.mesh");
-	m_puma[3] = Mesh::LoadMesh(m_device, L"resources/meshes/mesh4.mesh");
-	m_puma[4] = Mesh::LoadMesh(m_device, L"resources/meshes/mesh5.mesh");
-	m_puma[5] = Mesh::LoadMesh(m_device, L"resources/meshes/mesh6.mesh");
+	//CPU copies of puma meshes are kept until collision proxies are fitted to them
+	MeshData pumaMeshes[PumaCollision::LINKS_COUNT];
+	for (auto i = 0U; i < PumaCollision::LINKS_COUNT; ++i)
+	{
+		pumaMeshes[i] = MeshData::Load(L"resources/meshes/mesh" + to_wstring(i + 1) + L".mesh");
+		m_puma[i] = Mesh::LoadMesh(m_device, pumaMeshes[i]);
+	}
+	m_pumaCollision.FitLinks(pumaMeshes);
 
 	//Init angles for puma
 	for (int i = 0; i < 6;i++)
 		a[i] = 0.0f;
+	copy(HOME_POSE.begin(), HOME_POSE.end(), a);
 	A[0] = { 0.0f,0.0f,0.0f,0.0f };
 	A[1] = { 0.0f,0.27f,0.0f,0.0f };
 	A[2] = { -0.91f,0.27f,0.0f,0.0f };
 	A[3] = { 0.0f,0.27f,-0.26f ,0.0f };
 	A[4] = { -1.72f,0.27f,0.0f,0.0f };
 
-	m_vbParticles = m_device.CreateVertexBuffer<ParticleVertex>(ParticleSystem::MAX_PARTICLES);
+	m_particleVertsCount = 0;
+	//all shaders are shader model 5, so the CPU path is a switch rather than a fallback for old feature levels
+	m_cpuBillboards = cpuBillboards;
+	if (m_cpuBillboards)
+	{
+		m_vbParticleQuads = m_device.CreateVertexBuffer<ParticleQuadVertex>(ParticleSystem::MAX_PARTICLES * ParticleBillboards::VERTS_PER_QUAD);
+		m_ibParticleQuads = m_device.CreateIndexBuffer(ParticleBillboards::QuadIndices(ParticleSystem::MAX_PARTICLES));
+	}
+	else
+		m_vbParticles = m_device.CreateVertexBuffer<ParticleVertex>(2 * ParticleSystem::MAX_PARTICLES);
 
 	//World matrix of all objects
 	auto temp = XMMatrixTranslation(0.0f, 0.0f, 2.0f);
@@ -110,6 +129,24 @@ RoomDemo::RoomDemo(HINSTANCE appInstance)
 	temp = XMMatrixTranslation(0.0f, 1.0f, 1.0f);
 	XMStoreFloat4x4(&m_deskMtx, temp * XMMatrixRotationY(-XM_PIDIV2) * XMMatrixRotationZ(XM_PI/6));
 	XMStoreFloat4x4(&m_boxMtx, XMMatrixTranslation(-1.4f, -1.46f, -0.6f));
+
+	//Robot collisions with walls, desk and box
+	for (auto& wallMtx : m_wallsMtx)
+		m_pumaCollision.AddPlane(wallMtx);
+	m_pumaCollision.AddBox(m_deskMtx, { 1.0f, 1.0f, 0.01f });
+	m_pumaCollision.AddBox(m_boxMtx, { 0.5f, 0.5f, 0.5f });
+	PlanPumaMotion();
+	m_pumaController.Start();
+
+	//Particle collisions with walls, desk and box
+	auto colliders = make_shared<ParticleColliders>();
+	for (auto& wallMtx : m_wallsMtx)
+		colliders->AddPlane(wallMtx);
+	colliders->AddBox(m_deskMtx, { 1.0f, 1.0f, 0.01f });
+	colliders->AddBox(m_boxMtx, { 0.5f, 0.5f, 0.5f });
+	m_particles.SetColliders(colliders);
+	m_particles.SetTurbulence(TurbulenceField::Shared());
+	m_particles.SetRepulsion();
 	
 
 	
@@ -120,6 +157,10 @@ RoomDemo::RoomDemo(HINSTANCE appInstance)
 	{
 		XMStoreFloat4x4(&m_pumaMtx[i], XMMatrixTranslation(0.0f, 0.0f, 0.0f));
 	}
+	m_pumaPlacements.push_back(m_pumaMtx[0]);
+	m_pumaAngles.resize(m_pumaPlacements.size());
+	m_vbPumaInstances = m_device.CreateVertexBuffer<XMFLOAT4X4>(PumaInstancePacker::LINKS_COUNT * m_pumaPlacements.size());
+	m_vbToolTrail = m_device.CreateVertexBuffer<VertexPosition>(m_toolTrail.vertices().size());
 
 
 	//Constant buffers content
@@ -140,17 +181,35 @@ RoomDemo::RoomDemo(HINSTANCE appInstance)
 	m_phongVS = m_device.CreateVertexShader(vsCode);
 	m_phongPS = m_device.CreatePixelShader(psCode);
 	m_inputlayout = m_device.CreateInputLayout(VertexPositionNormal::Layout, vsCode);
+	vsCode = m_device.LoadByteCode(L"phongInstancedVS.cso");
+	m_phongInstancedVS = m_device.CreateVertexShader(vsCode);
+	m_instancedLayout = m_device.CreateInputLayout(VertexPositionNormal::InstancedLayout, vsCode);
 
 	psCode = m_device.LoadByteCode(L"lightAndShadowPS.cso");
 	m_lightShadowPS = m_device.CreatePixelShader(psCode);
 
-	vsCode = m_device.LoadByteCode(L"particleVS.cso");
 	psCode = m_device.LoadByteCode(L"particlePS.cso");
-	auto gsCode = m_device.LoadByteCode(L"particleGS.cso");
-	m_particleVS = m_device.CreateVertexShader(vsCode);
 	m_particlePS = m_device.CreatePixelShader(psCode);
-	m_particleGS = m_device.CreateGeometryShader(gsCode);
-	m_particleLayout = m_device.CreateInputLayout<ParticleVertex>(vsCode);
+	if (m_cpuBillboards)
+	{
+		vsCode = m_device.LoadByteCode(L"particleQuadVS.cso");
+		m_particleQuadVS = m_device.CreateVertexShader(vsCode);
+		m_particleQuadLayout = m_device.CreateInputLayout<ParticleQuadVertex>(vsCode);
+	}
+	else
+	{
+		vsCode = m_device.LoadByteCode(L"particleVS.cso");
+		auto gsCode = m_device.LoadByteCode(L"particleGS.cso");
+		m_particleVS = m_device.CreateVertexShader(vsCode);
+		m_particleGS = m_device.CreateGeometryShader(gsCode);
+		m_particleLayout = m_device.CreateInputLayout<ParticleVertex>(vsCode);
+	}
+
+	vsCode = m_device.LoadByteCode(L"trailVS.cso");
+	psCode = m_device.LoadByteCode(L"trailPS.cso");
+	m_trailVS = m_device.CreateVertexShader(vsCode);
+	m_trailPS = m_device.CreatePixelShader(psCode);
+	m_trailLayout = m_device.CreateInputLayout<VertexPosition>(vsCode);
 
 	m_device.context()->IASetInputLayout(m_inputlayout.get());
 	m_device.context()->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
@@ -177,35 +236,18 @@ void RoomDemo::UpdateCameraCB(XMMATRIX viewMtx)
 
 void RoomDemo::UpdateLamp(float dt)
 {
-	static auto time = 0.0f;
-	//time += dt;
-	auto swing = 0.3f * XMScalarSin(XM_2PI*time / 8);
-	auto rot = XM_2PI*time / 20;
-	auto lamp = XMMatrixTranslation(0.0f, -0.4f, 0.0f) * XMMatrixRotationX(swing) * XMMatrixRotationY(rot) *
-		XMMatrixTranslation(0.0f, 2.0f, 0.0f);
-
+	//m_lampAnimation.Update(dt);
+	auto lamp = m_lampAnimation.lampMatrix();
 	XMStoreFloat4x4(&m_lampMtx, lamp);
 
-	XMFLOAT4 lightPos{ 0.0f, -0.05f, 0.0f, 1.0f };
-	XMFLOAT4 lightTarget{ 0.0f, -10.0f, 0.0f, 1.0f };
-	XMFLOAT4 upDir{ 1.0f, 0.0f, 0.0f, 0.0f };
-
 	XMFLOAT4X4 texMtx;
 
 	// TODO : 1.04 Calculate new light position in world coordinates
-	XMFLOAT3 wcLightPos;
-	XMStoreFloat3(&wcLightPos, XMVector3TransformCoord(XMLoadFloat4(&lightPos), lamp));
+	auto wcLightPos = m_lampAnimation.lightPosition();
 	UpdateBuffer(m_cbLightPos, XMFLOAT4(wcLightPos.x, wcLightPos.y, wcLightPos.z, 1.0f));
-	//UpdateBuffer(m_cbLightPos, lightPos);
 
 	// TODO : 1.01 Calculate light's view and inverted view matrix
-	XMFLOAT3 lightCamPos;
-	XMFLOAT3 lightCamTarget;
-	XMFLOAT3 lightCamUpDir;
-	XMStoreFloat3(&lightCamPos, XMVector3TransformCoord(XMLoadFloat4(&lightPos), lamp));
-	XMStoreFloat3(&lightCamTarget, XMVector3TransformCoord(XMLoadFloat4(&lightTarget), lamp));
-	XMStoreFloat3(&lightCamUpDir, XMVector3TransformNormal(XMLoadFloat4(&upDir), lamp));
-	auto lightCamViewMtx = XMMatrixLookAtLH(XMLoadFloat3(&lightCamPos), XMLoadFloat3(&lightCamTarget), XMLoadFloat3(&lightCamUpDir));
+	auto lightCamViewMtx = m_lampAnimation.lightViewMatrix();
 	XMStoreFloat4x4(&m_lightViewMtx[0], lightCamViewMtx);
 	XMStoreFloat4x4(&m_lightViewMtx[1], XMMatrixInverse(nullptr, lightCamViewMtx));
 
@@ -225,54 +267,90 @@ void RoomDemo::UpdateLamp(float dt)
 
 void mini::gk2::RoomDemo::UpdateParticles(float dt)
 {
-	auto verts = m_particles.Update(dt, m_camera.getCameraPosition());
-	UpdateBuffer(m_vbParticles, verts);
+	const vector<ParticleSystem*> emitters{ &m_particles };
+	auto cameraPos = m_camera.getCameraPosition();
+	m_particleBudget.Distribute(emitters, cameraPos, m_projMtx);
+	auto viewProj = m_camera.getViewMatrix() * XMLoadFloat4x4(&m_projMtx);
+	m_particleVerts = m_particles.Update(dt, cameraPos, ViewFrustum(viewProj));
+	m_particleBudget.Collect(emitters);
+	ShowParticleStats(dt);
+	//particles out of view still cast shadows, so the shadow map pass is culled against the light's frustum;
+	//the shadow map pass only writes depth without blending, so its set needs no sorting
+	auto lightViewProj = XMLoadFloat4x4(&m_lightViewMtx[0]) * XMLoadFloat4x4(&m_lightProjMtx);
+	m_shadowParticleVerts = m_particles.GetParticleVerts(ViewFrustum(lightViewProj), m_particles.interpolation());
+	m_particleVertsCount = static_cast<unsigned int>(m_particleVerts.size());
+	//quads depend on the view matrix of the pass, so the CPU path uploads them in DrawParticles
+	if (!m_cpuBillboards)
+	{
+		UpdateBuffer(m_vbParticles, m_particleVerts);
+		UpdateBufferRange(m_vbParticles, m_particleVerts.size() * sizeof(ParticleVertex), m_shadowParticleVerts.data(),
+			m_shadowParticleVerts.size() * sizeof(ParticleVertex), false);
+	}
 }
 
-void mini::gk2::RoomDemo::UpdatePumaMatrices()
+void mini::gk2::RoomDemo::ShowParticleStats(float dt)
 {
-	XMMATRIX mat[5];
-	mat[0] = XMMatrixRotationY(a[0]);
-	mat[1] = XMMatrixTranslation(0.0f, -0.27f, 0.0f) * XMMatrixRotationZ(a[1]) * XMMatrixTranslation(0.0f, 0.27f, 0.0f) * mat[0];
-	mat[2] = XMMatrixTranslation(0.91f, -0.27f, 0.0f) * XMMatrixRotationZ(a[2]) * XMMatrixTranslation(-0.91f, 0.27f, 0.0f) * mat[1];
-	mat[3] = XMMatrixTranslation(0.0f, -0.27f, 0.26f) * XMMatrixRotationX(a[3]) * XMMatrixTranslation(0.0f, 0.27f, -0.26f) * mat[2];
-	mat[4] = XMMatrixTranslation(1.72f, -0.27f, 0.0f) * XMMatrixRotationZ(a[4]) * XMMatrixTranslation(-1.72f, 0.27f, 0.0f) * mat[3];
-
-	for (int i = 0; i < 5; i++)
-	{
-		XMStoreFloat4x4(&m_pumaMtx[i+1], mat[i]);
-	}	
-	
+	//dropped particles of single frames are easy to miss, so they are summed between updates
+	auto& stats = m_particleBudget.lastFrameStats();
+	m_droppedParticles += stats.dropped;
+	m_statsTime += dt;
+	if (m_statsTime < STATS_INTERVAL)
+		return;
+	auto title = L"Pokój - particles: " + to_wstring(stats.used) + L"/" + to_wstring(stats.budget) +
+		L", dropped: " + to_wstring(m_droppedParticles);
+	SetWindowTextW(m_window.getHandle(), title.c_str());
+	m_statsTime = 0.0f;
+	m_droppedParticles = 0;
 }
 
-void inverse_kinematics(XMFLOAT3 pos, XMFLOAT3 normal, float& a1, float& a2, float& a3, float& a4, float& a5)
+void mini::gk2::RoomDemo::UpdatePumaMatrices()
 {
-	//float l1 = .91f, l2 = .81f, l3 = .33f, dy = .27f, dz = .26f;
-	//normal.normalize();
-	//XMFLOAT3 pos1 = pos + normal * l3;
-	//float e = sqrtf(pos1.z * pos1.z + pos1.x * pos1.x - dz * dz);
-	//a1 = atan2(pos1.z, -pos1.x) + atan2(dz, e);
-	//XMFLOAT3 pos2(e, pos1.y - dy, .0f);
-	//a3 = -acosf(min(1.0f, (pos2.x * pos2.x + pos2.y * pos2.y - l1 * l1 - l2 * l2)
-	//	/ (2.0f * l1 * l2)));
-	//float k = l1 + l2 * cosf(a3), l = l2 * sinf(a3);
-	//a2 = -atan2(pos2.y, sqrtf(pos2.x * pos2.x + pos2.z * pos2.z)) - atan2(l, k);
-	//XMFLOAT3 normal1;
-	//normal1 = XMFLOAT3(RotateRadMatrix44('y', -a1) *
-	//	XMFLOAT4(normal.x, normal.y, normal.z, .0f));
-	//normal1 = vector3(RotateRadMatrix44('z', -(a2 + a3)) *
-	//	vector4(normal1.x, normal1.y, normal1.z, .0f));
-	//a5 = acosf(normal1.x);
-	//a4 = atan2(normal1.z, normal1.y);
+	//latest state of the control thread, its timing is in Stats
+	auto& state = m_pumaController.Read();
+	copy(state.Angles.begin(), state.Angles.end(), a);
+	m_pumaChain.SetAngles(a);
+	if (!m_pumaChain.Update())
+		return;
+	copy(m_pumaChain.linkMatrices(), m_pumaChain.linkMatrices() + m_pumaChain.jointsCount(), m_pumaMtx + 1);
+	//the tool touches the desk while drawing, so only the other links are checked
+	m_pumaContacts = m_pumaCollision.CollidingLinks(m_pumaMtx, PumaCollision::ALL_LINKS & ~(1U << PumaCollision::TOOL_LINK));
+	fill(m_pumaAngles.begin(), m_pumaAngles.end(), PumaAngles{ a[0], a[1], a[2], a[3], a[4] });
+	m_pumaPacker.Pack(m_pumaAngles.size(), m_pumaAngles.data(), m_pumaPlacements.data(), m_pumaInstances);
+	UpdateBuffer(m_vbPumaInstances, m_pumaInstances);
+
+	XMFLOAT3 tip, normal;
+	PumaKinematics::EndEffector(m_pumaAngles.front(), tip, normal);
+	m_toolTrail.Push(tip);
 }
 
+void RoomDemo::PlanPumaMotion()
+{
+	//draw a circle on the desk forever, after moving there from the home pose
+	const auto links = PumaCollision::ALL_LINKS & ~(1U << PumaCollision::TOOL_LINK);
+	auto circle = CirclePath::OnPlane(m_deskMtx, { 0.0f, 0.0f }, 0.4f);
+	JointTrajectory drawing;
+	if (!TrajectoryPlanner().Plan(circle, 4.0f, HOME_POSE, drawing))
+		return;
+	vector<uint8_t> contacts(drawing.keysCount());
+	if (m_pumaCollision.CollidingLinksBatch(drawing.keysCount(), drawing.angles().data(), contacts.data(), links))
+		return;
+	//a straight joint move to the circle sweeps the forearm through the desk, so the approach goes around it
+	MotionPlanner::Settings settings;
+	settings.Links = links;
+	MotionPlanner planner(m_pumaCollision, settings);
+	vector<PumaAngles> approach;
+	if (!planner.Plan(HOME_POSE, drawing.angles().front(), approach))
+		return;
+	m_pumaController.Queue(planner.Timed(approach, PathParameterization(JointLimits::Puma())));
+	m_pumaController.Queue(move(drawing), true);
+}
 
 void RoomDemo::Update(const Clock& c)
 {
 	double dt = c.getFrameTime();
 	HandleCameraInput(dt);
 	UpdateLamp(static_cast<float>(dt));
-	UpdateParticles(dt);
+	UpdateParticles(static_cast<float>(dt));
 }
 
 void RoomDemo::SetWorldMtx(DirectX::XMFLOAT4X4 mtx)
@@ -299,10 +377,25 @@ void RoomDemo::DrawMesh(const Mesh& m, DirectX::XMFLOAT4X4 worldMtx)
 	m.Render(m_device.context());
 }
 
-void RoomDemo::DrawParticles()
+void RoomDemo::DrawParticles(XMMATRIX viewMtx, const vector<ParticleVertex>& vertices, unsigned int firstVertex)
 {
 	//Set input layout, primitive topology, shaders, vertex buffer, and draw particles
 	SetTextures({ m_smokeTexture.get(), m_opacityTexture.get() });
+	if (m_cpuBillboards)
+	{
+		ParticleBillboards::Expand(vertices, viewMtx, ParticleSystem::TimeToLive(), m_particleQuads);
+		UpdateBuffer(m_vbParticleQuads, m_particleQuads);
+		m_device.context()->IASetInputLayout(m_particleQuadLayout.get());
+		SetShaders(m_particleQuadVS, m_particlePS);
+		unsigned int stride = sizeof(ParticleQuadVertex);
+		unsigned int offset = 0;
+		auto vb = m_vbParticleQuads.get();
+		m_device.context()->IASetVertexBuffers(0, 1, &vb, &stride, &offset);
+		m_device.context()->IASetIndexBuffer(m_ibParticleQuads.get(), DXGI_FORMAT_R32_UINT, 0);
+		m_device.context()->DrawIndexed(static_cast<unsigned int>(vertices.size()) * ParticleBillboards::INDICES_PER_QUAD, 0, 0);
+		m_device.context()->IASetInputLayout(m_inputlayout.get());
+		return;
+	}
 	m_device.context()->IASetInputLayout(m_particleLayout.get());
 	SetShaders(m_particleVS, m_particlePS);
 	m_device.context()->GSSetShader(m_particleGS.get(), nullptr, 0);
@@ -311,7 +404,7 @@ void RoomDemo::DrawParticles()
 	unsigned int offset = 0;
 	auto vb = m_vbParticles.get();
 	m_device.context()->IASetVertexBuffers(0, 1, &vb, &stride, &offset);
-	m_device.context()->Draw(m_particles.particlesCount(), 0);
+	m_device.context()->Draw(static_cast<unsigned int>(vertices.size()), firstVertex);
 
 	//Reset layout, primitive topology and geometry shader
 	m_device.context()->GSSetShader(nullptr, nullptr, 0);
@@ -319,12 +412,52 @@ void RoomDemo::DrawParticles()
 	m_device.context()->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 }
 
+void RoomDemo::DrawToolTrail()
+{
+	//only the points added since the last frame are copied, unless the trail moved to the start of the buffer
+	auto upload = m_toolTrail.TakeUpload();
+	if (upload.Count)
+		UpdateBufferRange(m_vbToolTrail, upload.First * sizeof(VertexPosition), m_toolTrail.vertices().data() + upload.First,
+			upload.Count * sizeof(VertexPosition), upload.Discard);
+
+	auto range = m_toolTrail.drawRange();
+	if (!range.Count)
+		return;
+	m_device.context()->IASetInputLayout(m_trailLayout.get());
+	m_device.context()->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINESTRIP);
+	SetShaders(m_trailVS, m_trailPS);
+	unsigned int stride = sizeof(VertexPosition);
+	unsigned int offset = 0;
+	auto vb = m_vbToolTrail.get();
+	m_device.context()->IASetVertexBuffers(0, 1, &vb, &stride, &offset);
+	UpdateBuffer(m_cbSurfaceColor, XMFLOAT4{ 1.0f, 0.8f, 0.1f, 1.0f });
+	m_device.context()->Draw(range.Count, range.First);
+
+	//Reset layout, primitive topology and surface color
+	UpdateBuffer(m_cbSurfaceColor, XMFLOAT4{ 1.0f, 1.0f, 1.0f, 1.0f });
+	m_device.context()->IASetInputLayout(m_inputlayout.get());
+	m_device.context()->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+}
+
 void mini::gk2::RoomDemo::DrawPuma()
 {
-	for (int i = 0; i < 6; i++)
+	//each link mesh is drawn for all arms at once, with world matrices from m_vbPumaInstances
+	m_device.context()->IASetInputLayout(m_instancedLayout.get());
+	m_device.context()->VSSetShader(m_phongInstancedVS.get(), nullptr, 0);
+	auto robots = static_cast<unsigned int>(m_pumaPlacements.size());
+	for (auto i = 0U; i < PumaInstancePacker::LINKS_COUNT; i++)
 	{
-		DrawMesh(m_puma[i], m_pumaMtx[i]);
+		//links touching the room are tinted red
+		auto contact = (m_pumaContacts & (1U << i)) != 0;
+		if (contact)
+			UpdateBuffer(m_cbSurfaceColor, XMFLOAT4{ 1.0f, 0.3f, 0.3f, 1.0f });
+		m_puma[i].RenderInstanced(m_device.context(), m_vbPumaInstances, sizeof(XMFLOAT4X4), robots,
+			static_cast<unsigned int>(PumaInstancePacker::FirstInstance(i, robots)));
+		if (contact)
+			UpdateBuffer(m_cbSurfaceColor, XMFLOAT4{ 1.0f, 1.0f, 1.0f, 1.0f });
 	}
+	m_device.context()->VSSetShader(m_phongVS.get(), nullptr, 0);
+	m_device.context()->IASetInputLayout(m_inputlayout.get());
 }
 
 void RoomDemo::DrawScene()
@@ -365,7 +498,7 @@ void RoomDemo::Render()
 	// TODO : 1.17 Render objects and particles (w/o blending) to the shadow map using Phong shaders
 	SetShaders(m_phongVS, m_phongPS);
 	DrawScene();
-	DrawParticles();
+	DrawParticles(XMLoadFloat4x4(&m_lightViewMtx[0]), m_shadowParticleVerts, m_particleVertsCount);
 
 	ResetRenderTarget();
 	UpdateBuffer(m_cbProjMtx, m_projMtx);
@@ -376,10 +509,11 @@ void RoomDemo::Render()
 	SetShaders(m_phongVS, m_lightShadowPS);
 
 	DrawScene();
+	DrawToolTrail();
 
 	m_device.context()->OMSetBlendState(m_bsAlpha.get(), nullptr, UINT_MAX);
 	m_device.context()->OMSetDepthStencilState(m_dssNoWrite.get(), 0);
-	DrawParticles();
+	DrawParticles(m_camera.getViewMatrix(), m_particleVerts, 0);
 	m_device.context()->OMSetBlendState(nullptr, nullptr, UINT_MAX);
 	m_device.context()->OMSetDepthStencilState(nullptr, 0);
 }
\ No newline at end of file
@@ -2,6 +2,15 @@
 #include "dxApplication.h"
 #include "mesh.h"
 #include "particleSystem.h"
+#include "particleBudget.h"
+#include "particleBillboards.h"
+#include "pumaKinematics.h"
+#include "trajectoryPlanner.h"
+#include "pumaCollision.h"
+#include "lampAnimation.h"
+#include "pumaInstances.h"
+#include "robotController.h"
+#include "toolTrail.h"
 
 namespace mini::gk2
 {
@@ -10,7 +19,8 @@ namespace mini::gk2
 	public:
 		using Base = DxApplication;
 
-		explicit RoomDemo(HINSTANCE appInstance);
+		//cpuBillboards expands particle quads with ParticleBillboards instead of the geometry shader
+		explicit RoomDemo(HINSTANCE appInstance, bool cpuBillboards = false);
 
 	protected:
 		void Update(const Clock& dt) override;
@@ -23,6 +33,9 @@ namespace mini::gk2
 		static constexpr float LIGHT_NEAR = 0.35f;
 		static constexpr float LIGHT_FAR = 5.5f;
 		static constexpr float LIGHT_FOV_ANGLE = DirectX::XM_PI / 3.0f;
+		static constexpr float STATS_INTERVAL = 0.5f; //seconds between updates of the statistics in the window title
+		//arm pose at start, shoulder raised as with all joints at 0 the forearm rests on the desk
+		static constexpr PumaAngles HOME_POSE{ 0.0f, -0.5f, 0.0f, 0.0f, 0.0f };
 
 
 
@@ -41,6 +54,7 @@ namespace mini::gk2
 		
 		Mesh m_box; //uses m_boxMtx
 		Mesh m_lamp; //uses m_lampMtx
+		LampAnimation m_lampAnimation; //m_lampMtx and light matrices follow it
 		
 		Mesh m_puma[6];
 		Mesh m_desk;
@@ -50,9 +64,28 @@ namespace mini::gk2
 
 
 		dx_ptr<ID3D11Buffer> m_vbParticles;
+		//m_vbParticles holds m_particleVerts, culled against the camera frustum, followed by m_shadowParticleVerts,
+		//culled against the light's frustum for the shadow map pass
+		unsigned int m_particleVertsCount;
+		//Particle quads are expanded on the CPU into m_vbParticleQuads instead, m_vbParticles is not created then
+		bool m_cpuBillboards;
+		std::vector<ParticleVertex> m_particleVerts, m_shadowParticleVerts;
+		std::vector<ParticleQuadVertex> m_particleQuads;
+		dx_ptr<ID3D11Buffer> m_vbParticleQuads, m_ibParticleQuads;
 
 		DirectX::XMFLOAT4X4 m_projMtx, m_wallsMtx[6], m_boxMtx, m_lampMtx, m_lightViewMtx[2], m_lightProjMtx, m_deskMtx;
 		DirectX::XMFLOAT4X4 m_pumaMtx[6];
+		KinematicChain m_pumaChain; //link matrices are copied to m_pumaMtx[1..5] when a[0..4] change
+		RobotController m_pumaController; //plays trajectories at 1 kHz on its own thread, a[0..4] follow its state
+		PumaCollision m_pumaCollision; //capsules around m_puma tested against walls, desk and box
+		unsigned int m_pumaContacts; //links of the pose in m_pumaMtx touching the room or each other, bit per link
+		std::vector<DirectX::XMFLOAT4X4> m_pumaPlacements; //base of every arm drawn, all of them follow a[]
+		std::vector<PumaAngles> m_pumaAngles; //a[] for every arm in m_pumaPlacements, sized with them
+		PumaInstancePacker m_pumaPacker;
+		std::vector<DirectX::XMFLOAT4X4> m_pumaInstances; //link matrices of all arms, grouped by link
+		dx_ptr<ID3D11Buffer> m_vbPumaInstances; //m_pumaInstances for instanced drawing of m_puma
+		ToolTrail m_toolTrail; //recent tool tip positions, new ones are appended to m_vbToolTrail before drawing
+		dx_ptr<ID3D11Buffer> m_vbToolTrail;
 
 		dx_ptr<ID3D11SamplerState> m_sampler;
 
@@ -65,23 +98,28 @@ namespace mini::gk2
 		dx_ptr<ID3D11BlendState> m_bsAlpha;
 		dx_ptr<ID3D11DepthStencilState> m_dssNoWrite;
 
-		dx_ptr<ID3D11InputLayout> m_inputlayout, m_particleLayout;
+		dx_ptr<ID3D11InputLayout> m_inputlayout, m_instancedLayout, m_particleLayout, m_particleQuadLayout, m_trailLayout;
 
-		dx_ptr<ID3D11VertexShader> m_phongVS, m_particleVS;
+		dx_ptr<ID3D11VertexShader> m_phongVS, m_phongInstancedVS, m_particleVS, m_particleQuadVS, m_trailVS;
 		dx_ptr<ID3D11GeometryShader> m_particleGS;
-		dx_ptr<ID3D11PixelShader> m_phongPS, m_lightShadowPS, m_particlePS;
+		dx_ptr<ID3D11PixelShader> m_phongPS, m_lightShadowPS, m_particlePS, m_trailPS;
 
 		ParticleSystem m_particles;
+		ParticleBudget m_particleBudget; //lastFrameStats() holds particles used and dropped in the last frame
+		float m_statsTime; //since the window title was last updated
+		size_t m_droppedParticles; //summed over frames since the window title was last updated
 
 		void UpdateCameraCB(DirectX::XMMATRIX viewMtx);
 		void UpdateCameraCB() { UpdateCameraCB(m_camera.getViewMatrix()); }
 		void UpdateLamp(float dt);
 		void UpdateParticles(float dt);
 		void UpdatePumaMatrices();
-		void inverse_kinematics(DirectX::XMFLOAT3 pos, DirectX::XMFLOAT3 normal, float& a1, float& a2, float& a3, float& a4, float& a5);
+		void ShowParticleStats(float dt);
+		void PlanPumaMotion();
 
 		void DrawMesh(const Mesh& m, DirectX::XMFLOAT4X4 worldMtx);
-		void DrawParticles();
+		void DrawParticles(DirectX::XMMATRIX viewMtx, const std::vector<ParticleVertex>& vertices, unsigned int firstVertex);
+		void DrawToolTrail();
 
 		void SetWorldMtx(DirectX::XMFLOAT4X4 mtx);
 		void SetShaders(const dx_ptr<ID3D11VertexShader>& vs, const dx_ptr<ID3D11PixelShader>& ps);
@@ -0,0 +1,290 @@
+#include "sceneDistanceField.h"
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include "parallel.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+const float SceneDistanceField::MARGIN = 0.1f;
+const int SceneDistanceField::BAND_CELLS = 2;
+
+namespace
+{
+	//Closest point of triangle abc to p (Ericson, Real-Time Collision Detection 5.1.5)
+	XMVECTOR XM_CALLCONV ClosestPoint(FXMVECTOR p, FXMVECTOR a, FXMVECTOR b, GXMVECTOR c)
+	{
+		auto ab = XMVectorSubtract(b, a), ac = XMVectorSubtract(c, a), ap = XMVectorSubtract(p, a);
+		auto d1 = XMVectorGetX(XMVector3Dot(ab, ap)), d2 = XMVectorGetX(XMVector3Dot(ac, ap));
+		if (d1 <= 0.0f && d2 <= 0.0f)
+			return a;
+		auto bp = XMVectorSubtract(p, b);
+		auto d3 = XMVectorGetX(XMVector3Dot(ab, bp)), d4 = XMVectorGetX(XMVector3Dot(ac, bp));
+		if (d3 >= 0.0f && d4 <= d3)
+			return b;
+		auto vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+			return XMVectorAdd(a, XMVectorScale(ab, d1 / (d1 - d3)));
+		auto cp = XMVectorSubtract(p, c);
+		auto d5 = XMVectorGetX(XMVector3Dot(ab, cp)), d6 = XMVectorGetX(XMVector3Dot(ac, cp));
+		if (d6 >= 0.0f && d5 <= d6)
+			return c;
+		auto vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+			return XMVectorAdd(a, XMVectorScale(ac, d2 / (d2 - d6)));
+		auto va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+			return XMVectorAdd(b, XMVectorScale(XMVectorSubtract(c, b), (d4 - d3) / ((d4 - d3) + (d5 - d6))));
+		auto denom = 1.0f / (va + vb + vc);
+		return XMVectorAdd(a, XMVectorAdd(XMVectorScale(ab, vb * denom), XMVectorScale(ac, vc * denom)));
+	}
+
+	//Does the segment from p along axis by length cross triangle abc? Touching counts, so shared edges don't leak.
+	bool AxisSegmentCrosses(const float (&p)[3], int axis, float length, const float (&a)[3], const float (&b)[3],
+		const float (&c)[3])
+	{
+		//project on the plane perpendicular to the axis and test the 2D point in the 2D triangle
+		auto u = (axis + 1) % 3, v = (axis + 2) % 3;
+		auto edge = [&](const float (&e0)[3], const float (&e1)[3])
+		{
+			return (e1[u] - e0[u]) * (p[v] - e0[v]) - (e1[v] - e0[v]) * (p[u] - e0[u]);
+		};
+		auto w0 = edge(b, c), w1 = edge(c, a), w2 = edge(a, b);
+		auto sum = w0 + w1 + w2;
+		if (fabsf(sum) < 1e-12f)
+			return false;	//triangle parallel to the segment
+		//tolerances scale with the triangle and the cell, as rounding does; surfaces lying on grid planes or
+		//lines, like the walls of a room, would otherwise slip between neighbouring segments
+		auto eps = 1e-5f * fabsf(sum);
+		if (!((w0 >= -eps && w1 >= -eps && w2 >= -eps) || (w0 <= eps && w1 <= eps && w2 <= eps)))
+			return false;
+		auto t = (w0 * a[axis] + w1 * b[axis] + w2 * c[axis]) / sum - p[axis];
+		auto slack = 1e-3f * length;
+		return t >= -slack && t <= length + slack;
+	}
+}
+
+void SceneDistanceField::AddMesh(const MeshData& mesh, const XMFLOAT4X4& worldMtx)
+{
+	auto m = XMLoadFloat4x4(&worldMtx);
+	auto transformed = [&](unsigned short i)
+	{
+		XMFLOAT3 p;
+		XMStoreFloat3(&p, XMVector3TransformCoord(XMLoadFloat3(&mesh.Positions[i]), m));
+		return p;
+	};
+	for (size_t t = 0; t < mesh.trianglesCount(); ++t)
+		m_triangles.push_back({ transformed(mesh.Indices[3 * t]), transformed(mesh.Indices[3 * t + 1]),
+			transformed(mesh.Indices[3 * t + 2]) });
+}
+
+void SceneDistanceField::Build(float cellSize, XMFLOAT3 freePoint, float margin)
+{
+	assert(!m_triangles.empty() && cellSize > 0.0f);
+	auto lo = XMVectorReplicate(FLT_MAX), hi = XMVectorReplicate(-FLT_MAX);
+	for (auto& t : m_triangles)
+		for (auto& p : { t.A, t.B, t.C })
+		{
+			lo = XMVectorMin(lo, XMLoadFloat3(&p));
+			hi = XMVectorMax(hi, XMLoadFloat3(&p));
+		}
+	lo = XMVectorSubtract(lo, XMVectorReplicate(margin));
+	hi = XMVectorAdd(hi, XMVectorReplicate(margin));
+	XMStoreFloat3(&m_origin, lo);
+	m_cellSize = cellSize;
+	m_invCellSize = 1.0f / cellSize;
+	XMFLOAT3 extent;
+	XMStoreFloat3(&extent, XMVectorSubtract(hi, lo));
+	m_size[0] = static_cast<int>(ceilf(extent.x * m_invCellSize)) + 1;
+	m_size[1] = static_cast<int>(ceilf(extent.y * m_invCellSize)) + 1;
+	m_size[2] = static_cast<int>(ceilf(extent.z * m_invCellSize)) + 1;
+
+	m_distances.assign(static_cast<size_t>(m_size[0]) * m_size[1] * m_size[2], FLT_MAX);
+	vector<uint8_t> blocked(m_distances.size(), 0);
+	ExactBand(blocked);
+	Sweep();
+	SignFromFill(freePoint, blocked);
+}
+
+void SceneDistanceField::ExactBand(vector<uint8_t>& blocked)
+{
+	//grid points near every triangle, as [first, last] per axis
+	struct Range
+	{
+		int First[3], Last[3];
+	};
+	vector<Range> ranges(m_triangles.size());
+	const float origin[3] = { m_origin.x, m_origin.y, m_origin.z };
+	for (size_t i = 0; i < m_triangles.size(); ++i)
+	{
+		auto& t = m_triangles[i];
+		const float a[3] = { t.A.x, t.A.y, t.A.z }, b[3] = { t.B.x, t.B.y, t.B.z }, c[3] = { t.C.x, t.C.y, t.C.z };
+		for (auto k = 0; k < 3; ++k)
+		{
+			auto lo = (min({ a[k], b[k], c[k] }) - origin[k]) * m_invCellSize;
+			auto hi = (max({ a[k], b[k], c[k] }) - origin[k]) * m_invCellSize;
+			ranges[i].First[k] = max(0, static_cast<int>(floorf(lo)) - BAND_CELLS);
+			ranges[i].Last[k] = min(m_size[k] - 1, static_cast<int>(ceilf(hi)) + BAND_CELLS);
+		}
+	}
+	//every thread owns a slab of z planes, so triangles overlapping two slabs are split between them without races
+	ParallelFor(static_cast<size_t>(m_size[2]), [&](size_t begin, size_t end)
+	{
+		for (size_t i = 0; i < m_triangles.size(); ++i)
+		{
+			auto& r = ranges[i];
+			auto z0 = max(r.First[2], static_cast<int>(begin)), z1 = min(r.Last[2], static_cast<int>(end) - 1);
+			if (z0 > z1)
+				continue;
+			auto& t = m_triangles[i];
+			auto a = XMLoadFloat3(&t.A), b = XMLoadFloat3(&t.B), c = XMLoadFloat3(&t.C);
+			const float fa[3] = { t.A.x, t.A.y, t.A.z }, fb[3] = { t.B.x, t.B.y, t.B.z }, fc[3] = { t.C.x, t.C.y, t.C.z };
+			for (auto z = z0; z <= z1; ++z)
+				for (auto y = r.First[1]; y <= r.Last[1]; ++y)
+					for (auto x = r.First[0]; x <= r.Last[0]; ++x)
+					{
+						const float p[3] = { m_origin.x + x * m_cellSize, m_origin.y + y * m_cellSize, m_origin.z + z * m_cellSize };
+						auto point = XMVectorSet(p[0], p[1], p[2], 0.0f);
+						auto d = XMVectorGetX(XMVector3Length(XMVectorSubtract(point, ClosestPoint(point, a, b, c))));
+						auto index = Index(x, y, z);
+						m_distances[index] = min(m_distances[index], d);
+						//bit k - the edge to the next grid point along axis k crosses a triangle
+						for (auto k = 0; k < 3; ++k)
+							if (AxisSegmentCrosses(p, k, m_cellSize, fa, fb, fc))
+								blocked[index] |= static_cast<uint8_t>(1U << k);
+					}
+		}
+	}, 4);
+}
+
+void SceneDistanceField::Sweep()
+{
+	const auto h = m_cellSize;
+	auto update = [&](int x, int y, int z)
+	{
+		auto index = Index(x, y, z);
+		//smallest neighbour along every axis
+		float n[3];
+		const int p[3] = { x, y, z };
+		const size_t stride[3] = { 1, static_cast<size_t>(m_size[0]), static_cast<size_t>(m_size[0]) * m_size[1] };
+		for (auto k = 0; k < 3; ++k)
+		{
+			n[k] = FLT_MAX;
+			if (p[k] > 0)
+				n[k] = m_distances[index - stride[k]];
+			if (p[k] + 1 < m_size[k])
+				n[k] = min(n[k], m_distances[index + stride[k]]);
+		}
+		if (n[0] > n[1])
+			swap(n[0], n[1]);
+		if (n[1] > n[2])
+			swap(n[1], n[2]);
+		if (n[0] > n[1])
+			swap(n[0], n[1]);
+		if (n[0] == FLT_MAX)
+			return;
+		//upwind solution of |grad d| = 1 using one, two or three axes
+		auto d = n[0] + h;
+		if (d > n[1])
+		{
+			d = 0.5f * (n[0] + n[1] + sqrtf(max(0.0f, 2.0f * h * h - (n[0] - n[1]) * (n[0] - n[1]))));
+			if (d > n[2])
+			{
+				auto sum = n[0] + n[1] + n[2];
+				auto squares = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+				d = (sum + sqrtf(max(0.0f, sum * sum - 3.0f * (squares - h * h)))) / 3.0f;
+			}
+		}
+		m_distances[index] = min(m_distances[index], d);
+	};
+	//eight sweep directions; rows along x on a plane y + z = level only depend on rows of the previous planes,
+	//so the rows of a plane are swept in parallel, each one in memory order (after Detrixhe et al., A parallel
+	//fast sweeping method for the eikonal equation)
+	auto levels = m_size[1] + m_size[2] - 1;
+	for (auto direction = 0; direction < 8; ++direction)
+	{
+		auto flip = [&](int v, int axis) { return direction & (1 << axis) ? m_size[axis] - 1 - v : v; };
+		for (auto level = 0; level < levels; ++level)
+		{
+			auto y0 = max(0, level - (m_size[2] - 1)), y1 = min(m_size[1] - 1, level);
+			ParallelFor(static_cast<size_t>(y1 - y0 + 1), [&](size_t begin, size_t end)
+			{
+				for (auto y = y0 + static_cast<int>(begin); y < y0 + static_cast<int>(end); ++y)
+					for (auto x = 0; x < m_size[0]; ++x)
+						update(flip(x, 0), flip(y, 1), flip(level - y, 2));
+			}, 8);
+		}
+	}
+}
+
+void SceneDistanceField::SignFromFill(XMFLOAT3 freePoint, const vector<uint8_t>& blocked)
+{
+	auto toGrid = [this](float v, float origin, int axis)
+	{
+		return clamp(static_cast<int>(lroundf((v - origin) * m_invCellSize)), 0, m_size[axis] - 1);
+	};
+	vector<uint8_t> reached(m_distances.size(), 0);
+	vector<size_t> stack{ Index(toGrid(freePoint.x, m_origin.x, 0), toGrid(freePoint.y, m_origin.y, 1),
+		toGrid(freePoint.z, m_origin.z, 2)) };
+	reached[stack.back()] = 1;
+	const size_t stride[3] = { 1, static_cast<size_t>(m_size[0]), static_cast<size_t>(m_size[0]) * m_size[1] };
+	while (!stack.empty())
+	{
+		auto index = stack.back();
+		stack.pop_back();
+		const int p[3] = { static_cast<int>(index % stride[1]), static_cast<int>(index / stride[1] % m_size[1]),
+			static_cast<int>(index / stride[2]) };
+		for (auto k = 0; k < 3; ++k)
+		{
+			//an edge is blocked if flagged on its lower end
+			if (p[k] + 1 < m_size[k] && !(blocked[index] & (1U << k)) && !reached[index + stride[k]])
+			{
+				reached[index + stride[k]] = 1;
+				stack.push_back(index + stride[k]);
+			}
+			if (p[k] > 0 && !(blocked[index - stride[k]] & (1U << k)) && !reached[index - stride[k]])
+			{
+				reached[index - stride[k]] = 1;
+				stack.push_back(index - stride[k]);
+			}
+		}
+	}
+	ParallelFor(m_distances.size(), [&](size_t begin, size_t end)
+	{
+		for (auto i = begin; i < end; ++i)
+			if (!reached[i])
+				m_distances[i] = -m_distances[i];
+	}, 1 << 16);
+}
+
+void SceneDistanceField::DistanceBatch(size_t count, const XMFLOAT3* points, float* distances, XMFLOAT3* gradients) const
+{
+	ParallelFor(count, [&](size_t begin, size_t end)
+	{
+		for (auto i = begin; i < end; ++i)
+		{
+			if (!gradients)
+			{
+				distances[i] = Distance(XMLoadFloat3(&points[i]));
+				continue;
+			}
+			XMVECTOR gradient;
+			distances[i] = Distance(XMLoadFloat3(&points[i]), gradient);
+			XMStoreFloat3(&gradients[i], gradient);
+		}
+	}, 4096);
+}
+
+float XM_CALLCONV SceneDistanceField::ExactDistance(FXMVECTOR point) const
+{
+	auto best = FLT_MAX;
+	for (auto& t : m_triangles)
+	{
+		auto closest = ClosestPoint(point, XMLoadFloat3(&t.A), XMLoadFloat3(&t.B), XMLoadFloat3(&t.C));
+		best = min(best, XMVectorGetX(XMVector3Length(XMVectorSubtract(point, closest))));
+	}
+	return best;
+}
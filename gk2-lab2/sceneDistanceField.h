@@ -0,0 +1,103 @@
+#pragma once
+#include <DirectXMath.h>
+#include <algorithm>
+#include <vector>
+#include "meshData.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Signed distance to static scene geometry sampled on a regular grid, for clearance queries of planners.
+		//Build computes exact point-triangle distances in parallel for grid points in a narrow band around the
+		//triangles and fills the rest by fast sweeping of the eikonal equation, the rows of every sweep running
+		//in parallel plane by plane. Scene surfaces needn't be closed (walls and the desk are single rectangles),
+		//so the sign comes from a flood fill of the grid from a free point that doesn't cross any triangle: space
+		//inside closed meshes or behind walls is negative. Queries interpolate the samples trilinearly and take a few
+		//nanoseconds; the gradient is that of the interpolation, pointing away from the nearest surface.
+		class SceneDistanceField
+		{
+		public:
+			//Triangles of a mesh transformed by worldMtx; Build must be called after adding all meshes
+			void AddMesh(const MeshData& mesh, const DirectX::XMFLOAT4X4& worldMtx);
+			//Samples the distance every cellSize over the bounds of the triangles extended by margin.
+			//freePoint - any point outside the obstacles, e.g. where the robot stands
+			void Build(float cellSize, DirectX::XMFLOAT3 freePoint, float margin = MARGIN);
+
+			//Outside the grid the distance to the grid is added
+			float XM_CALLCONV Distance(DirectX::FXMVECTOR point) const { return Sample(point, nullptr); }
+			float XM_CALLCONV Distance(DirectX::FXMVECTOR point, DirectX::XMVECTOR& gradient) const { return Sample(point, &gradient); }
+			//count queries split between threads; gradients may be null
+			void DistanceBatch(size_t count, const DirectX::XMFLOAT3* points, float* distances,
+				DirectX::XMFLOAT3* gradients = nullptr) const;
+			//Unsigned distance to the nearest triangle without the grid, O(triangles)
+			float XM_CALLCONV ExactDistance(DirectX::FXMVECTOR point) const;
+
+			bool empty() const { return m_distances.empty(); }
+			float cellSize() const { return m_cellSize; }
+			size_t trianglesCount() const { return m_triangles.size(); }
+			size_t samplesCount() const { return m_distances.size(); }
+
+			static const float MARGIN;
+			static const int BAND_CELLS;	//grid points this close to a triangle get exact distances
+
+		private:
+			struct Triangle
+			{
+				DirectX::XMFLOAT3 A, B, C;
+			};
+
+			std::vector<Triangle> m_triangles;
+			std::vector<float> m_distances;		//x changes fastest, then y, then z
+			DirectX::XMFLOAT3 m_origin;			//position of the first sample
+			float m_cellSize = 1.0f, m_invCellSize = 1.0f;
+			int m_size[3] = { 0, 0, 0 };
+
+			size_t Index(int x, int y, int z) const { return (static_cast<size_t>(z) * m_size[1] + y) * m_size[0] + x; }
+			void ExactBand(std::vector<uint8_t>& blocked);
+			void Sweep();
+			void SignFromFill(DirectX::XMFLOAT3 freePoint, const std::vector<uint8_t>& blocked);
+
+			float XM_CALLCONV Sample(DirectX::FXMVECTOR point, DirectX::XMVECTOR* gradient) const;
+		};
+
+		inline float XM_CALLCONV SceneDistanceField::Sample(DirectX::FXMVECTOR point, DirectX::XMVECTOR* gradient) const
+		{
+			using namespace DirectX;
+			auto grid = XMVectorScale(XMVectorSubtract(point, XMLoadFloat3(&m_origin)), m_invCellSize);
+			auto last = XMVectorSet(static_cast<float>(m_size[0] - 1), static_cast<float>(m_size[1] - 1),
+				static_cast<float>(m_size[2] - 1), 0.0f);
+			auto clamped = XMVectorClamp(grid, XMVectorZero(), last);
+			//the cell's far corner must be a sample, so the last plane is reached with a fraction of 1
+			auto cell = XMVectorMin(XMVectorFloor(clamped), XMVectorSubtract(last, XMVectorSplatOne()));
+			auto f = XMVectorSubtract(clamped, cell);
+			XMFLOAT3 c;
+			XMStoreFloat3(&c, cell);
+			auto strideY = static_cast<size_t>(m_size[0]), strideZ = strideY * m_size[1];
+			auto s = m_distances.data() + Index(static_cast<int>(c.x), static_cast<int>(c.y), static_cast<int>(c.z));
+			//corners in (y, z) order: 00, 10, 01, 11, at x and at x + 1
+			auto lo = XMVectorSet(s[0], s[strideY], s[strideZ], s[strideZ + strideY]);
+			auto hi = XMVectorSet(s[1], s[strideY + 1], s[strideZ + 1], s[strideZ + strideY + 1]);
+			auto fx = XMVectorSplatX(f), fy = XMVectorSplatY(f), fz = XMVectorSplatZ(f);
+			auto dx = XMVectorSubtract(hi, lo);
+			auto alongX = XMVectorMultiplyAdd(fx, dx, lo);
+			//bilinear weights of the four (y, z) corners
+			auto one = XMVectorSplatOne();
+			auto wy = XMVectorSelect(XMVectorSubtract(one, fy), fy, XMVectorSelectControl(0, 1, 0, 1));
+			auto wz = XMVectorSelect(XMVectorSubtract(one, fz), fz, XMVectorSelectControl(0, 0, 1, 1));
+			auto weights = XMVectorMultiply(wy, wz);
+			auto distance = XMVectorGetX(XMVector4Dot(alongX, weights));
+			auto outside = XMVectorGetX(XMVector3Length(XMVectorSubtract(grid, clamped))) * m_cellSize;
+			if (gradient)
+			{
+				auto sign = XMVectorSet(-1.0f, 1.0f, -1.0f, 1.0f);
+				auto gx = XMVector4Dot(dx, weights);
+				auto gy = XMVector4Dot(alongX, XMVectorMultiply(sign, wz));
+				auto gz = XMVector4Dot(alongX, XMVectorMultiply(XMVectorSwizzle<0, 2, 1, 3>(sign), wy));
+				*gradient = XMVectorScale(XMVectorSelect(XMVectorSelect(gx, gy, XMVectorSelectControl(0, 1, 0, 0)), gz,
+					XMVectorSelectControl(0, 0, 1, 1)), m_invCellSize);
+			}
+			return distance + outside;
+		}
+	}
+}
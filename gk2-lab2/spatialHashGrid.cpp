@@ -0,0 +1,79 @@
+#include "spatialHashGrid.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+SpatialHashGrid::SpatialHashGrid(float cellSize)
+	: m_cellSize(cellSize), m_invCellSize(1.0f / cellSize), m_bucketMask(0)
+{ }
+
+void SpatialHashGrid::Build(const XMFLOAT3* positions, size_t count, size_t stride)
+{
+	//about two buckets per point keeps collisions between distinct cells rare
+	uint32_t buckets = 16;
+	while (buckets < 2 * count)
+		buckets <<= 1;
+	m_bucketMask = buckets - 1;
+	m_bucketStart.assign(buckets + 1, 0);
+	m_points.resize(count);
+	m_pointBucket.resize(count);
+	m_slot.resize(count);
+
+	auto base = reinterpret_cast<const uint8_t*>(positions);
+	auto position = [base, stride](size_t i) { return *reinterpret_cast<const XMFLOAT3*>(base + i * stride); };
+	ParallelFor(count, [&](size_t begin, size_t end)
+	{
+		for (auto i = begin; i < end; ++i)
+		{
+			auto p = position(i);
+			m_pointBucket[i] = Bucket(Cell(p.x), Cell(p.y), Cell(p.z));
+		}
+	}, 4096);
+
+	//counting sort: bucket sizes, prefix sums, then scatter
+	for (size_t i = 0; i < count; ++i)
+		++m_bucketStart[m_pointBucket[i] + 1];
+	for (size_t b = 0; b < buckets; ++b)
+		m_bucketStart[b + 1] += m_bucketStart[b];
+	vector<uint32_t> next(m_bucketStart.begin(), m_bucketStart.end() - 1);
+	for (size_t i = 0; i < count; ++i)
+		m_slot[i] = next[m_pointBucket[i]]++;
+	ParallelFor(count, [&](size_t begin, size_t end)
+	{
+		for (auto i = begin; i < end; ++i)
+			m_points[m_slot[i]] = { position(i), static_cast<uint32_t>(i) };
+	}, 4096);
+}
+
+XMFLOAT3 SpatialHashGrid::position(size_t index) const
+{
+	return m_points[m_slot[index]].Pos;
+}
+
+size_t SpatialHashGrid::QueryBuckets(XMFLOAT3 center, float radius, uint32_t (&buckets)[MAX_QUERY_BUCKETS]) const
+{
+	auto x0 = Cell(center.x - radius), x1 = Cell(center.x + radius);
+	auto y0 = Cell(center.y - radius), y1 = Cell(center.y + radius);
+	auto z0 = Cell(center.z - radius), z1 = Cell(center.z + radius);
+	auto cells = static_cast<int64_t>(x1 - x0 + 1) * (y1 - y0 + 1) * (z1 - z0 + 1);
+	if (cells > static_cast<int64_t>(MAX_QUERY_BUCKETS))
+		return MAX_QUERY_BUCKETS + 1;
+	size_t count = 0;
+	uint64_t seen = 0;	//bit b % 64 set for each bucket b already listed
+	for (auto z = z0; z <= z1; ++z)
+		for (auto y = y0; y <= y1; ++y)
+			for (auto x = x0; x <= x1; ++x)
+			{
+				auto b = Bucket(x, y, z);
+				auto bit = uint64_t(1) << (b & 63);
+				//different cells can share a bucket, which must not be visited twice;
+				//the bit mask makes the search rare
+				if ((seen & bit) && find(buckets, buckets + count, b) != buckets + count)
+					continue;
+				seen |= bit;
+				buckets[count++] = b;
+			}
+	return count;
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <DirectXMath.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "parallel.h"
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Uniform grid over an unbounded space, with cells hashed into a table of buckets.
+		//Build sorts point indices by bucket with a counting sort, so every bucket is a contiguous
+		//range of m_points and both building and querying take time linear in the number of points.
+		class SpatialHashGrid
+		{
+		public:
+			//cellSize should be close to the typical query radius
+			explicit SpatialHashGrid(float cellSize = 0.1f);
+
+			//positions - address of the first position, stride - distance in bytes between consecutive positions
+			void Build(const DirectX::XMFLOAT3* positions, size_t count, size_t stride = sizeof(DirectX::XMFLOAT3));
+			void SetCellSize(float cellSize) { m_cellSize = cellSize; m_invCellSize = 1.0f / cellSize; }
+
+			//Calls f(index, distanceSquared) for every point within radius of center
+			template<typename F>
+			void QueryRadius(DirectX::XMFLOAT3 center, float radius, F&& f) const;
+			//Calls f(i, j, distanceSquared) for every point i and each of its neighbours j != i within radius.
+			//Points are split between threads, so f may only modify data of point i.
+			template<typename F>
+			void ForEachNeighbour(float radius, F&& f) const;
+
+			size_t pointsCount() const { return m_points.size(); }
+			float cellSize() const { return m_cellSize; }
+			DirectX::XMFLOAT3 position(size_t index) const;
+
+		private:
+			struct Point
+			{
+				DirectX::XMFLOAT3 Pos;
+				uint32_t Index;	//index passed to Build
+			};
+
+			static const size_t MAX_QUERY_BUCKETS = 64;	//cells visited by a single query, larger queries scan all points
+
+			float m_cellSize;
+			float m_invCellSize;
+			uint32_t m_bucketMask;
+			std::vector<uint32_t> m_bucketStart;	//m_points range of bucket b is [m_bucketStart[b], m_bucketStart[b+1])
+			std::vector<Point> m_points;			//points sorted by bucket
+			std::vector<uint32_t> m_pointBucket;	//bucket of each point in Build order
+			std::vector<uint32_t> m_slot;			//position of each point (in Build order) in m_points
+
+			int Cell(float x) const { return static_cast<int>(floorf(x * m_invCellSize)); }
+			uint32_t Bucket(int x, int y, int z) const
+			{
+				return ((static_cast<uint32_t>(x) * 73856093U) ^ (static_cast<uint32_t>(y) * 19349663U) ^
+					(static_cast<uint32_t>(z) * 83492791U)) & m_bucketMask;
+			}
+			//Distinct buckets of cells overlapping the cube around center, returns their number
+			//or MAX_QUERY_BUCKETS + 1 if there are too many cells and all points must be scanned
+			size_t QueryBuckets(DirectX::XMFLOAT3 center, float radius, uint32_t (&buckets)[MAX_QUERY_BUCKETS]) const;
+		};
+
+		template<typename F>
+		void SpatialHashGrid::QueryRadius(DirectX::XMFLOAT3 center, float radius, F&& f) const
+		{
+			if (m_points.empty())
+				return;
+			uint32_t buckets[MAX_QUERY_BUCKETS];
+			auto count = QueryBuckets(center, radius, buckets);
+			auto r2 = radius * radius;
+			//buckets may contain points from other cells, so the distance is always checked
+			auto visit = [&](uint32_t begin, uint32_t end)
+			{
+				for (auto k = begin; k < end; ++k)
+				{
+					auto& p = m_points[k];
+					float dx = p.Pos.x - center.x, dy = p.Pos.y - center.y, dz = p.Pos.z - center.z;
+					auto d2 = dx * dx + dy * dy + dz * dz;
+					if (d2 <= r2)
+						f(static_cast<size_t>(p.Index), d2);
+				}
+			};
+			if (count > MAX_QUERY_BUCKETS)
+				visit(0, static_cast<uint32_t>(m_points.size()));
+			else
+				for (size_t b = 0; b < count; ++b)
+					visit(m_bucketStart[buckets[b]], m_bucketStart[buckets[b] + 1]);
+		}
+
+		template<typename F>
+		void SpatialHashGrid::ForEachNeighbour(float radius, F&& f) const
+		{
+			//iterating in bucket order keeps neighbouring points in cache
+			ParallelFor(m_points.size(), [&](size_t begin, size_t end)
+			{
+				for (auto k = begin; k < end; ++k)
+				{
+					auto& p = m_points[k];
+					auto i = static_cast<size_t>(p.Index);
+					QueryRadius(p.Pos, radius, [&](size_t j, float d2)
+					{
+						if (j != i)
+							f(i, j, d2);
+					});
+				}
+			}, 1024);
+		}
+	}
+}
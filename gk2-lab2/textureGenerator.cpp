@@ -1,4 +1,5 @@
 #include "textureGenerator.h"
+#include <cmath>
 
 using namespace mini::gk2;
 
@@ -50,6 +51,35 @@ float TextureGenerator::Noise2D(float x, float y) const
 	return sum;
 }
 
+float TextureGenerator::Noise1(int x, int y, int z, int seed)
+{
+	return Noise1(x + z * 131 + seed * 1013, y);
+}
+
+float TextureGenerator::InterpolatedNoise1(float x, float y, float z, int period, int seed)
+{
+	auto ix = static_cast<int>(floorf(x)), iy = static_cast<int>(floorf(y)), iz = static_cast<int>(floorf(z));
+	auto fx = x - ix, fy = y - iy, fz = z - iz;
+	auto wrap = [period](int i) { return ((i % period) + period) % period; };
+	auto x0 = wrap(ix), x1 = wrap(ix + 1), y0 = wrap(iy), y1 = wrap(iy + 1), z0 = wrap(iz), z1 = wrap(iz + 1);
+	auto v00 = Interpolate(Noise1(x0, y0, z0, seed), Noise1(x1, y0, z0, seed), fx);
+	auto v10 = Interpolate(Noise1(x0, y1, z0, seed), Noise1(x1, y1, z0, seed), fx);
+	auto v01 = Interpolate(Noise1(x0, y0, z1, seed), Noise1(x1, y0, z1, seed), fx);
+	auto v11 = Interpolate(Noise1(x0, y1, z1, seed), Noise1(x1, y1, z1, seed), fx);
+	return Interpolate(Interpolate(v00, v10, fy), Interpolate(v01, v11, fy), fz);
+}
+
+float TextureGenerator::Noise3D(float x, float y, float z, int period, int seed) const
+{
+	auto sum = 0.f;
+	auto amplitude = 1.f;
+	auto frequency = 1.f;
+	//each octave repeats after period*frequency lattice cells, i.e. after the same period in input units
+	for (auto i = 0U; i < m_octaves; ++i, amplitude *= m_persistance, frequency *= 2)
+		sum += InterpolatedNoise1(x * frequency, y * frequency, z * frequency, period * static_cast<int>(frequency), seed + i) * amplitude;
+	return sum;
+}
+
 float TextureGenerator::Wood(float x, float y) const
 {
 	// TODO : 0.? modify the function to generate wood-like pattern
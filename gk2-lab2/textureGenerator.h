@@ -13,6 +13,9 @@ namespace mini
 
 			float Noise2D(float x, float y) const;
 			float Wood(float x, float y) const;
+			//3D noise repeating every period units (period > 0) along each axis.
+			//Different seeds give uncorrelated noise.
+			float Noise3D(float x, float y, float z, int period, int seed = 0) const;
 
 		private:
 			unsigned m_octaves;
@@ -22,6 +25,8 @@ namespace mini
 			static float SmoothNoise1(int x, int y);
 			static float InterpolatedNoise1(float x, float y);
 			static float Interpolate(float a, float b, float t);
+			static float Noise1(int x, int y, int z, int seed);
+			static float InterpolatedNoise1(float x, float y, float z, int period, int seed);
 		};
 	}
 }
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "toolTrail.h"
+#include <algorithm>
+#include <cassert>
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+const size_t ToolTrail::CAPACITY = 4096;
+const float ToolTrail::MIN_DISTANCE = 0.002f;
+
+ToolTrail::ToolTrail(size_t capacity, float minDistance)
+	: m_vertices(2 * capacity), m_capacity(capacity), m_minDistanceSq(minDistance * minDistance), m_first(0), m_end(0),
+	m_uploaded(0), m_discard(false)
+{
+	assert(capacity >= 2);
+}
+
+bool ToolTrail::Push(XMFLOAT3 position)
+{
+	if (m_end > 0)
+	{
+		auto d = XMVectorSubtract(XMLoadFloat3(&position), XMLoadFloat3(&m_vertices[m_end - 1]));
+		if (XMVectorGetX(XMVector3LengthSq(d)) < m_minDistanceSq)
+			return false;
+	}
+	if (m_end == m_vertices.size())
+	{
+		//newest points move to the start once every capacity points, so the copy is cheap on average
+		copy(m_vertices.end() - (m_capacity - 1), m_vertices.end(), m_vertices.begin());
+		m_end = m_capacity - 1;
+		m_discard = true;
+	}
+	m_vertices[m_end++] = position;
+	m_first = m_end > m_capacity ? m_end - m_capacity : 0;
+	return true;
+}
+
+void ToolTrail::Clear()
+{
+	m_first = m_end = 0;
+	m_uploaded = 0;
+	//the GPU may still draw the old trail, so new points can't overwrite it in place
+	m_discard = true;
+}
+
+ToolTrail::Upload ToolTrail::TakeUpload()
+{
+	if (m_discard)
+	{
+		if (m_end == 0)
+			return { 0, 0, false };
+		m_discard = false;
+		m_uploaded = m_end;
+		return { 0, m_end, true };
+	}
+	Upload upload{ m_uploaded, m_end - m_uploaded, false };
+	m_uploaded = m_end;
+	return upload;
+}
+
+ToolTrail::DrawRange ToolTrail::drawRange() const
+{
+	//a strip needs at least one segment
+	if (m_end - m_first < 2)
+		return { 0, 0 };
+	return { static_cast<unsigned int>(m_first), static_cast<unsigned int>(m_end - m_first) };
+}
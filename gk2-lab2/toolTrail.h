@@ -0,0 +1,60 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Recent positions of the robot's tool tip drawn as a line strip.
+		//Points are appended one after another to a vertex array twice the length of the trail, so a frame uploads
+		//only the new vertices and the buffer can be mapped with D3D11_MAP_WRITE_NO_OVERWRITE - draws issued
+		//before never read the vertices written. The trail is always the last capacity() of them. When the array
+		//is full, its newest points are moved to the start and uploaded with D3D11_MAP_WRITE_DISCARD, while the GPU
+		//may still read the old contents, so the strip needs no seam. Doesn't need Direct3D.
+		class ToolTrail
+		{
+		public:
+			//Vertices to copy into the buffer
+			struct Upload
+			{
+				size_t First, Count;
+				bool Discard;	//previous buffer contents must be dropped
+			};
+
+			//Vertices to draw as a line strip
+			struct DrawRange
+			{
+				unsigned int First, Count;
+			};
+
+			explicit ToolTrail(size_t capacity = CAPACITY, float minDistance = MIN_DISTANCE);
+
+			//Adds the point unless it's closer than minDistance to the last one. Returns true if added.
+			bool Push(DirectX::XMFLOAT3 position);
+			void Clear();
+
+			//Vertices changed since the last call; Count is 0 if there's nothing to upload
+			Upload TakeUpload();
+			//Oldest point of the trail first; Count is 0 if there's no segment to draw
+			DrawRange drawRange() const;
+
+			//All vertices, the vertex buffer must hold as many
+			const std::vector<DirectX::XMFLOAT3>& vertices() const { return m_vertices; }
+			//Largest number of points in the trail
+			size_t capacity() const { return m_capacity; }
+			size_t pointsCount() const { return m_end - m_first; }
+
+			static const size_t CAPACITY;
+			static const float MIN_DISTANCE;
+
+		private:
+			std::vector<DirectX::XMFLOAT3> m_vertices;
+			size_t m_capacity;
+			float m_minDistanceSq;
+			size_t m_first, m_end;	//vertices of the trail
+			size_t m_uploaded;		//vertices before it were uploaded, unless a discard is pending
+			bool m_discard;
+		};
+	}
+}
@@ -0,0 +1,9 @@
+cbuffer cbSurfaceColor : register(b0)
+{
+	float4 surfaceColor;
+}
+
+float4 main() : SV_TARGET
+{
+	return surfaceColor;
+}
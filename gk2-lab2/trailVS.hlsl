@@ -0,0 +1,16 @@
+cbuffer cbView : register(b1) //Vertex Shader constant buffer slot 1
+{
+	matrix viewMatrix;
+	matrix invViewMatrix;
+};
+
+cbuffer cbProj : register(b2) //Vertex Shader constant buffer slot 2
+{
+	matrix projMatrix;
+};
+
+float4 main(float3 pos : POSITION) : SV_POSITION
+{
+	//trail points are already in world space
+	return mul(projMatrix, mul(viewMatrix, float4(pos, 1.0f)));
+}
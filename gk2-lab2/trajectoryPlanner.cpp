@@ -0,0 +1,174 @@
+#include "trajectoryPlanner.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+const float TrajectoryPlanner::SAMPLES_PER_SECOND = 120.0f;
+const float TrajectoryPlanner::SAMPLES_PER_METER = 500.0f;
+const float TrajectoryPlanner::TOLERANCE = 1e-3f;
+const float TrajectoryPlanner::MAX_JOINT_STEP = 0.5f;
+
+namespace
+{
+	const unsigned int BRANCHES = PumaKinematics::MAX_SOLUTIONS;
+
+	float WrapAngle(float a)
+	{
+		return a - XM_2PI * floorf((a + XM_PI) / XM_2PI);
+	}
+
+	//Squared joint space distance or FLT_MAX if any joint moves more than maxStep
+	float Step(const PumaAngles& a, const PumaAngles& b, float maxStep)
+	{
+		auto sum = 0.0f;
+		for (size_t j = 0; j < a.size(); ++j)
+		{
+			auto d = fabsf(WrapAngle(b[j] - a[j]));
+			if (d > maxStep)
+				return FLT_MAX;
+			sum += d * d;
+		}
+		return sum;
+	}
+}
+
+TrajectoryPlanner::TrajectoryPlanner(float samplesPerSecond, float tolerance)
+	: m_samplesPerSecond(samplesPerSecond), m_tolerance(tolerance)
+{ }
+
+bool TrajectoryPlanner::Plan(const CartesianPath& path, float duration, const PumaAngles& start,
+	JointTrajectory& trajectory, float* failedAt) const
+{
+	auto samples = max<size_t>(2, static_cast<size_t>(ceilf(duration * m_samplesPerSecond)) + 1);
+	vector<PumaAngles> angles;
+	if (!SolvePath(path, samples, start, angles, failedAt))
+		return false;
+	trajectory = JointTrajectory();
+	for (size_t i = 0; i < samples; ++i)
+		trajectory.Append(duration * i / (samples - 1), angles[i]);
+	trajectory.Compact(m_tolerance);
+	return true;
+}
+
+bool TrajectoryPlanner::Plan(const CartesianPath& path, const PathParameterization& timing, const PumaAngles& start,
+	JointTrajectory& trajectory, float* failedAt) const
+{
+	auto samples = max<size_t>(2, static_cast<size_t>(ceilf(path.length() * SAMPLES_PER_METER)) + 1);
+	vector<PumaAngles> angles;
+	if (!SolvePath(path, samples, start, angles, failedAt))
+		return false;
+	auto times = timing.Solve(angles);
+	trajectory = JointTrajectory();
+	for (size_t i = 0; i < samples; ++i)
+		trajectory.Append(times[i], angles[i]);
+	trajectory.Compact(m_tolerance);
+	return true;
+}
+
+bool TrajectoryPlanner::SolvePath(const CartesianPath& path, size_t samples, const PumaAngles& start,
+	vector<PumaAngles>& angles, float* failedAt) const
+{
+	vector<float> targets[6];
+	for (auto& t : targets)
+		t.resize(samples);
+	ParallelFor(samples, [&](size_t begin, size_t end)
+	{
+		for (auto i = begin; i < end; ++i)
+		{
+			XMFLOAT3 p, n;
+			path.Evaluate(static_cast<float>(i) / (samples - 1), p, n);
+			targets[0][i] = p.x; targets[1][i] = p.y; targets[2][i] = p.z;
+			targets[3][i] = n.x; targets[4][i] = n.y; targets[5][i] = n.z;
+		}
+	}, 64);
+	if (m_reachability)
+		for (size_t i = 0; i < samples; ++i)
+			if (!m_reachability->MayReach(XMFLOAT3(targets[0][i], targets[1][i], targets[2][i])))
+			{
+				if (failedAt)
+					*failedAt = static_cast<float>(i) / (samples - 1);
+				return false;
+			}
+
+	//solutions[b][j][i] - angle of joint j at sample i in branch b
+	PumaTargetsSoA soa{ targets[0].data(), targets[1].data(), targets[2].data(), targets[3].data(), targets[4].data(), targets[5].data() };
+	vector<float> solutions[BRANCHES][PumaKinematics::JOINTS_COUNT];
+	vector<uint8_t> reachable[BRANCHES];
+	for (auto b = 0U; b < BRANCHES; ++b)
+	{
+		PumaAnglesSoA out;
+		for (auto j = 0U; j < PumaKinematics::JOINTS_COUNT; ++j)
+		{
+			solutions[b][j].resize(samples);
+			out.a[j] = solutions[b][j].data();
+		}
+		reachable[b].resize(samples);
+		PumaKinematics::SolveBatch(samples, soa, b, out, reachable[b].data());
+	}
+	auto solution = [&](unsigned int b, size_t i)
+	{
+		PumaAngles a;
+		for (auto j = 0U; j < PumaKinematics::JOINTS_COUNT; ++j)
+			a[j] = solutions[b][j][i];
+		return a;
+	};
+
+	//Viterbi search for the sequence of branches with the least joint motion
+	vector<uint8_t> previous(samples * BRANCHES);
+	float cost[BRANCHES], nextCost[BRANCHES];
+	for (auto b = 0U; b < BRANCHES; ++b)
+		cost[b] = reachable[b][0] ? Step(start, solution(b, 0), XM_PI) : FLT_MAX;
+	for (size_t i = 0; i < samples; ++i)
+	{
+		if (i > 0)
+		{
+			for (auto b = 0U; b < BRANCHES; ++b)
+			{
+				nextCost[b] = FLT_MAX;
+				if (!reachable[b][i])
+					continue;
+				auto current = solution(b, i);
+				for (auto p = 0U; p < BRANCHES; ++p)
+				{
+					if (cost[p] == FLT_MAX)
+						continue;
+					auto step = Step(solution(p, i - 1), current, MAX_JOINT_STEP);
+					if (step != FLT_MAX && cost[p] + step < nextCost[b])
+					{
+						nextCost[b] = cost[p] + step;
+						previous[i * BRANCHES + b] = static_cast<uint8_t>(p);
+					}
+				}
+			}
+			copy(begin(nextCost), end(nextCost), begin(cost));
+		}
+		if (all_of(begin(cost), end(cost), [](float c) { return c == FLT_MAX; }))
+		{
+			if (failedAt)
+				*failedAt = static_cast<float>(i) / (samples - 1);
+			return false;
+		}
+	}
+
+	//walk back along the cheapest sequence, then unwrap angles so consecutive keys never differ by more than half a turn
+	vector<unsigned int> branches(samples);
+	branches.back() = static_cast<unsigned int>(min_element(begin(cost), end(cost)) - begin(cost));
+	for (auto i = samples - 1; i > 0; --i)
+		branches[i - 1] = previous[i * BRANCHES + branches[i]];
+	angles.resize(samples);
+	auto last = start;
+	for (size_t i = 0; i < samples; ++i)
+	{
+		auto a = solution(branches[i], i);
+		for (size_t j = 0; j < a.size(); ++j)
+			a[j] = last[j] + WrapAngle(a[j] - last[j]);
+		angles[i] = last = a;
+	}
+	return true;
+}
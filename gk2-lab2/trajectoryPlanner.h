@@ -0,0 +1,48 @@
+#pragma once
+#include "cartesianPath.h"
+#include "jointTrajectory.h"
+#include "pathParameterization.h"
+#include "reachabilityMap.h"
+#include <memory>
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Converts Cartesian paths into joint trajectories.
+		//Path samples are solved in parallel in all IK branches, then the sequence of branches is chosen
+		//to minimize joint motion, starting from the current configuration and without jumps between samples.
+		class TrajectoryPlanner
+		{
+		public:
+			explicit TrajectoryPlanner(float samplesPerSecond = SAMPLES_PER_SECOND, float tolerance = TOLERANCE);
+
+			//Trajectory following path at constant parameter speed in duration seconds. start selects the initial
+			//branch; the trajectory begins at the path, so the arm should be brought there first, e.g. with JointMove.
+			//Returns false if the path leaves the workspace or can't be followed without jumping between
+			//branches; failedAt receives path parameter of the first such sample then.
+			bool Plan(const CartesianPath& path, float duration, const PumaAngles& start,
+				JointTrajectory& trajectory, float* failedAt = nullptr) const;
+			//Same, but the path is traversed as fast as joint limits of timing allow
+			bool Plan(const CartesianPath& path, const PathParameterization& timing, const PumaAngles& start,
+				JointTrajectory& trajectory, float* failedAt = nullptr) const;
+
+			//Paths with samples the map rules out fail before running IK; null disables the check
+			void SetReachability(std::shared_ptr<const ReachabilityMap> map) { m_reachability = std::move(map); }
+
+			static const float SAMPLES_PER_SECOND;	//default path sampling density
+			static const float SAMPLES_PER_METER;	//path sampling density of time optimal trajectories
+			static const float TOLERANCE;			//default joint error allowed when compacting trajectories
+			static const float MAX_JOINT_STEP;		//largest change of a joint angle between consecutive samples
+
+		private:
+			float m_samplesPerSecond;
+			float m_tolerance;
+			std::shared_ptr<const ReachabilityMap> m_reachability;
+
+			//Joint angles of samples evenly spaced in path parameter
+			bool SolvePath(const CartesianPath& path, size_t samples, const PumaAngles& start,
+				std::vector<PumaAngles>& angles, float* failedAt) const;
+		};
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace mini
+{
+	//Passes the latest value from one producer thread to one consumer thread without locks.
+	//The producer fills the back slot and publishes it by swapping it with the middle one; the consumer swaps
+	//the middle slot with its front slot when something was published since its last read. Neither side ever
+	//waits, the consumer always sees a complete value and values published in between are skipped.
+	template<typename T>
+	class TripleBuffer
+	{
+	public:
+		explicit TripleBuffer(const T& initial = T())
+			: m_slots{ initial, initial, initial }, m_back(0), m_front(2), m_middle(1)
+		{ }
+
+		TripleBuffer(const TripleBuffer&) = delete;
+		TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+		//Producer: slot to fill before Publish; it holds an older value, not the last published one
+		T& back() { return m_slots[m_back]; }
+		void Publish() { m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX; }
+
+		//Consumer: latest published value, the same as before if nothing was published since
+		const T& Read()
+		{
+			if (m_middle.load(std::memory_order_relaxed) & FRESH)
+				m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX;
+			return m_slots[m_front];
+		}
+
+	private:
+		static const uint8_t INDEX = 3;
+		static const uint8_t FRESH = 4;	//middle slot was published and not read yet
+
+		T m_slots[3];
+		uint8_t m_back, m_front;
+		alignas(64) std::atomic<uint8_t> m_middle;
+	};
+}
@@ -0,0 +1,101 @@
+#include "turbulenceField.h"
+#include "textureGenerator.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+const unsigned int TurbulenceField::RESOLUTION = 32;
+const float TurbulenceField::TILE_SIZE = 4.0f;
+const int TurbulenceField::NOISE_PERIOD = 4;
+
+TurbulenceField::TurbulenceField(unsigned int resolution, float tileSize, int noisePeriod, unsigned int octaves, float persistance)
+	: m_resolution(max(resolution, 2U)), m_tileSize(tileSize)
+{
+	//indices are wrapped with a bit mask
+	while (m_resolution & (m_resolution - 1))
+		m_resolution &= m_resolution - 1;
+	auto n = m_resolution;
+	auto count = static_cast<size_t>(n) * n * n;
+	TextureGenerator noise(octaves, persistance);
+	auto noiseScale = static_cast<float>(noisePeriod) / n;
+
+	//vector potential, one noise channel per component
+	vector<XMFLOAT3> potential(count);
+	ParallelFor(n, [&](size_t begin, size_t end)
+	{
+		for (auto z = static_cast<unsigned int>(begin); z < end; ++z)
+			for (auto y = 0U; y < n; ++y)
+				for (auto x = 0U; x < n; ++x)
+				{
+					float px = x * noiseScale, py = y * noiseScale, pz = z * noiseScale;
+					potential[Index(x, y, z)] = XMFLOAT3(
+						noise.Noise3D(px, py, pz, noisePeriod, 0),
+						noise.Noise3D(px, py, pz, noisePeriod, 17),
+						noise.Noise3D(px, py, pz, noisePeriod, 31));
+				}
+	});
+
+	//curl by central differences; the grid spacing only scales the result, which is normalized below
+	m_velocities.resize(count);
+	auto mask = n - 1;
+	vector<float> maxLength(n, 0.0f);
+	ParallelFor(n, [&](size_t begin, size_t end)
+	{
+		for (auto z = static_cast<unsigned int>(begin); z < end; ++z)
+			for (auto y = 0U; y < n; ++y)
+				for (auto x = 0U; x < n; ++x)
+				{
+					auto& px0 = potential[Index((x - 1) & mask, y, z)];
+					auto& px1 = potential[Index((x + 1) & mask, y, z)];
+					auto& py0 = potential[Index(x, (y - 1) & mask, z)];
+					auto& py1 = potential[Index(x, (y + 1) & mask, z)];
+					auto& pz0 = potential[Index(x, y, (z - 1) & mask)];
+					auto& pz1 = potential[Index(x, y, (z + 1) & mask)];
+					XMFLOAT4A v(
+						(py1.z - py0.z) - (pz1.y - pz0.y),
+						(pz1.x - pz0.x) - (px1.z - px0.z),
+						(px1.y - px0.y) - (py1.x - py0.x), 0.0f);
+					m_velocities[Index(x, y, z)] = v;
+					maxLength[z] = max(maxLength[z], sqrtf(v.x * v.x + v.y * v.y + v.z * v.z));
+				}
+	});
+	auto longest = *max_element(maxLength.begin(), maxLength.end());
+	if (longest > 0.0f)
+	{
+		auto scale = XMVectorReplicate(1.0f / longest);
+		for (auto& v : m_velocities)
+			XMStoreFloat4A(&v, XMVectorMultiply(XMLoadFloat4A(&v), scale));
+	}
+}
+
+shared_ptr<const TurbulenceField> TurbulenceField::Shared()
+{
+	//initialization of function statics is thread safe, so the grid is built exactly once
+	static const shared_ptr<const TurbulenceField> field = make_shared<const TurbulenceField>();
+	return field;
+}
+
+XMVECTOR XM_CALLCONV TurbulenceField::Sample(FXMVECTOR position) const
+{
+	auto cells = XMVectorScale(position, m_resolution / m_tileSize);
+	auto cell = XMVectorFloor(cells);
+	auto t = XMVectorSubtract(cells, cell);
+	XMINT3 i;
+	XMStoreSInt3(&i, cell);
+	auto mask = m_resolution - 1;
+	auto x0 = static_cast<unsigned int>(i.x) & mask, x1 = (x0 + 1) & mask;
+	auto y0 = static_cast<unsigned int>(i.y) & mask, y1 = (y0 + 1) & mask;
+	auto z0 = static_cast<unsigned int>(i.z) & mask, z1 = (z0 + 1) & mask;
+	auto tx = XMVectorSplatX(t), ty = XMVectorSplatY(t), tz = XMVectorSplatZ(t);
+
+	auto v00 = XMVectorLerpV(XMLoadFloat4A(&m_velocities[Index(x0, y0, z0)]), XMLoadFloat4A(&m_velocities[Index(x1, y0, z0)]), tx);
+	auto v10 = XMVectorLerpV(XMLoadFloat4A(&m_velocities[Index(x0, y1, z0)]), XMLoadFloat4A(&m_velocities[Index(x1, y1, z0)]), tx);
+	auto v01 = XMVectorLerpV(XMLoadFloat4A(&m_velocities[Index(x0, y0, z1)]), XMLoadFloat4A(&m_velocities[Index(x1, y0, z1)]), tx);
+	auto v11 = XMVectorLerpV(XMLoadFloat4A(&m_velocities[Index(x0, y1, z1)]), XMLoadFloat4A(&m_velocities[Index(x1, y1, z1)]), tx);
+	return XMVectorLerpV(XMVectorLerpV(v00, v10, ty), XMVectorLerpV(v01, v11, ty), tz);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <DirectXMath.h>
+#include <vector>
+#include <memory>
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Divergence-free velocity field precomputed on a periodic 3D grid.
+		//Velocities are the curl of a vector potential made of three TextureGenerator::Noise3D channels,
+		//so smoke swirls without gathering in sinks. The grid tiles the whole space.
+		class TurbulenceField
+		{
+		public:
+			//resolution - number of cells along each axis (power of two)
+			//tileSize - world space length after which the field repeats
+			//noisePeriod - number of noise lattice cells per tile
+			explicit TurbulenceField(unsigned int resolution = RESOLUTION, float tileSize = TILE_SIZE,
+				int noisePeriod = NOISE_PERIOD, unsigned int octaves = 2, float persistance = 0.5f);
+
+			//Field built with default parameters on first use and shared by all particle systems
+			static std::shared_ptr<const TurbulenceField> Shared();
+
+			//Trilinearly interpolated velocity at world space position. Magnitudes are at most 1.
+			DirectX::XMVECTOR XM_CALLCONV Sample(DirectX::FXMVECTOR position) const;
+
+			unsigned int resolution() const { return m_resolution; }
+			float tileSize() const { return m_tileSize; }
+
+			static const unsigned int RESOLUTION;
+			static const float TILE_SIZE;
+			static const int NOISE_PERIOD;
+
+		private:
+			unsigned int m_resolution;
+			float m_tileSize;
+			std::vector<DirectX::XMFLOAT4A> m_velocities;	//x fastest, then y, then z; w unused
+
+			size_t Index(unsigned int x, unsigned int y, unsigned int z) const
+			{
+				return (static_cast<size_t>(z) * m_resolution + y) * m_resolution + x;
+			}
+		};
+	}
+}
@@ -11,6 +11,13 @@
 
 namespace mini
 {
+	struct VertexPosition
+	{
+		DirectX::XMFLOAT3 position;
+
+		static const D3D11_INPUT_ELEMENT_DESC Layout[1];
+	};
+
 	struct VertexPositionColor
 	{
 		DirectX::XMFLOAT3 position;
@@ -25,5 +32,7 @@ namespace mini
 		DirectX::XMFLOAT3 normal;
 
 		static const D3D11_INPUT_ELEMENT_DESC Layout[2];
+		//Layout followed by rows of an instance world matrix (XMFLOAT4X4) in slot 1, see Mesh::RenderInstanced
+		static const D3D11_INPUT_ELEMENT_DESC InstancedLayout[6];
 	};
 }
\ No newline at end of file
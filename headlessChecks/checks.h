@@ -0,0 +1,36 @@
+#pragma once
+#include <cmath>
+#include <iostream>
+
+namespace mini
+{
+	namespace gk2
+	{
+		//Checks of headlessChecks, each returns false if any of its expectations failed
+		bool CheckParticleBillboards();
+		bool CheckSceneDistanceField();
+		bool CheckToolTrail();
+		bool CheckPumaKinematics();
+		bool CheckTrajectoryPlanner();
+		bool CheckPathParameterization();
+		bool CheckReachabilityMap();
+		bool CheckDampedIK();
+		bool CheckMotionProgram();
+		bool CheckPumaInstances();
+		bool CheckPumaDynamics();
+
+		//Reports a failed expectation to stderr
+		inline bool Expect(bool condition, const char* check, const char* what)
+		{
+			if (!condition)
+				std::cerr << check << ": " << what << "\n";
+			return condition;
+		}
+
+		//a and b equal up to tolerance relative to their magnitude
+		inline bool Near(float a, float b, float tolerance)
+		{
+			return std::fabs(a - b) <= tolerance * (1.0f + std::fmax(std::fabs(a), std::fabs(b)));
+		}
+	}
+}
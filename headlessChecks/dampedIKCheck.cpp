@@ -0,0 +1,85 @@
+#include <cmath>
+#include <random>
+#include <vector>
+#include "checks.h"
+#include "dampedIK.h"
+#include "pumaKinematics.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	const char* CHECK = "damped_ik";
+	const size_t TARGETS_COUNT = 500;
+	const float PERTURBATION = 0.2f;	//largest change of a joint angle of the seed, radians
+	const float TOLERANCE = 1e-3f;		//meters for the tool tip, length of the difference for the normal
+	//damping slows the last iterations down near singular poses, so a few solves run out of iterations
+	//close to the target instead of converging
+	const float MIN_CONVERGENCE = 0.95f;
+
+	bool Close(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&a), XMLoadFloat3(&b)))) <= TOLERANCE;
+	}
+}
+
+bool mini::gk2::CheckDampedIK()
+{
+	using PumaIK = DampedIK<PumaKinematics::JOINTS_COUNT>;
+	XMFLOAT3 toolPoint, toolNormal;
+	PumaKinematics::EndEffector(PumaAngles{}, toolPoint, toolNormal);
+	PumaIK ik(PumaKinematics::Chain(), toolPoint, toolNormal);
+
+	//analytic solutions of targets of random poses, in random branches, seeded from perturbed solutions
+	mt19937 random(1);
+	uniform_real_distribution<float> angle(-XM_PI, XM_PI), perturbation(-PERTURBATION, PERTURBATION);
+	uniform_int_distribution<unsigned int> branch(0, PumaKinematics::MAX_SOLUTIONS - 1);
+	vector<XMFLOAT3> positions, normals;
+	vector<PumaAngles> seeds;
+	while (positions.size() < TARGETS_COUNT)
+	{
+		PumaAngles pose, solution;
+		for (auto& a : pose)
+			a = angle(random);
+		XMFLOAT3 p, n;
+		PumaKinematics::EndEffector(pose, p, n);
+		if (!PumaKinematics::Solve(p, n, branch(random), solution))
+			continue;
+		for (auto& a : solution)
+			a += perturbation(random);
+		positions.push_back(p);
+		normals.push_back(n);
+		seeds.push_back(solution);
+	}
+
+	auto passed = true;
+	DampedIKStats stats;
+	vector<PumaAngles> angles(TARGETS_COUNT);
+	for (size_t i = 0; i < TARGETS_COUNT && passed; ++i)
+	{
+		if (!ik.Solve(positions[i], normals[i], seeds[i], angles[i], &stats))
+			continue;
+		XMFLOAT3 p, n;
+		PumaKinematics::EndEffector(angles[i], p, n);
+		passed &= Expect(Close(p, positions[i]) && Close(n, normals[i]), CHECK, "converged solution misses the target");
+	}
+	passed &= Expect(stats.solves == TARGETS_COUNT, CHECK, "solves not counted");
+	passed &= Expect(stats.convergenceRate() >= MIN_CONVERGENCE, CHECK, "too few solves converged");
+	passed &= Expect(stats.maxError <= TOLERANCE, CHECK, "solve that didn't converge ended far from the target");
+	passed &= Expect(stats.averageIterations() < ik.settings().MaxIterations / 4, CHECK, "solves from nearby seeds are slow");
+
+	//SolveBatch gives the same results in parallel
+	vector<PumaAngles> batch(TARGETS_COUNT);
+	vector<uint8_t> converged(TARGETS_COUNT);
+	DampedIKStats batchStats;
+	auto count = ik.SolveBatch(TARGETS_COUNT, positions.data(), normals.data(), seeds.data(), batch.data(),
+		converged.data(), &batchStats);
+	passed &= Expect(count == stats.converged && batchStats.converged == stats.converged
+		&& batchStats.iterations == stats.iterations, CHECK, "SolveBatch counts differ from Solve");
+	for (size_t i = 0; i < TARGETS_COUNT && passed; ++i)
+		passed &= Expect(batch[i] == angles[i], CHECK, "SolveBatch solution differs from Solve");
+	return passed;
+}
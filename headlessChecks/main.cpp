@@ -0,0 +1,62 @@
+//Headless checks of code shared with RoomDemo - no window and no Direct3D device required.
+//Compares CPU code with straightforward reference versions of it or known results and prints the result of every check.
+//Returns a non-zero exit code if any of them fails.
+//
+//Windows: build the headlessChecks project from gk2-lab2.sln.
+//Linux (DirectXMath headers and the sal.h stub from DirectX-Headers/include/wsl/stubs on the include path):
+//	g++ -std=c++17 -O2 -I../gk2-lab2 main.cpp dampedIKCheck.cpp motionProgramCheck.cpp particleBillboardsCheck.cpp
+//		pathParameterizationCheck.cpp pumaDynamicsCheck.cpp pumaInstancesCheck.cpp pumaKinematicsCheck.cpp
+//		reachabilityMapCheck.cpp sceneDistanceFieldCheck.cpp toolTrailCheck.cpp trajectoryPlannerCheck.cpp
+//		../gk2-lab2/cartesianPath.cpp ../gk2-lab2/dampedIK.cpp ../gk2-lab2/jointTrajectory.cpp
+//		../gk2-lab2/kinematicChain.cpp ../gk2-lab2/meshData.cpp ../gk2-lab2/motionProgram.cpp
+//		../gk2-lab2/particleBillboards.cpp ../gk2-lab2/pathParameterization.cpp ../gk2-lab2/pumaDynamics.cpp
+//		../gk2-lab2/pumaIKCache.cpp ../gk2-lab2/pumaInstances.cpp ../gk2-lab2/pumaKinematics.cpp
+//		../gk2-lab2/reachabilityMap.cpp ../gk2-lab2/rigidBody.cpp ../gk2-lab2/sceneDistanceField.cpp
+//		../gk2-lab2/toolTrail.cpp ../gk2-lab2/trajectoryPlanner.cpp -pthread -o headlessChecks
+//
+//Usage: headlessChecks
+
+#include <cstdlib>
+#include <iostream>
+#include "checks.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace std;
+
+namespace
+{
+	struct Check
+	{
+		const char* name;
+		bool(*run)();
+	};
+
+	const Check CHECKS[] =
+	{
+		{ "particle_billboards", CheckParticleBillboards },
+		{ "scene_distance_field", CheckSceneDistanceField },
+		{ "tool_trail", CheckToolTrail },
+		{ "puma_kinematics", CheckPumaKinematics },
+		{ "trajectory_planner", CheckTrajectoryPlanner },
+		{ "path_parameterization", CheckPathParameterization },
+		{ "reachability_map", CheckReachabilityMap },
+		{ "damped_ik", CheckDampedIK },
+		{ "motion_program", CheckMotionProgram },
+		{ "puma_instances", CheckPumaInstances },
+		{ "puma_dynamics", CheckPumaDynamics }
+	};
+}
+
+int main()
+{
+	auto failed = 0U;
+	for (auto& check : CHECKS)
+	{
+		auto passed = check.run();
+		cout << check.name << (passed ? ": ok\n" : ": FAILED\n");
+		if (!passed)
+			++failed;
+	}
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "checks.h"
+#include "motionProgram.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	const char* CHECK = "motion_program";
+	const PumaAngles HOME{ 0.0f, -0.5f, 0.0f, 0.0f, 0.0f };
+
+	struct ExpectedError
+	{
+		unsigned int Line;
+		const char* Message;	//part of the message
+	};
+
+	//Compile of source fails with exactly the expected errors and leaves the program alone
+	bool Fails(const MotionCompiler& compiler, const string& source, const vector<ExpectedError>& expected, const char* what)
+	{
+		MotionProgram program;
+		vector<MotionProgramError> errors;
+		if (!Expect(!compiler.Compile(source, HOME, program, errors), CHECK, what))
+			return false;
+		auto passed = Expect(errors.size() == expected.size(), CHECK, what);
+		for (size_t i = 0; i < errors.size() && i < expected.size(); ++i)
+			passed &= Expect(errors[i].Line == expected[i].Line && errors[i].Message.find(expected[i].Message) != string::npos,
+				CHECK, what);
+		passed &= Expect(program.trajectory().empty(), CHECK, "failed compile filled the program");
+		if (!passed)
+			for (auto& e : errors)
+				cerr << "  line " << e.Line << ": " << e.Message << "\n";
+		return passed;
+	}
+
+	//Tool pose of angles as MOVEJ arguments
+	string Pose(const PumaAngles& angles)
+	{
+		XMFLOAT3 p, n;
+		PumaKinematics::EndEffector(angles, p, n);
+		ostringstream pose;
+		pose << p.x << " " << p.y << " " << p.z << " " << n.x << " " << n.y << " " << n.z;
+		return pose.str();
+	}
+}
+
+bool mini::gk2::CheckMotionProgram()
+{
+	MotionCompiler compiler;
+
+	//a valid program; segments start at the lines of their commands, comments and blank lines take no time
+	const PumaAngles pose{ 0.3f, -0.6f, 0.4f, 0.2f, 0.5f };
+	XMFLOAT3 tip, normal;
+	PumaKinematics::EndEffector(pose, tip, normal);
+	ostringstream source;
+	source << "# approach\n"
+		<< "movej " << Pose(pose) << "\n"
+		<< "\n"
+		<< "WAIT 0.5  # settle\n"
+		<< "SPEED 0.1\n"
+		<< "MOVEL " << tip.x << " " << tip.y + 0.05f << " " << tip.z << "\n"
+		<< "MOVEJ 0 -28.6 0 0 0\n";
+	MotionProgram program;
+	vector<MotionProgramError> errors;
+	auto passed = Expect(compiler.Compile(source.str(), HOME, program, errors) && errors.empty(), CHECK, "valid program not compiled");
+	if (!passed)
+		return false;
+	auto& segments = program.segments();
+	passed &= Expect(segments.size() == 4 && segments[0].Line == 2 && segments[1].Line == 4 && segments[2].Line == 6
+		&& segments[3].Line == 7, CHECK, "segments don't match the lines of the commands");
+	passed &= Expect(segments.size() == 4 && fabsf(segments[2].Start - segments[1].Start - 0.5f) < 1e-4f, CHECK, "WAIT doesn't wait");
+	passed &= Expect(program.LineAt(0.0f) == 2 && program.LineAt(program.duration()) == 7, CHECK, "LineAt doesn't match the commands");
+	auto end = program.trajectory().angles().back();
+	passed &= Expect(fabsf(end[1] - XMConvertToRadians(-28.6f)) < 1e-4f, CHECK, "program doesn't end at the last target");
+
+	//syntax errors of all lines are reported, before any planning
+	passed &= Fails(compiler,
+		"MOVEJ 0 0 0 0 0\n"
+		"# comment\n"
+		"JUMP 1 2 3\n"
+		"MOVEJ 1 2 3\n"
+		"WAIT -1\n"
+		"movel 1 2 x\n"
+		"CIRC 1 2 3 4 5 6 7\n"
+		"MOVEL 10 10 10\n",
+		{ { 3, "unknown command 'JUMP'" }, { 4, "MOVEJ can't take 3 arguments" }, { 5, "WAIT must not be negative" },
+			{ 6, "'x' is not a number" }, { 7, "CIRC can't take 7 arguments" } },
+		"syntax errors not reported");
+
+	//targets out of reach stop planning, since the configuration after them is unknown
+	passed &= Fails(compiler,
+		"MOVEJ 0 -30 0 0 0\n"
+		"MOVEL 10 10 10\n"
+		"MOVEJ 10 10 10 0 1 0\n",
+		{ { 2, "target out of reach" } },
+		"MOVEL out of reach not reported");
+	passed &= Fails(compiler,
+		"\n"
+		"MOVEJ 10 0 0 0 1 0\n",
+		{ { 2, "target out of reach" } },
+		"MOVEJ out of reach not reported");
+
+	//other errors of tool moves are reported and planning goes on
+	passed &= Fails(compiler,
+		"MOVEJ " + Pose(pose) + "\n"
+		"MOVEL 0 0 0 0 0 0\n"
+		"CIRC 0 0 0 0 0 0\n"
+		"MOVEJ 10 0 0 0 1 0\n",
+		{ { 2, "normal must not be zero" }, { 3, "arc points are collinear" }, { 4, "target out of reach" } },
+		"tool move errors not reported");
+	return passed;
+}
@@ -0,0 +1,95 @@
+#include <random>
+#include <vector>
+#include "checks.h"
+#include "particleBillboards.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	const char* CHECK = "particle_billboards";
+	const float TOLERANCE = 1e-4f;
+	const float TIME_TO_LIVE = 4.0f;
+	//counts that are and aren't multiples of the four particles Expand processes at once
+	const size_t COUNTS[] = { 0, 1, 2, 3, 4, 5, 7, 8, 13, 64, 1001 };
+
+	//particleGS.hlsl line by line: view space center, rotated corner offsets and the strip order of corners
+	void Reference(const ParticleVertex& p, const XMFLOAT4X4& v, ParticleQuadVertex corners[4])
+	{
+		auto x = p.Pos.x * v._11 + p.Pos.y * v._21 + p.Pos.z * v._31 + v._41;
+		auto y = p.Pos.x * v._12 + p.Pos.y * v._22 + p.Pos.z * v._32 + v._42;
+		auto z = p.Pos.x * v._13 + p.Pos.y * v._23 + p.Pos.z * v._33 + v._43;
+		auto sina = sinf(p.Angle), cosa = cosf(p.Angle);
+		auto dx = (cosa - sina) * 0.5f * p.Size;
+		auto dy = (cosa + sina) * 0.5f * p.Size;
+		const float offsets[4][2] = { { -dx, -dy }, { -dy, dx }, { dy, -dx }, { dx, dy } };
+		const float tex[4][2] = { { 0.0f, 1.0f }, { 1.0f, 1.0f }, { 0.0f, 0.0f }, { 1.0f, 0.0f } };
+		for (auto c = 0U; c < 4U; ++c)
+		{
+			corners[c].Pos = XMFLOAT3(x + offsets[c][0], y + offsets[c][1], z);
+			corners[c].Tex1 = XMFLOAT2(tex[c][0], tex[c][1]);
+			corners[c].Tex2 = XMFLOAT2(p.Age / TIME_TO_LIVE, 0.5f);
+		}
+	}
+
+	bool Compare(const char* name, const vector<ParticleVertex>& particles, const XMFLOAT4X4& view,
+		const vector<ParticleQuadVertex>& quads)
+	{
+		if (!Expect(quads.size() == particles.size() * ParticleBillboards::VERTS_PER_QUAD, CHECK, name))
+			return false;
+		for (size_t i = 0; i < particles.size(); ++i)
+		{
+			ParticleQuadVertex expected[4];
+			Reference(particles[i], view, expected);
+			for (auto c = 0U; c < 4U; ++c)
+			{
+				auto& e = expected[c];
+				auto& q = quads[i * ParticleBillboards::VERTS_PER_QUAD + c];
+				auto same = Near(q.Pos.x, e.Pos.x, TOLERANCE) && Near(q.Pos.y, e.Pos.y, TOLERANCE) &&
+					Near(q.Pos.z, e.Pos.z, TOLERANCE) && q.Tex1.x == e.Tex1.x && q.Tex1.y == e.Tex1.y &&
+					Near(q.Tex2.x, e.Tex2.x, TOLERANCE) && q.Tex2.y == e.Tex2.y;
+				if (!Expect(same, CHECK, name))
+				{
+					cerr << "\tparticle " << i << " of " << particles.size() << ", corner " << c << "\n";
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+}
+
+bool mini::gk2::CheckParticleBillboards()
+{
+	mt19937 random(1);
+	uniform_real_distribution<float> position(-4.0f, 4.0f), angle(-10.0f, 10.0f), size(0.01f, 1.0f),
+		age(0.0f, TIME_TO_LIVE);
+	auto passed = true;
+	vector<ParticleQuadVertex> quads;
+	for (auto count : COUNTS)
+	{
+		vector<ParticleVertex> particles(count);
+		for (auto& p : particles)
+		{
+			p.Pos = XMFLOAT3(position(random), position(random), position(random));
+			p.Angle = angle(random);
+			p.Size = size(random);
+			p.Age = age(random);
+		}
+		//a camera somewhere in the room looking at a random point
+		auto eye = XMVectorSet(position(random), position(random), position(random), 1.0f);
+		auto target = XMVectorSet(position(random), position(random), position(random), 1.0f);
+		auto viewMtx = XMMatrixLookAtLH(eye, target, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		XMFLOAT4X4 view;
+		XMStoreFloat4x4(&view, viewMtx);
+
+		ParticleBillboards::Expand(particles, viewMtx, TIME_TO_LIVE, quads);
+		passed &= Compare("Expand differs from the geometry shader", particles, view, quads);
+		ParticleBillboards::ExpandScalar(particles, viewMtx, TIME_TO_LIVE, quads);
+		passed &= Compare("ExpandScalar differs from the geometry shader", particles, view, quads);
+	}
+	return passed;
+}
@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "checks.h"
+#include "pathParameterization.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace std;
+
+namespace
+{
+	const char* CHECK = "path_parameterization";
+	const size_t SAMPLES = 401;
+	const float VELOCITY_TOLERANCE = 0.02f;	//relative to the limit
+	//Solve bounds the acceleration at samples, while finite differences across a sample mix it with the path
+	//curvature between samples, which adds up to about a tenth of the limit
+	const float ACCELERATION_TOLERANCE = 0.2f;
+	const float SATURATION = 0.8f;	//fraction of a limit considered reached
+
+	//Random smooth path in joint space, with a few samples repeated in the middle
+	vector<PumaAngles> Path(mt19937& random)
+	{
+		uniform_real_distribution<float> amplitude(0.3f, 2.0f), frequency(1.0f, 8.0f), phase(0.0f, 6.28f);
+		PumaAngles a, w, p;
+		for (size_t j = 0; j < a.size(); ++j)
+		{
+			a[j] = amplitude(random);
+			w[j] = frequency(random);
+			p[j] = phase(random);
+		}
+		vector<PumaAngles> path(SAMPLES);
+		for (size_t i = 0; i < SAMPLES; ++i)
+		{
+			auto s = min(i, SAMPLES / 2) + (i > SAMPLES / 2 + 10 ? i - SAMPLES / 2 - 10 : 0);
+			for (size_t j = 0; j < a.size(); ++j)
+				path[i][j] = a[j] * sinf(w[j] * s / SAMPLES + p[j]);
+		}
+		return path;
+	}
+
+	//Times are monotonic and finite differences of the timed path stay within limits
+	bool CheckTiming(const vector<PumaAngles>& path, const vector<float>& times, const JointLimits& limits)
+	{
+		auto passed = Expect(times.size() == path.size() && times.front() == 0.0f, CHECK, "times don't match the path");
+		for (size_t i = 1; i < times.size() && passed; ++i)
+			passed &= Expect(isfinite(times[i]) && times[i] >= times[i - 1], CHECK, "times aren't monotonic");
+		if (!passed)
+			return false;
+
+		//velocity of every segment, acceleration between the centers of consecutive segments
+		auto n = path.size();
+		vector<PumaAngles> velocity(n - 1);
+		for (size_t i = 0; i + 1 < n; ++i)
+		{
+			auto dt = times[i + 1] - times[i];
+			for (size_t j = 0; j < path[i].size(); ++j)
+			{
+				auto dq = path[i + 1][j] - path[i][j];
+				velocity[i][j] = dt > 0.0f ? dq / dt : 0.0f;
+				passed &= Expect(dt > 0.0f || dq == 0.0f, CHECK, "joint moves in no time");
+				passed &= Expect(fabsf(velocity[i][j]) <= limits.MaxVelocity[j] * (1.0f + VELOCITY_TOLERANCE), CHECK,
+					"velocity limit exceeded");
+			}
+		}
+		//repeated samples take no time, so the path moves on through them without stopping
+		for (size_t i = 1, previous = 0; i + 1 < n; ++i)
+		{
+			if (times[i + 1] == times[i])
+				continue;
+			auto dt = 0.5f * (times[i + 1] - times[i] + times[previous + 1] - times[previous]);
+			for (size_t j = 0; j < path[i].size(); ++j)
+				passed &= Expect(fabsf(velocity[i][j] - velocity[previous][j]) / dt <= limits.MaxAcceleration[j] * (1.0f + ACCELERATION_TOLERANCE),
+					CHECK, "acceleration limit exceeded");
+			previous = i;
+		}
+		//at rest at both ends: the first and last segments are covered within acceleration limits from zero speed
+		for (auto i : { size_t(0), n - 2 })
+		{
+			auto dt = times[i + 1] - times[i];
+			for (size_t j = 0; j < path[i].size(); ++j)
+				passed &= Expect(fabsf(velocity[i][j]) <= 0.5f * limits.MaxAcceleration[j] * dt * (1.0f + ACCELERATION_TOLERANCE),
+					CHECK, "path doesn't start or end at rest");
+		}
+		return passed;
+	}
+
+	//Some joint moves close to one of its limits in most of the segments, i.e. the timing isn't needlessly slow
+	bool Saturated(const vector<PumaAngles>& path, const vector<float>& times, const JointLimits& limits)
+	{
+		auto saturated = 0U, moving = 0U;
+		for (size_t i = 1; i + 1 < path.size(); ++i)
+		{
+			auto dt = times[i + 1] - times[i], dtPrev = times[i] - times[i - 1];
+			if (dt <= 0.0f || dtPrev <= 0.0f)
+				continue;
+			++moving;
+			auto ratio = 0.0f;
+			for (size_t j = 0; j < path[i].size(); ++j)
+			{
+				auto v = (path[i + 1][j] - path[i][j]) / dt, vPrev = (path[i][j] - path[i - 1][j]) / dtPrev;
+				ratio = max(ratio, fabsf(v) / limits.MaxVelocity[j]);
+				ratio = max(ratio, fabsf(v - vPrev) / (0.5f * (dt + dtPrev)) / limits.MaxAcceleration[j]);
+			}
+			if (ratio >= SATURATION)
+				++saturated;
+		}
+		return saturated >= 0.9f * moving;
+	}
+}
+
+bool mini::gk2::CheckPathParameterization()
+{
+	mt19937 random(1);
+	auto passed = true;
+	for (auto limits : { JointLimits::Puma(), JointLimits{ { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f }, { 20.0f, 20.0f, 20.0f, 20.0f, 20.0f } },
+		JointLimits{ { 20.0f, 20.0f, 20.0f, 20.0f, 20.0f }, { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f } } })
+	{
+		PathParameterization timing(limits);
+		for (auto i = 0; i < 5 && passed; ++i)
+		{
+			auto path = Path(random);
+			auto times = timing.Solve(path);
+			passed &= CheckTiming(path, times, limits);
+			passed &= Expect(!passed || Saturated(path, times, limits), CHECK, "timing is slower than the limits allow");
+		}
+	}
+
+	//degenerate paths
+	PathParameterization timing(JointLimits::Puma());
+	passed &= Expect(timing.Solve({}).empty(), CHECK, "empty path has times");
+	auto single = timing.Solve({ PumaAngles{} });
+	passed &= Expect(single.size() == 1 && single[0] == 0.0f, CHECK, "single sample isn't at time 0");
+	auto still = timing.Solve({ PumaAngles{}, PumaAngles{}, PumaAngles{} });
+	passed &= Expect(still.size() == 3 && still.back() == 0.0f, CHECK, "path without motion takes time");
+	return passed;
+}
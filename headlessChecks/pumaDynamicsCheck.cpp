@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cmath>
+#include "checks.h"
+#include "pathParameterization.h"
+#include "pumaDynamics.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	const char* CHECK = "puma_dynamics";
+	const float STEP = 0.01f;
+	const PumaAngles POSE{ 0.4f, -0.7f, 0.9f, 0.3f, -0.5f };
+
+	//Masses at the middle of every link in the rest pose, see PumaKinematics
+	PumaDynamics Arm()
+	{
+		const auto l1 = PumaKinematics::L1, l2 = PumaKinematics::L2, l3 = PumaKinematics::L3;
+		const auto dy = PumaKinematics::DY, dz = PumaKinematics::DZ;
+		return PumaDynamics({ RigidBodyInertia::PointMass(20.0f, { 0.0f, dy, 0.0f }),
+			RigidBodyInertia::PointMass(15.0f, { -0.5f * l1, dy, 0.0f }),
+			RigidBodyInertia::PointMass(10.0f, { -l1 - 0.5f * l2, dy, -dz }),
+			RigidBodyInertia::PointMass(3.0f, { -l1 - l2, dy, -dz }),
+			RigidBodyInertia::PointMass(2.0f, { -l1 - l2 - 0.5f * l3, dy, -dz }) });
+	}
+
+	float Largest(const PumaAngles& a)
+	{
+		auto largest = 0.0f;
+		for (auto v : a)
+			largest = max(largest, fabsf(v));
+		return largest;
+	}
+}
+
+bool mini::gk2::CheckPumaDynamics()
+{
+	auto arm = Arm();
+	auto passed = true;
+
+	//a held pose needs the static torques only
+	JointTrajectory hold;
+	hold.Append(0.0f, POSE);
+	hold.Append(2.0f, POSE);
+	PumaAngles zero{}, staticTorques;
+	arm.InverseDynamics(POSE, zero, zero, staticTorques);
+	TrajectoryTorques torques;
+	arm.Torques(hold, STEP, torques);
+	passed &= Expect(torques.Torques.size() == static_cast<size_t>(2.0f / STEP) + 1, CHECK, "held pose sampled wrong");
+	for (auto& tau : torques.Torques)
+		for (size_t j = 0; j < tau.size(); ++j)
+			passed &= Expect(Near(tau[j], staticTorques[j], 1e-4f), CHECK, "held pose needs more than static torques");
+	for (size_t j = 0; j < torques.Peak.size(); ++j)
+		passed &= Expect(Near(torques.Peak[j], fabsf(staticTorques[j]), 1e-4f), CHECK, "peak of a held pose isn't static");
+
+	//keys of a smooth motion from rest to rest: torques match the exact velocities and accelerations up to
+	//the change of acceleration within a segment; without gravity only the motion needs torques
+	const float duration = 2.0f, keyStep = 0.05f, omega = XM_2PI / duration;
+	const PumaAngles amplitude{ 1.0f, 0.8f, -1.2f, 2.0f, 1.5f };
+	auto motion = [&](float t, PumaAngles& q, PumaAngles& qd, PumaAngles& qdd)
+	{
+		for (size_t j = 0; j < q.size(); ++j)
+		{
+			q[j] = POSE[j] + 0.5f * amplitude[j] * (1.0f - cosf(omega * t));
+			qd[j] = 0.5f * amplitude[j] * omega * sinf(omega * t);
+			qdd[j] = 0.5f * amplitude[j] * omega * omega * cosf(omega * t);
+		}
+	};
+	arm.SetGravity({ 0.0f, 0.0f, 0.0f });
+	JointTrajectory smooth;
+	PumaAngles q, qd, qdd, expected;
+	for (auto k = 0; k * keyStep <= duration + 1e-4f; ++k)
+	{
+		motion(k * keyStep, q, qd, qdd);
+		smooth.Append(k * keyStep, q);
+	}
+	arm.Torques(smooth, STEP, torques);
+	vector<PumaAngles> reference(torques.Torques.size());
+	PumaAngles peak{};
+	for (size_t i = 0; i < reference.size(); ++i)
+	{
+		motion(min(i * STEP, duration), q, qd, qdd);
+		arm.InverseDynamics(q, qd, qdd, reference[i]);
+		for (size_t j = 0; j < peak.size(); ++j)
+			peak[j] = max(peak[j], fabsf(reference[i][j]));
+	}
+	//a constant acceleration over a segment differs from the cosine by about omega * keyStep / 2 of its peak
+	auto tolerance = 0.5f * omega * keyStep + 0.02f;
+	for (size_t i = 0; i < reference.size() && passed; ++i)
+		for (size_t j = 0; j < peak.size(); ++j)
+			passed &= Expect(fabsf(torques.Torques[i][j] - reference[i][j]) <= tolerance * Largest(peak), CHECK,
+				"torques of a smooth motion differ from the exact ones");
+
+	//peaks of a timed joint move don't grow as samples get closer
+	arm.SetGravity({ 0.0f, -9.81f, 0.0f });
+	auto move = PathParameterization(JointLimits::Puma()).Retime(JointTrajectory::JointMove(PumaAngles{}, POSE, 1.0f));
+	TrajectoryTorques fine;
+	arm.Torques(move, 0.1f * STEP, fine);
+	arm.Torques(move, STEP, torques);
+	for (size_t j = 0; j < torques.Peak.size(); ++j)
+		passed &= Expect(fabsf(fine.Peak[j] - torques.Peak[j]) <= 0.05f * Largest(torques.Peak), CHECK,
+			"peak torques depend on the sample spacing");
+	return passed;
+}
@@ -0,0 +1,74 @@
+#include <random>
+#include <vector>
+#include "checks.h"
+#include "pumaInstances.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	const char* CHECK = "puma_instances";
+	const float TOLERANCE = 1e-4f;
+	//none of them is a multiple of 4, so every Pack ends with a partial block
+	const size_t COUNTS[] = { 1, 2, 3, 5, 7, 9, 103 };
+
+	bool Equal(const XMFLOAT4X4& a, const XMFLOAT4X4& b)
+	{
+		for (auto i = 0; i < 4; ++i)
+			for (auto k = 0; k < 4; ++k)
+				if (!Near(a.m[i][k], b.m[i][k], TOLERANCE))
+					return false;
+		return true;
+	}
+
+	//Instances of Pack are the link matrices of the chain moved by the placement, the base is the placement
+	bool Packed(size_t count, const vector<PumaAngles>& angles, const XMFLOAT4X4* placements, const vector<XMFLOAT4X4>& instances)
+	{
+		if (!Expect(instances.size() == PumaInstancePacker::LINKS_COUNT * count, CHECK, "wrong number of instances"))
+			return false;
+		for (size_t r = 0; r < count; ++r)
+		{
+			auto placement = placements ? XMLoadFloat4x4(&placements[r]) : XMMatrixIdentity();
+			XMFLOAT4X4 links[PumaKinematics::JOINTS_COUNT], expected;
+			PumaKinematics::LinkMatrices(angles[r], links);
+			for (auto link = 0U; link < PumaInstancePacker::LINKS_COUNT; ++link)
+			{
+				XMStoreFloat4x4(&expected, link ? XMLoadFloat4x4(&links[link - 1]) * placement : placement);
+				if (!Expect(Equal(instances[PumaInstancePacker::FirstInstance(link, count) + r], expected), CHECK,
+					"instance differs from the link matrix"))
+					return false;
+			}
+		}
+		return true;
+	}
+}
+
+bool mini::gk2::CheckPumaInstances()
+{
+	mt19937 random(1);
+	uniform_real_distribution<float> angle(-XM_PI, XM_PI), offset(-5.0f, 5.0f);
+	PumaInstancePacker packer;
+	auto passed = true;
+	vector<XMFLOAT4X4> instances;
+	for (auto count : COUNTS)
+	{
+		vector<PumaAngles> angles(count);
+		vector<XMFLOAT4X4> placements(count);
+		for (size_t r = 0; r < count; ++r)
+		{
+			for (auto& a : angles[r])
+				a = angle(random);
+			auto axis = XMVector3Normalize(XMVectorSet(offset(random), offset(random), offset(random), 0.0f));
+			XMStoreFloat4x4(&placements[r], XMMatrixRotationNormal(axis, angle(random))
+				* XMMatrixTranslation(offset(random), offset(random), offset(random)));
+		}
+		packer.Pack(count, angles.data(), placements.data(), instances);
+		passed &= Packed(count, angles, placements.data(), instances);
+		packer.Pack(count, angles.data(), nullptr, instances);
+		passed &= Packed(count, angles, nullptr, instances);
+	}
+	return passed;
+}
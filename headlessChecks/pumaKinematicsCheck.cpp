@@ -0,0 +1,117 @@
+#include <random>
+#include <vector>
+#include "checks.h"
+#include "pumaKinematics.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	const char* CHECK = "puma_kinematics";
+	const size_t TARGETS_COUNT = 1001;	//not a multiple of 4, so SolveBatch ends with a partial block
+	const float TOLERANCE = 1e-3f;	//meters for the tool tip, length of the difference for the normal
+
+	struct Target
+	{
+		XMFLOAT3 position, normal;
+	};
+
+	bool Near(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&a), XMLoadFloat3(&b)))) <= TOLERANCE;
+	}
+
+	//Forward kinematics of angles reach the target
+	bool Reaches(const PumaAngles& angles, const Target& target)
+	{
+		XMFLOAT3 position, normal;
+		PumaKinematics::EndEffector(angles, position, normal);
+		return Near(position, target.position) && Near(normal, target.normal);
+	}
+}
+
+bool mini::gk2::CheckPumaKinematics()
+{
+	//targets of random poses are in reach of at least the branch of the pose
+	mt19937 random(1);
+	uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+	vector<Target> targets(TARGETS_COUNT);
+	for (auto& t : targets)
+	{
+		PumaAngles pose;
+		for (auto& a : pose)
+			a = angle(random);
+		PumaKinematics::EndEffector(pose, t.position, t.normal);
+	}
+
+	auto passed = true;
+	unsigned int solvedBranches[PumaKinematics::MAX_SOLUTIONS] = {};
+	for (auto& t : targets)
+	{
+		PumaAngles solutions[PumaKinematics::MAX_SOLUTIONS];
+		unsigned int branches[PumaKinematics::MAX_SOLUTIONS];
+		auto count = PumaKinematics::SolveAll(t.position, t.normal, solutions, branches);
+		passed &= Expect(count > 0, CHECK, "target of a pose has no solution");
+		for (auto i = 0U; i < count; ++i)
+		{
+			passed &= Expect(Reaches(solutions[i], t), CHECK, "solution of SolveAll misses the target");
+			++solvedBranches[branches[i]];
+		}
+		for (auto branch = 0U; branch < PumaKinematics::MAX_SOLUTIONS; ++branch)
+		{
+			PumaAngles angles;
+			auto reachable = PumaKinematics::Solve(t.position, t.normal, branch, angles);
+			passed &= Expect(!reachable || Reaches(angles, t), CHECK, "solution of Solve misses the target");
+		}
+		if (!passed)
+			return false;
+	}
+	for (auto branch = 0U; branch < PumaKinematics::MAX_SOLUTIONS; ++branch)
+		passed &= Expect(solvedBranches[branch] > 0, CHECK, "branch never solved");
+
+	//SolveBatch agrees with Solve, including the lanes of the last, partial block
+	vector<float> p[3], n[3], a[PumaKinematics::JOINTS_COUNT];
+	for (auto c = 0; c < 3; ++c)
+	{
+		p[c].resize(TARGETS_COUNT);
+		n[c].resize(TARGETS_COUNT);
+	}
+	for (size_t i = 0; i < TARGETS_COUNT; ++i)
+	{
+		p[0][i] = targets[i].position.x; p[1][i] = targets[i].position.y; p[2][i] = targets[i].position.z;
+		n[0][i] = targets[i].normal.x; n[1][i] = targets[i].normal.y; n[2][i] = targets[i].normal.z;
+	}
+	PumaAnglesSoA soa;
+	for (auto j = 0U; j < PumaKinematics::JOINTS_COUNT; ++j)
+	{
+		a[j].resize(TARGETS_COUNT);
+		soa.a[j] = a[j].data();
+	}
+	const PumaTargetsSoA soaTargets{ p[0].data(), p[1].data(), p[2].data(), n[0].data(), n[1].data(), n[2].data() };
+	vector<uint8_t> reachable(TARGETS_COUNT);
+	for (auto branch = 0U; branch < PumaKinematics::MAX_SOLUTIONS && passed; ++branch)
+	{
+		auto reached = PumaKinematics::SolveBatch(TARGETS_COUNT, soaTargets, branch, soa, reachable.data());
+		size_t expected = 0;
+		for (size_t i = 0; i < TARGETS_COUNT && passed; ++i)
+		{
+			PumaAngles angles;
+			auto solved = PumaKinematics::Solve(targets[i].position, targets[i].normal, branch, angles);
+			expected += solved ? 1 : 0;
+			passed &= Expect((reachable[i] != 0) == solved, CHECK, "SolveBatch and Solve disagree on reach");
+			PumaAngles batch = { a[0][i], a[1][i], a[2][i], a[3][i], a[4][i] };
+			passed &= Expect(!solved || Reaches(batch, targets[i]), CHECK, "solution of SolveBatch misses the target");
+		}
+		passed &= Expect(reached == expected, CHECK, "SolveBatch miscounts reachable targets");
+	}
+
+	//beyond the reach of the arm
+	PumaAngles solutions[PumaKinematics::MAX_SOLUTIONS];
+	auto far = PumaKinematics::L1 + PumaKinematics::L2 + PumaKinematics::L3 + PumaKinematics::DY + 1.0f;
+	passed &= Expect(PumaKinematics::SolveAll(XMFLOAT3(far, 0.0f, 0.0f), XMFLOAT3(0.0f, 1.0f, 0.0f), solutions) == 0,
+		CHECK, "target out of reach solved");
+	return passed;
+}
@@ -0,0 +1,102 @@
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <vector>
+#include "checks.h"
+#include "reachabilityMap.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	const char* CHECK = "reachability_map";
+	const size_t QUERIES = 10000;
+
+	vector<char> ReadFile(const filesystem::path& path)
+	{
+		ifstream input(path, ios::binary);
+		return vector<char>(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+	}
+
+	void WriteFile(const filesystem::path& path, const vector<char>& bytes)
+	{
+		ofstream output(path, ios::binary);
+		output.write(bytes.data(), static_cast<streamsize>(bytes.size()));
+	}
+
+	//Load of the file throws ios_base::failure
+	bool Rejected(const filesystem::path& path)
+	{
+		try
+		{
+			ReachabilityMap::Load(path.wstring());
+		}
+		catch (const ios_base::failure&)
+		{
+			return true;
+		}
+		return false;
+	}
+}
+
+bool mini::gk2::CheckReachabilityMap()
+{
+	//a coarse sweep is enough to fill the map with something to compare
+	ReachabilitySweep sweep;
+	sweep.ShoulderSteps = 32;
+	sweep.ElbowSteps = 32;
+	sweep.RollSteps = 2;
+	sweep.WristSteps = 4;
+	auto map = ReachabilityMap::Build(2.0f * ReachabilityMap::CELL_SIZE, sweep);
+	auto path = filesystem::temp_directory_path() / "headlessChecks.prm";
+	map.Save(path.wstring());
+	auto saved = ReadFile(path);
+
+	auto passed = true;
+	try
+	{
+		auto loaded = ReachabilityMap::Load(path.wstring());
+		passed &= Expect(loaded.radialCells() == map.radialCells() && loaded.verticalCells() == map.verticalCells()
+			&& loaded.cellSize() == map.cellSize(), CHECK, "loaded map has other dimensions");
+		mt19937 random(1);
+		uniform_real_distribution<float> coordinate(-2.5f, 2.5f);
+		for (size_t i = 0; i < QUERIES && passed; ++i)
+		{
+			XMFLOAT3 p(coordinate(random), coordinate(random), coordinate(random));
+			XMFLOAT3 n(coordinate(random), coordinate(random), coordinate(random));
+			passed &= Expect(loaded.Reachable(p) == map.Reachable(p) && loaded.Reachable(p, n) == map.Reachable(p, n)
+				&& loaded.Manipulability(p) == map.Manipulability(p), CHECK, "loaded map answers differently");
+		}
+	}
+	catch (const ios_base::failure&)
+	{
+		passed = Expect(false, CHECK, "saved map not loaded");
+	}
+
+	//truncated files, files of other grids and with trailing data
+	auto truncated = saved;
+	truncated.resize(saved.size() - 1);
+	WriteFile(path, truncated);
+	passed &= Expect(Rejected(path), CHECK, "truncated map loaded");
+	truncated.resize(24);
+	WriteFile(path, truncated);
+	passed &= Expect(Rejected(path), CHECK, "map without cells loaded");
+	auto longer = saved;
+	longer.push_back(0);
+	WriteFile(path, longer);
+	passed &= Expect(Rejected(path), CHECK, "map with trailing data loaded");
+	//header: tag, cell size, bottom, radial cells and vertical cells, each a 4 byte little endian word;
+	//the last byte of a float holds its exponent, the first byte of a count its lowest bits
+	for (auto offset : { 3, 7, 11, 12, 16 })
+	{
+		auto foreign = saved;
+		foreign[offset] ^= 0x01;
+		WriteFile(path, foreign);
+		passed &= Expect(Rejected(path), CHECK, "map with another header loaded");
+	}
+	filesystem::remove(path);
+	return passed;
+}
@@ -0,0 +1,101 @@
+#include <cmath>
+#include "checks.h"
+#include "sceneDistanceField.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	const char* CHECK = "scene_distance_field";
+	//the spacing RoomDemo used, the walls lie exactly on grid planes then
+	const float CELL_SIZE = 0.05f;
+
+	MeshData Rectangle(float side)
+	{
+		MeshData mesh;
+		auto h = 0.5f * side;
+		mesh.Positions = { { -h, -h, 0.0f }, { -h, h, 0.0f }, { h, h, 0.0f }, { h, -h, 0.0f } };
+		mesh.Indices = { 0, 1, 2, 0, 2, 3 };
+		return mesh;
+	}
+
+	MeshData Box()
+	{
+		MeshData mesh;
+		for (auto i = 0U; i < 8U; ++i)
+			mesh.Positions.push_back({ i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f });
+		mesh.Indices = { 0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4, 2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6,
+			1, 3, 5, 3, 7, 5 };
+		return mesh;
+	}
+
+	//walls, desk and box of RoomDemo
+	void AddRoom(SceneDistanceField& field)
+	{
+		auto temp = XMMatrixTranslation(0.0f, 0.0f, 2.0f);
+		auto scale = XMMatrixScaling(2.0f, 2.0f, 2.0f);
+		XMMATRIX walls[6];
+		for (auto i = 0U; i < 4U; ++i)
+			walls[i] = temp * XMMatrixRotationY(i * XM_PIDIV2) * scale;
+		walls[4] = temp * XMMatrixRotationX(XM_PIDIV2) * scale;
+		walls[5] = temp * XMMatrixRotationX(-XM_PIDIV2) * scale;
+		XMFLOAT4X4 mtx;
+		auto wall = Rectangle(4.0f);
+		for (auto& w : walls)
+		{
+			XMStoreFloat4x4(&mtx, w);
+			field.AddMesh(wall, mtx);
+		}
+		XMStoreFloat4x4(&mtx, XMMatrixTranslation(0.0f, 1.0f, 1.0f) * XMMatrixRotationY(-XM_PIDIV2) * XMMatrixRotationZ(XM_PI / 6));
+		field.AddMesh(Rectangle(2.0f), mtx);
+		XMStoreFloat4x4(&mtx, XMMatrixTranslation(-1.4f, -1.46f, -0.6f));
+		field.AddMesh(Box(), mtx);
+	}
+}
+
+bool mini::gk2::CheckSceneDistanceField()
+{
+	SceneDistanceField field;
+	AddRoom(field);
+	field.Build(CELL_SIZE, { 0.0f, 0.0f, 0.0f });
+	auto passed = true;
+	auto expect = [&](XMFLOAT3 p, bool inside, const char* what)
+	{
+		auto d = field.Distance(XMLoadFloat3(&p));
+		if (!Expect(inside ? d < 0.0f : d > 0.0f, CHECK, what))
+		{
+			cerr << "\t(" << p.x << ", " << p.y << ", " << p.z << ") is at " << d << "\n";
+			passed = false;
+		}
+	};
+
+	//behind every wall, on its axis, off it and near the corners of the room
+	for (auto axis = 0U; axis < 3U; ++axis)
+		for (auto side : { -1.0f, 1.0f })
+			for (auto offset : { 0.0f, 1.3f, -2.7f, 3.9f })
+				for (auto depth : { 0.05f, 0.08f })
+				{
+					float p[3] = { offset, -offset, 0.5f * offset };
+					p[axis] = side * (4.0f + depth);
+					expect({ p[0], p[1], p[2] }, true, "point behind a wall is outside");
+				}
+	//inside the box, at its center and near its faces
+	for (auto x : { -0.4f, 0.0f, 0.4f })
+		for (auto y : { -0.4f, 0.0f, 0.4f })
+			for (auto z : { -0.4f, 0.0f, 0.4f })
+				expect({ -1.4f + x, -1.46f + y, -0.6f + z }, true, "point inside the box is outside");
+	//free space around the arm, above the desk and next to the walls
+	const XMFLOAT3 free[] = { { 0.0f, 0.5f, 0.0f }, { 2.0f, 1.0f, 2.0f }, { -2.0f, 2.0f, 2.5f }, { 3.9f, 0.0f, 0.0f },
+		{ 0.0f, -3.9f, 0.0f }, { -1.4f, -0.8f, -0.6f }, { -3.9f, 3.9f, -3.9f } };
+	for (auto& p : free)
+	{
+		expect(p, false, "free point is inside");
+		//sampling errors stay within a cell
+		auto error = fabsf(field.Distance(XMLoadFloat3(&p)) - field.ExactDistance(XMLoadFloat3(&p)));
+		passed &= Expect(error <= CELL_SIZE, CHECK, "distance differs from the exact one by more than a cell");
+	}
+	return passed;
+}
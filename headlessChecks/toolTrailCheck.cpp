@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "checks.h"
+#include "toolTrail.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	const char* CHECK = "tool_trail";
+	const size_t CAPACITY = 8;
+
+	//Vertex buffer as the GPU sees it, with the ranges draws read since the last discard
+	struct Buffer
+	{
+		vector<XMFLOAT3> vertices;
+		size_t drawnEnd = 0;	//end of the furthest range drawn since the last discard
+	};
+
+	bool Equal(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return a.x == b.x && a.y == b.y && a.z == b.z;
+	}
+
+	//Uploads and draws one frame, then compares the strip with the last points pushed
+	bool Frame(ToolTrail& trail, Buffer& buffer, const vector<XMFLOAT3>& pushed, const char* stage)
+	{
+		auto passed = true;
+		auto upload = trail.TakeUpload();
+		if (upload.Count)
+		{
+			passed &= Expect(upload.First + upload.Count <= buffer.vertices.size(), CHECK, "upload outside the buffer");
+			if (upload.Discard)
+			{
+				fill(buffer.vertices.begin(), buffer.vertices.end(), XMFLOAT3(NAN, NAN, NAN));
+				buffer.drawnEnd = 0;
+			}
+			//with D3D11_MAP_WRITE_NO_OVERWRITE earlier draws may still read the buffer
+			passed &= Expect(upload.First >= buffer.drawnEnd, CHECK, "upload overwrites vertices of an earlier draw");
+			if (!passed)
+				return false;
+			copy_n(trail.vertices().begin() + upload.First, upload.Count, buffer.vertices.begin() + upload.First);
+		}
+
+		auto range = trail.drawRange();
+		auto points = min(pushed.size(), CAPACITY);
+		if (!Expect(range.Count == (points >= 2 ? points : 0), CHECK, stage))
+			return false;
+		if (!range.Count)
+			return passed;
+		buffer.drawnEnd = max<size_t>(buffer.drawnEnd, range.First + range.Count);
+		passed &= Expect(range.First + range.Count <= buffer.vertices.size(), CHECK, "draw outside the buffer");
+		//the newest points in order; after the trail moves to the start of the buffer the strip continues
+		//through the points drawn before, with no vertex repeated at a seam
+		for (size_t i = 0; i < range.Count && passed; ++i)
+			passed &= Expect(Equal(buffer.vertices[range.First + i], pushed[pushed.size() - range.Count + i]), CHECK, stage);
+		return passed;
+	}
+}
+
+bool mini::gk2::CheckToolTrail()
+{
+	ToolTrail trail(CAPACITY, 0.01f);
+	Buffer buffer;
+	buffer.vertices.resize(trail.vertices().size());
+	vector<XMFLOAT3> pushed;
+	auto passed = Expect(trail.vertices().size() == 2 * CAPACITY, CHECK, "buffer isn't twice the trail");
+	auto point = [&](size_t i) { return XMFLOAT3(0.1f * i, 0.0f, 0.0f); };
+	auto push = [&]
+	{
+		auto p = point(pushed.size());
+		pushed.push_back(p);
+		return trail.Push(p);
+	};
+
+	passed &= Frame(trail, buffer, pushed, "empty trail is drawn");
+	passed &= push();
+	passed &= Frame(trail, buffer, pushed, "single point is drawn");
+	passed &= Expect(!trail.Push(XMFLOAT3(0.001f, 0.0f, 0.0f)), CHECK, "point closer than minDistance added");
+	//partial fill, then exactly the capacity of the trail
+	for (auto i = 1U; i < CAPACITY / 2; ++i)
+		passed &= push();
+	passed &= Frame(trail, buffer, pushed, "partial fill");
+	while (pushed.size() < CAPACITY)
+		passed &= push();
+	passed &= Frame(trail, buffer, pushed, "exact fill");
+	//the whole buffer, then past it a few times with different numbers of points per frame
+	while (pushed.size() < 2 * CAPACITY)
+		passed &= push();
+	passed &= Frame(trail, buffer, pushed, "full buffer");
+	passed &= push();
+	auto upload = trail.TakeUpload();
+	passed &= Expect(upload.Discard && upload.First == 0 && upload.Count == CAPACITY, CHECK, "wrap doesn't discard the newest points");
+	copy_n(trail.vertices().begin(), upload.Count, buffer.vertices.begin());
+	buffer.drawnEnd = 0;
+	passed &= Frame(trail, buffer, pushed, "first frame after the wrap");
+	for (auto frame = 0U; frame < 10 * CAPACITY && passed; ++frame)
+	{
+		for (auto i = 0U; i < frame % 4; ++i)
+			passed &= push();
+		passed &= Frame(trail, buffer, pushed, "frame after the wrap");
+	}
+
+	trail.Clear();
+	pushed.clear();
+	passed &= Frame(trail, buffer, pushed, "cleared trail is drawn");
+	passed &= push();
+	passed &= push();
+	upload = trail.TakeUpload();
+	passed &= Expect(upload.Discard && upload.First == 0 && upload.Count == 2, CHECK, "points after Clear don't discard");
+	return passed;
+}
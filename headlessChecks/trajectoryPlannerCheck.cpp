@@ -0,0 +1,93 @@
+#include <algorithm>
+#include <cmath>
+#include "checks.h"
+#include "trajectoryPlanner.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	const char* CHECK = "trajectory_planner";
+	const float DURATION = 4.0f;
+	const float KEY_TOLERANCE = 1e-3f;	//meters between tool tip at a key and the path, IK rounding only
+	//meters between tool tip and the path between keys; Compact lets joints stray TrajectoryPlanner::TOLERANCE
+	//from the samples it removes, which the arm's reach turns into millimeters
+	const float TOLERANCE = 3e-3f;
+
+	float Distance(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		return XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&a), XMLoadFloat3(&b))));
+	}
+
+	//Tool tip and normal of the trajectory at time are where the path is at parameter t
+	bool OnPath(const JointTrajectory& trajectory, const CartesianPath& path, float time, float t, float tolerance)
+	{
+		XMFLOAT3 tip, normal, position, pathNormal;
+		PumaKinematics::EndEffector(trajectory.Sample(time), tip, normal);
+		path.Evaluate(t, position, pathNormal);
+		return Distance(tip, position) <= tolerance && Distance(normal, pathNormal) <= tolerance;
+	}
+
+	//No joint moves by more than TrajectoryPlanner::MAX_JOINT_STEP between consecutive samples
+	bool Continuous(const JointTrajectory& trajectory, size_t samples)
+	{
+		auto last = trajectory.Sample(0.0f);
+		for (size_t i = 1; i <= samples; ++i)
+		{
+			auto angles = trajectory.Sample(trajectory.duration() * i / samples);
+			for (size_t j = 0; j < angles.size(); ++j)
+				if (fabsf(angles[j] - last[j]) > TrajectoryPlanner::MAX_JOINT_STEP)
+					return false;
+			last = angles;
+		}
+		return true;
+	}
+}
+
+bool mini::gk2::CheckTrajectoryPlanner()
+{
+	//the circle RoomDemo draws on the desk, starting from its home pose
+	XMFLOAT4X4 deskMtx;
+	XMStoreFloat4x4(&deskMtx, XMMatrixTranslation(0.0f, 1.0f, 1.0f) * XMMatrixRotationY(-XM_PIDIV2) * XMMatrixRotationZ(XM_PI / 6));
+	auto circle = CirclePath::OnPlane(deskMtx, { 0.0f, 0.0f }, 0.4f);
+	const PumaAngles home{ 0.0f, -0.5f, 0.0f, 0.0f, 0.0f };
+	TrajectoryPlanner planner;
+	JointTrajectory trajectory;
+	if (!Expect(planner.Plan(circle, DURATION, home, trajectory), CHECK, "desk circle not planned"))
+		return false;
+
+	auto passed = Expect(fabsf(trajectory.duration() - DURATION) <= 1e-4f, CHECK, "trajectory doesn't last the duration");
+	passed &= Expect(trajectory.keysCount() < DURATION * TrajectoryPlanner::SAMPLES_PER_SECOND, CHECK, "trajectory isn't compacted");
+	//the path is traversed at constant parameter speed, so time maps to the path parameter
+	for (auto time : trajectory.times())
+		passed &= Expect(OnPath(trajectory, circle, time, time / DURATION, KEY_TOLERANCE), CHECK, "key off the path");
+	const auto samples = static_cast<size_t>(10 * DURATION * TrajectoryPlanner::SAMPLES_PER_SECOND);
+	for (size_t i = 0; i <= samples && passed; ++i)
+	{
+		auto t = static_cast<float>(i) / samples;
+		passed &= Expect(OnPath(trajectory, circle, t * DURATION, t, TOLERANCE), CHECK, "trajectory strays from the path");
+	}
+	passed &= Expect(Continuous(trajectory, samples), CHECK, "joint jumps between samples");
+
+	//time optimal version of the same path, keys at times given by the parameterization
+	JointTrajectory timed;
+	if (!Expect(planner.Plan(circle, PathParameterization(JointLimits::Puma()), home, timed), CHECK, "timed circle not planned"))
+		return false;
+	auto desk = XMLoadFloat4x4(&deskMtx);
+	auto center = XMVector3TransformCoord(XMVectorZero(), desk);
+	auto deskNormal = XMVector3Normalize(XMVector3TransformNormal(XMVectorSet(0.0f, 0.0f, -1.0f, 0.0f), desk));
+	for (auto& angles : timed.angles())
+	{
+		XMFLOAT3 tip, normal;
+		PumaKinematics::EndEffector(angles, tip, normal);
+		auto offset = XMVectorSubtract(XMLoadFloat3(&tip), center);
+		auto height = XMVectorGetX(XMVector3Dot(offset, deskNormal));
+		auto radius = XMVectorGetX(XMVector3Length(offset));
+		passed &= Expect(fabsf(height) <= KEY_TOLERANCE && fabsf(radius - 0.4f) <= KEY_TOLERANCE, CHECK, "timed key off the circle");
+	}
+	passed &= Expect(Continuous(timed, samples), CHECK, "joint jumps between samples of the timed trajectory");
+	return passed;
+}
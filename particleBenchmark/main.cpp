@@ -0,0 +1,245 @@
+//Headless benchmark of the smoke particle system - no window and no Direct3D device required.
+//Drives ParticleSystem with synthetic camera paths and reports the cost of each update stage
+//in nanoseconds per particle as JSON.
+//
+//Windows: build the particleBenchmark project from gk2-lab2.sln.
+//Linux (DirectXMath headers and the sal.h stub from DirectX-Headers/include/wsl/stubs on the include path):
+//	g++ -std=c++17 -O2 -I../gk2-lab2 main.cpp ../gk2-lab2/particleSystem.cpp ../gk2-lab2/particleColliders.cpp
+//		../gk2-lab2/frustum.cpp ../gk2-lab2/particleBillboards.cpp ../gk2-lab2/turbulenceField.cpp
+//		../gk2-lab2/textureGenerator.cpp ../gk2-lab2/spatialHashGrid.cpp ../gk2-lab2/meshSurfaceSampler.cpp
+//		../gk2-lab2/meshData.cpp -pthread -o particleBenchmark
+//
+//Usage: particleBenchmark [--frames N] [--seed S] [--out results.json] [particle counts...]
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "particleSystem.h"
+#include "particleColliders.h"
+#include "particleBillboards.h"
+#include "turbulenceField.h"
+#include "frustum.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	using BenchClock = chrono::steady_clock;
+
+	const XMFLOAT3 EMITTER_POSITION(-1.3f, -0.6f, -0.14f);
+	const size_t DEFAULT_COUNTS[] = { 500, 5000, 50000, 100000, 500000, 1000000 };
+
+	enum Stage
+	{
+		Simulate,
+		Turbulence,
+		Repulsion,
+		Collide,
+		Expire,
+		Spawn,
+		Vertices,
+		Sort,
+		Billboards,
+		StagesCount
+	};
+
+	const char* STAGE_NAMES[StagesCount] = { "simulate", "turbulence", "repulsion", "collide", "expire", "spawn", "vertices", "sort", "billboards" };
+
+	struct StageTime
+	{
+		double ns = 0.0;
+		size_t particles = 0;
+
+		double nsPerParticle() const { return particles ? ns / particles : 0.0; }
+	};
+
+	struct CameraPath
+	{
+		const char* name;
+		//camera position and target at time t in seconds
+		void(*at)(float t, XMFLOAT3& position, XMFLOAT3& target);
+	};
+
+	struct Result
+	{
+		const char* path;
+		size_t particles;
+		unsigned int frames;
+		double visible;		//average number of particles that passed frustum culling
+		StageTime stages[StagesCount];
+	};
+
+	//circles around the plume looking at it
+	void Orbit(float t, XMFLOAT3& position, XMFLOAT3& target)
+	{
+		auto a = 0.5f * t;
+		target = XMFLOAT3(EMITTER_POSITION.x, EMITTER_POSITION.y + 0.7f, EMITTER_POSITION.z);
+		position = XMFLOAT3(target.x + 3.0f * cosf(a), target.y + 0.5f, target.z + 3.0f * sinf(a));
+	}
+
+	//passes by the plume, so it enters and leaves the view
+	void Flyby(float t, XMFLOAT3& position, XMFLOAT3& target)
+	{
+		auto x = -4.0f + fmodf(t, 4.0f) * 2.0f;
+		position = XMFLOAT3(x, 0.0f, -3.0f);
+		target = XMFLOAT3(x, 0.0f, 0.0f);
+	}
+
+	//orbits while looking away from the plume, everything is culled
+	void Away(float t, XMFLOAT3& position, XMFLOAT3& target)
+	{
+		Orbit(t, position, target);
+		target = XMFLOAT3(2.0f * position.x - target.x, position.y, 2.0f * position.z - target.z);
+	}
+
+	const CameraPath PATHS[] = { { "orbit", Orbit }, { "flyby", Flyby }, { "away", Away } };
+
+	shared_ptr<ParticleColliders> RoomColliders()
+	{
+		//the same walls, desk and box RoomDemo uses
+		auto colliders = make_shared<ParticleColliders>();
+		colliders->AddPlane({ 0.0f, -4.0f, 0.0f }, { 0.0f, 1.0f, 0.0f });
+		colliders->AddPlane({ 0.0f, 4.0f, 0.0f }, { 0.0f, -1.0f, 0.0f });
+		colliders->AddPlane({ -4.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f });
+		colliders->AddPlane({ 4.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f });
+		colliders->AddPlane({ 0.0f, 0.0f, -4.0f }, { 0.0f, 0.0f, 1.0f });
+		colliders->AddPlane({ 0.0f, 0.0f, 4.0f }, { 0.0f, 0.0f, -1.0f });
+		XMFLOAT4X4 deskMtx, boxMtx;
+		XMStoreFloat4x4(&deskMtx, XMMatrixTranslation(0.0f, 1.0f, 1.0f) * XMMatrixRotationY(-XM_PIDIV2) * XMMatrixRotationZ(XM_PI / 6));
+		XMStoreFloat4x4(&boxMtx, XMMatrixTranslation(-1.4f, -1.46f, -0.6f));
+		colliders->AddBox(deskMtx, { 1.0f, 1.0f, 0.01f });
+		colliders->AddBox(boxMtx, { 0.5f, 0.5f, 0.5f });
+		return colliders;
+	}
+
+	template<typename F>
+	void Measure(StageTime& stage, size_t particles, F&& f)
+	{
+		auto start = BenchClock::now();
+		f();
+		stage.ns += chrono::duration<double, nano>(BenchClock::now() - start).count();
+		stage.particles += particles;
+	}
+
+	Result Run(const CameraPath& path, size_t count, unsigned int frames, unsigned int seed,
+		const shared_ptr<ParticleColliders>& colliders)
+	{
+		const auto dt = ParticleSystem::FIXED_TIME_STEP;
+		ParticleSystem particles(EMITTER_POSITION, count);
+		particles.Seed(seed);
+		particles.SetColliders(colliders);
+		particles.SetTurbulence(TurbulenceField::Shared());
+		particles.SetRepulsion();
+		//emit fast enough to keep the requested number of particles alive
+		particles.SetLevelOfDetail(count / ParticleSystem::SteadyStateCount(), 1.0f, count);
+
+		auto warmUpSteps = static_cast<unsigned int>(ParticleSystem::TimeToLive() / dt) + 1;
+		for (auto i = 0U; i < warmUpSteps; ++i)
+			particles.Step(dt);
+
+		auto proj = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.01f, 100.0f);
+		Result r = {};
+		r.path = path.name;
+		r.particles = count;
+		r.frames = frames;
+		vector<ParticleVertex> vertices;
+		vector<ParticleQuadVertex> quads;
+		auto visible = 0.0;
+		for (auto f = 0U; f < frames; ++f)
+		{
+			XMFLOAT3 camPos, camTarget;
+			path.at(f * dt, camPos, camTarget);
+			auto view = XMMatrixLookAtLH(XMLoadFloat3(&camPos), XMLoadFloat3(&camTarget), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+			ViewFrustum frustum(view * proj);
+
+			Measure(r.stages[Simulate], particles.particlesCount(), [&] { particles.SimulateParticles(dt); });
+			Measure(r.stages[Turbulence], particles.particlesCount(), [&] { particles.TurbulenceParticles(dt); });
+			Measure(r.stages[Repulsion], particles.particlesCount(), [&] { particles.RepelParticles(dt); });
+			Measure(r.stages[Collide], particles.particlesCount(), [&] { particles.CollideParticles(); });
+			Measure(r.stages[Expire], particles.particlesCount(), [&] { particles.ExpireParticles(); });
+			Measure(r.stages[Spawn], particles.particlesCount(), [&] { particles.SpawnParticles(dt); });
+			Measure(r.stages[Vertices], particles.particlesCount(), [&] { vertices = particles.GetParticleVerts(frustum, 0.5f); });
+			XMFLOAT4 camPos4(camPos.x, camPos.y, camPos.z, 1.0f);
+			Measure(r.stages[Sort], vertices.size(), [&] { ParticleSystem::SortParticleVerts(vertices, camPos4); });
+			Measure(r.stages[Billboards], vertices.size(), [&]
+			{
+				ParticleBillboards::Expand(vertices, view, ParticleSystem::TimeToLive(), quads);
+			});
+			visible += vertices.size();
+		}
+		r.visible = frames ? visible / frames : 0.0;
+		return r;
+	}
+
+	void WriteJson(ostream& out, const vector<Result>& results, unsigned int seed)
+	{
+		out << "{\n\t\"benchmark\": \"particles\",\n\t\"seed\": " << seed << ",\n\t\"results\": [";
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			auto& r = results[i];
+			out << (i ? "," : "") << "\n\t\t{ \"path\": \"" << r.path << "\", \"particles\": " << r.particles
+				<< ", \"frames\": " << r.frames << ", \"visible\": " << r.visible << ", \"ns_per_particle\": { ";
+			for (auto s = 0; s < StagesCount; ++s)
+				out << (s ? ", " : "") << "\"" << STAGE_NAMES[s] << "\": " << r.stages[s].nsPerParticle();
+			out << " } }";
+		}
+		out << "\n\t]\n}\n";
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int frames = 120;
+	unsigned int seed = 1;
+	string outPath;
+	vector<size_t> counts;
+	for (auto i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--frames") && i + 1 < argc)
+			frames = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+		else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+			seed = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+		else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+			outPath = argv[++i];
+		else if (auto n = strtoull(argv[i], nullptr, 10))
+			counts.push_back(static_cast<size_t>(n));
+		else
+		{
+			cerr << "Usage: " << argv[0] << " [--frames N] [--seed S] [--out results.json] [particle counts...]\n";
+			return EXIT_FAILURE;
+		}
+	}
+	if (counts.empty())
+		counts.assign(begin(DEFAULT_COUNTS), end(DEFAULT_COUNTS));
+
+	auto colliders = RoomColliders();
+	vector<Result> results;
+	for (auto count : counts)
+		for (auto& path : PATHS)
+		{
+			results.push_back(Run(path, count, frames, seed, colliders));
+			cerr << path.name << " " << count << " done\n";
+		}
+
+	if (outPath.empty())
+		WriteJson(cout, results, seed);
+	else
+	{
+		ofstream out(outPath);
+		if (!out)
+		{
+			cerr << "Unable to open " << outPath << "\n";
+			return EXIT_FAILURE;
+		}
+		WriteJson(out, results, seed);
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,234 @@
+//Headless benchmark of the joint space motion planner - no window and no Direct3D device required.
+//Plans a standard set of moves between poses of the PUMA arm in the room of RoomDemo, every one several times
+//from consecutive seeds, and reports planning time, tree sizes, collision tests and path lengths as JSON.
+//
+//Windows: build the plannerBenchmark project from gk2-lab2.sln.
+//Linux (DirectXMath headers and the sal.h stub from DirectX-Headers/include/wsl/stubs on the include path):
+//	g++ -std=c++17 -O2 -I../gk2-lab2 main.cpp ../gk2-lab2/jointKdTree.cpp ../gk2-lab2/jointTrajectory.cpp
+//		../gk2-lab2/kinematicChain.cpp ../gk2-lab2/meshData.cpp ../gk2-lab2/motionPlanner.cpp
+//		../gk2-lab2/pathParameterization.cpp ../gk2-lab2/pumaCollision.cpp ../gk2-lab2/pumaKinematics.cpp
+//		-pthread -o plannerBenchmark
+//
+//Usage: plannerBenchmark [--runs N] [--seed S] [--meshes directory] [--out results.json]
+//	--meshes - directory with the PUMA link meshes mesh1.mesh ... mesh6.mesh, see PumaCollision
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "motionPlanner.h"
+#include "pumaCollision.h"
+#include "pumaKinematics.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	using BenchClock = chrono::steady_clock;
+
+	//the tool touches surfaces on purpose, so like RoomDemo only the other links are tested
+	const unsigned int TESTED_LINKS = PumaCollision::ALL_LINKS & ~(1U << PumaCollision::TOOL_LINK);
+
+	struct Pose
+	{
+		const char* name;
+		XMFLOAT3 position;	//tool tip
+		XMFLOAT3 normal;	//of the surface the tool points at
+	};
+
+	//tool targets at the desk, at the box and around the room, solved to the first collision-free IK branch
+	const Pose POSES[] =
+	{
+		{ "above_desk", { -1.2f, 0.47f, 0.0f }, { 0.866f, 0.5f, 0.0f } },
+		{ "desk_corner", { -1.0f, -0.1f, -0.6f }, { 0.866f, 0.5f, 0.0f } },
+		{ "box_side", { -0.8f, -1.1f, -0.8f }, { 1.0f, 0.0f, 0.0f } },
+		{ "behind", { 1.4f, 0.6f, 0.0f }, { -1.0f, 0.0f, 0.0f } },
+		{ "low", { 0.3f, -1.0f, -1.0f }, { 0.0f, 1.0f, 0.0f } },
+		{ "ceiling", { 0.3f, 2.0f, 0.3f }, { 0.0f, -1.0f, 0.0f } },
+		{ "left", { 0.0f, 0.6f, 1.5f }, { 0.0f, 0.0f, -1.0f } },
+		{ "right", { 0.0f, 0.5f, -1.6f }, { 0.0f, 0.0f, 1.0f } }
+	};
+
+	struct Query
+	{
+		const char* from;
+		const char* to;
+	};
+
+	const Query QUERIES[] =
+	{
+		{ "above_desk", "desk_corner" },
+		{ "above_desk", "box_side" },
+		{ "box_side", "behind" },
+		{ "desk_corner", "low" },
+		{ "low", "ceiling" },
+		{ "left", "right" },
+		{ "right", "above_desk" },
+		{ "left", "box_side" }
+	};
+
+	struct Result
+	{
+		const char* from;
+		const char* to;
+		unsigned int runs;
+		vector<double> ms;	//planning time of every run
+		MotionPlannerStats stats;
+	};
+
+	PumaCollision RoomCollision(const string& meshDirectory)
+	{
+		MeshData meshes[PumaCollision::LINKS_COUNT];
+		for (auto i = 0U; i < PumaCollision::LINKS_COUNT; ++i)
+			meshes[i] = MeshData::Load((filesystem::path(meshDirectory) / ("mesh" + to_string(i + 1) + ".mesh")).wstring());
+		PumaCollision collision;
+		collision.FitLinks(meshes);
+		//the same walls, desk and box RoomDemo uses
+		collision.AddPlane({ 0.0f, -4.0f, 0.0f }, { 0.0f, 1.0f, 0.0f });
+		collision.AddPlane({ 0.0f, 4.0f, 0.0f }, { 0.0f, -1.0f, 0.0f });
+		collision.AddPlane({ -4.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f });
+		collision.AddPlane({ 4.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f });
+		collision.AddPlane({ 0.0f, 0.0f, -4.0f }, { 0.0f, 0.0f, 1.0f });
+		collision.AddPlane({ 0.0f, 0.0f, 4.0f }, { 0.0f, 0.0f, -1.0f });
+		XMFLOAT4X4 deskMtx, boxMtx;
+		XMStoreFloat4x4(&deskMtx, XMMatrixTranslation(0.0f, 1.0f, 1.0f) * XMMatrixRotationY(-XM_PIDIV2) * XMMatrixRotationZ(XM_PI / 6));
+		XMStoreFloat4x4(&boxMtx, XMMatrixTranslation(-1.4f, -1.46f, -0.6f));
+		collision.AddBox(deskMtx, { 1.0f, 1.0f, 0.01f });
+		collision.AddBox(boxMtx, { 0.5f, 0.5f, 0.5f });
+		return collision;
+	}
+
+	bool SolvePose(const Pose& pose, const PumaCollision& collision, PumaAngles& angles)
+	{
+		PumaAngles solutions[PumaKinematics::MAX_SOLUTIONS];
+		auto count = PumaKinematics::SolveAll(pose.position, pose.normal, solutions);
+		for (auto i = 0U; i < count; ++i)
+			if (!collision.CollidingLinks(solutions[i], TESTED_LINKS))
+			{
+				angles = solutions[i];
+				return true;
+			}
+		return false;
+	}
+
+	Result Run(const Query& query, const PumaAngles& from, const PumaAngles& to, unsigned int runs, unsigned int seed,
+		MotionPlanner& planner)
+	{
+		Result r = {};
+		r.from = query.from;
+		r.to = query.to;
+		r.runs = runs;
+		vector<PumaAngles> path;
+		for (auto i = 0U; i < runs; ++i)
+		{
+			planner.Seed(seed + i);
+			auto start = BenchClock::now();
+			planner.Plan(from, to, path, &r.stats);
+			r.ms.push_back(chrono::duration<double, milli>(BenchClock::now() - start).count());
+		}
+		return r;
+	}
+
+	void WriteJson(ostream& out, const vector<Result>& results, unsigned int seed)
+	{
+		out << "{\n\t\"benchmark\": \"planner\",\n\t\"seed\": " << seed << ",\n\t\"results\": [";
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			auto& r = results[i];
+			auto sorted = r.ms;
+			sort(sorted.begin(), sorted.end());
+			auto mean = 0.0;
+			for (auto ms : sorted)
+				mean += ms;
+			mean = sorted.empty() ? 0.0 : mean / sorted.size();
+			auto median = sorted.empty() ? 0.0 : sorted[sorted.size() / 2];
+			auto worst = sorted.empty() ? 0.0 : sorted.back();
+			auto solved = max(r.stats.solved, size_t(1));
+			out << (i ? "," : "") << "\n\t\t{ \"from\": \"" << r.from << "\", \"to\": \"" << r.to << "\", \"runs\": " << r.runs
+				<< ", \"success_rate\": " << r.stats.successRate()
+				<< ", \"ms\": { \"mean\": " << mean << ", \"median\": " << median << ", \"max\": " << worst << " }"
+				<< ", \"iterations\": " << static_cast<double>(r.stats.iterations) / r.runs
+				<< ", \"nodes\": " << static_cast<double>(r.stats.nodes) / r.runs
+				<< ", \"tested\": " << static_cast<double>(r.stats.tested) / r.runs
+				<< ", \"raw_length\": " << r.stats.rawLength / solved << ", \"length\": " << r.stats.length / solved << " }";
+		}
+		out << "\n\t]\n}\n";
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	unsigned int runs = 10;
+	unsigned int seed = 1;
+	string meshDirectory = "../gk2-lab2/resources/meshes";
+	string outPath;
+	for (auto i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--runs") && i + 1 < argc)
+			runs = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+		else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+			seed = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+		else if (!strcmp(argv[i], "--meshes") && i + 1 < argc)
+			meshDirectory = argv[++i];
+		else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+			outPath = argv[++i];
+		else
+		{
+			cerr << "Usage: " << argv[0] << " [--runs N] [--seed S] [--meshes directory] [--out results.json]\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	try
+	{
+		auto collision = RoomCollision(meshDirectory);
+		vector<PumaAngles> poses(size(POSES));
+		for (size_t i = 0; i < poses.size(); ++i)
+			if (!SolvePose(POSES[i], collision, poses[i]))
+			{
+				cerr << "Pose " << POSES[i].name << " has no collision-free solution\n";
+				return EXIT_FAILURE;
+			}
+		auto pose = [&](const char* name)
+		{
+			return poses[find_if(begin(POSES), end(POSES), [&](const Pose& p) { return !strcmp(p.name, name); }) - begin(POSES)];
+		};
+
+		MotionPlanner::Settings settings;
+		settings.Links = TESTED_LINKS;
+		MotionPlanner planner(collision, settings);
+		vector<Result> results;
+		for (auto& query : QUERIES)
+		{
+			results.push_back(Run(query, pose(query.from), pose(query.to), runs, seed, planner));
+			cerr << query.from << " -> " << query.to << " done\n";
+		}
+
+		if (outPath.empty())
+			WriteJson(cout, results, seed);
+		else
+		{
+			ofstream out(outPath);
+			if (!out)
+			{
+				cerr << "Unable to open " << outPath << "\n";
+				return EXIT_FAILURE;
+			}
+			WriteJson(out, results, seed);
+		}
+	}
+	catch (const exception& e)
+	{
+		cerr << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
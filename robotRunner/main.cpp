@@ -0,0 +1,401 @@
+//Headless runner of the PUMA robot - no window and no Direct3D device required.
+//Plays motion programs on the robot model with a synthetic clock, as fast as the CPU allows, and writes
+//joint angles, tool tip and lamp light of the traced steps to one file per program. Programs are read from
+//motion program files (see MotionCompiler) or generated, every one from its own seed, so traces are reproducible.
+//Programs run in parallel. Given the link meshes, peak joint torques of all programs are reported too.
+//
+//Windows: build the robotRunner project from gk2-lab2.sln.
+//Linux (DirectXMath headers and the sal.h stub from DirectX-Headers/include/wsl/stubs on the include path):
+//	g++ -std=c++17 -O2 -I../gk2-lab2 main.cpp ../gk2-lab2/cartesianPath.cpp ../gk2-lab2/jointTrajectory.cpp
+//		../gk2-lab2/kinematicChain.cpp ../gk2-lab2/lampAnimation.cpp ../gk2-lab2/meshData.cpp ../gk2-lab2/motionProgram.cpp
+//		../gk2-lab2/pathParameterization.cpp ../gk2-lab2/pumaDynamics.cpp ../gk2-lab2/pumaIKCache.cpp
+//		../gk2-lab2/pumaKinematics.cpp ../gk2-lab2/reachabilityMap.cpp ../gk2-lab2/rigidBody.cpp
+//		../gk2-lab2/trajectoryPlanner.cpp -pthread -o robotRunner
+//
+//Usage: robotRunner [--programs N] [--seed S] [--rate Hz] [--trace-rate Hz] [--format csv|bin] [--out directory]
+//		[--meshes directory] [program files...]
+//	--programs - number of programs generated when no files are given
+//	--rate - simulation steps per simulated second
+//	--trace-rate - traced steps per simulated second, 0 disables traces
+//	--meshes - directory with the PUMA link meshes mesh1.mesh ... mesh6.mesh, see PumaDynamics
+//
+//Binary traces start with the tag "PRT1" and the number of floats in a record (uint32), followed by records
+//of little endian floats in the order of the CSV columns.
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "kinematicChain.h"
+#include "lampAnimation.h"
+#include "motionProgram.h"
+#include "parallel.h"
+#include "pathParameterization.h"
+#include "pumaDynamics.h"
+#include "pumaKinematics.h"
+#include "trajectoryPlanner.h"
+
+using namespace mini;
+using namespace gk2;
+using namespace DirectX;
+using namespace std;
+
+namespace
+{
+	using RunClock = chrono::steady_clock;
+
+	const uint32_t TRACE_TAG = 0x31545250; //"PRT1"
+	const char* TRACE_COLUMNS = "time,a0,a1,a2,a3,a4,x,y,z,nx,ny,nz,lx,ly,lz";
+
+	const unsigned int MOVES_PER_PROGRAM = 6;
+	const float MIN_LINE_LENGTH = 0.1f;
+	const float MAX_LINE_LENGTH = 0.4f;
+	//joint targets of random joint moves, kept away from the floor and the arm itself
+	const PumaAngles MIN_ANGLES = { -XM_PI, -1.2f, -1.5f, -XM_PI, -1.5f };
+	const PumaAngles MAX_ANGLES = { XM_PI, 1.2f, 1.5f, XM_PI, 1.5f };
+	//spacing of torque samples, shorter than the segments between most trajectory keys
+	const float TORQUE_STEP = 0.01f;
+
+	struct TraceRecord
+	{
+		float time;
+		PumaAngles angles;
+		XMFLOAT3 position, normal;
+		XMFLOAT3 light;
+	};
+
+	static_assert(sizeof(TraceRecord) == 15 * sizeof(float), "TraceRecord must match TRACE_COLUMNS");
+
+	struct Settings
+	{
+		unsigned int programs = 16;
+		unsigned int seed = 1;
+		float rate = 1000.0f;
+		float traceRate = 100.0f;
+		bool binary = false;
+		string outDirectory = "traces";
+		string meshDirectory;
+		vector<string> programFiles;
+	};
+
+	struct Totals
+	{
+		size_t programs = 0;
+		size_t moves = 0;
+		size_t lineMoves = 0;		//planned as straight lines of the tool
+		size_t failedLines = 0;		//lines the planner rejected, replaced by joint moves
+		size_t steps = 0;
+		size_t records = 0;
+		size_t failedTraces = 0;	//traces that couldn't be opened or written completely
+		double simulatedSeconds = 0.0;
+		PumaAngles peakTorques{};	//largest torque of every joint, if dynamics were evaluated
+
+		void Add(const Totals& other)
+		{
+			for (size_t j = 0; j < peakTorques.size(); ++j)
+				peakTorques[j] = max(peakTorques[j], other.peakTorques[j]);
+			programs += other.programs;
+			moves += other.moves;
+			lineMoves += other.lineMoves;
+			failedLines += other.failedLines;
+			steps += other.steps;
+			records += other.records;
+			failedTraces += other.failedTraces;
+			simulatedSeconds += other.simulatedSeconds;
+		}
+	};
+
+	//Random program of joint moves and straight tool moves, starting in the rest pose
+	vector<JointTrajectory> GenerateProgram(unsigned int seed, const PathParameterization& timing, Totals& totals)
+	{
+		mt19937 random(seed);
+		uniform_real_distribution<float> unit(0.0f, 1.0f);
+		TrajectoryPlanner planner;
+		vector<JointTrajectory> program;
+		PumaAngles current{};
+		for (auto m = 0U; m < MOVES_PER_PROGRAM; ++m)
+		{
+			JointTrajectory move;
+			if (unit(random) < 0.5f)
+			{
+				++totals.lineMoves;
+				//line from the current tool tip in a random direction, keeping the tool direction
+				XMFLOAT3 from, normal, to;
+				PumaKinematics::EndEffector(current, from, normal);
+				auto dir = XMVector3Normalize(XMVectorSet(2.0f * unit(random) - 1.0f, 2.0f * unit(random) - 1.0f,
+					2.0f * unit(random) - 1.0f, 0.0f));
+				auto length = MIN_LINE_LENGTH + (MAX_LINE_LENGTH - MIN_LINE_LENGTH) * unit(random);
+				XMStoreFloat3(&to, XMVectorAdd(XMLoadFloat3(&from), XMVectorScale(dir, length)));
+				if (!planner.Plan(LinePath(from, to, normal), timing, current, move))
+				{
+					++totals.failedLines;
+					move = JointTrajectory();
+				}
+			}
+			if (move.empty())
+			{
+				PumaAngles target;
+				for (size_t j = 0; j < target.size(); ++j)
+					target[j] = MIN_ANGLES[j] + (MAX_ANGLES[j] - MIN_ANGLES[j]) * unit(random);
+				move = timing.Retime(JointTrajectory::JointMove(current, target, 1.0f));
+			}
+			//the planner may start in another turn of the roll or wrist, so the arm is brought there first
+			auto& start = move.angles().front();
+			auto gap = 0.0f;
+			for (size_t j = 0; j < start.size(); ++j)
+				gap = max(gap, fabsf(start[j] - current[j]));
+			if (gap > 1e-3f)
+				program.push_back(timing.Retime(JointTrajectory::JointMove(current, start, 1.0f)));
+			current = move.angles().back();
+			program.push_back(move);
+		}
+		totals.moves += program.size();
+		return program;
+	}
+
+	void WriteRecord(ostream& out, const TraceRecord& r, bool binary)
+	{
+		if (binary)
+		{
+			out.write(reinterpret_cast<const char*>(&r), sizeof(r));
+			return;
+		}
+		char line[256];
+		auto n = snprintf(line, sizeof(line), "%.4f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.5f,%.5f,%.5f\n",
+			r.time, r.angles[0], r.angles[1], r.angles[2], r.angles[3], r.angles[4], r.position.x, r.position.y, r.position.z,
+			r.normal.x, r.normal.y, r.normal.z, r.light.x, r.light.y, r.light.z);
+		out.write(line, n);
+	}
+
+	//Compiles program files starting in the rest pose; compile errors are printed. Returns false if any.
+	bool CompilePrograms(const vector<string>& files, vector<MotionProgram>& programs)
+	{
+		MotionCompiler compiler;
+		auto compiled = true;
+		for (auto& file : files)
+		{
+			ifstream input(file);
+			if (!input)
+				throw runtime_error("Unable to open " + file);
+			ostringstream source;
+			source << input.rdbuf();
+			MotionProgram program;
+			vector<MotionProgramError> errors;
+			if (!compiler.Compile(source.str(), PumaAngles{}, program, errors))
+			{
+				for (auto& e : errors)
+					cerr << file << ":" << e.Line << ": " << e.Message << "\n";
+				compiled = false;
+			}
+			programs.push_back(move(program));
+		}
+		return compiled;
+	}
+
+	//Plays the program with fixed time steps until its last move ends. dynamics may be null.
+	void Run(const vector<JointTrajectory>& program, const string& name, const Settings& settings,
+		const PumaDynamics* dynamics, Totals& totals)
+	{
+		if (dynamics)
+		{
+			TrajectoryTorques torques;
+			for (auto& move : program)
+			{
+				dynamics->Torques(move, TORQUE_STEP, torques);
+				for (size_t j = 0; j < torques.Peak.size(); ++j)
+					totals.peakTorques[j] = max(totals.peakTorques[j], torques.Peak[j]);
+			}
+		}
+
+		TrajectoryPlayer player;
+		for (auto& move : program)
+			player.Queue(move);
+
+		//programs run on worker threads, where exceptions would terminate the runner, so the stream is checked
+		//after writes instead and a failure only ends this trace
+		ofstream trace;
+		filesystem::path path;
+		auto traceFailed = [&](const char* what)
+		{
+			cerr << what << " " + path.string() + "\n";
+			++totals.failedTraces;
+			trace.close();
+		};
+		if (settings.traceRate > 0.0f)
+		{
+			path = filesystem::path(settings.outDirectory) / (name + (settings.binary ? ".bin" : ".csv"));
+			trace.open(path, settings.binary ? ios::binary : ios::out);
+			if (!trace)
+			{
+				traceFailed("Unable to open");
+				return;
+			}
+			if (settings.binary)
+			{
+				uint32_t floats = sizeof(TraceRecord) / sizeof(float);
+				trace.write(reinterpret_cast<const char*>(&TRACE_TAG), sizeof(TRACE_TAG));
+				trace.write(reinterpret_cast<const char*>(&floats), sizeof(floats));
+			}
+			else
+				trace << TRACE_COLUMNS << "\n";
+			if (!trace)
+				traceFailed("Unable to write");
+		}
+
+		//tool tip and normal are carried by the last link like in PumaKinematics::EndEffector
+		XMFLOAT3 restTip, restNormal;
+		PumaKinematics::EndEffector(PumaAngles{}, restTip, restNormal);
+		auto chain = PumaKinematics::Chain();
+		LampAnimation lamp;
+		auto dt = 1.0f / settings.rate;
+		//steps between traced records; time is step * dt, so long runs don't accumulate rounding
+		auto traceEvery = trace.is_open() ? max<size_t>(1, static_cast<size_t>(settings.rate / settings.traceRate + 0.5f)) : 0;
+		TraceRecord record;
+		size_t step = 0;
+		for (auto playing = true; playing; ++step)
+		{
+			playing = step == 0 ? player.Update(0.0f, record.angles) : player.Update(dt, record.angles);
+			if (!playing)
+				break;
+			if (step)
+				lamp.Update(dt);
+			chain.SetAngles(record.angles.data());
+			chain.Update();
+			if (!traceEvery || step % traceEvery)
+				continue;
+			auto tool = XMLoadFloat4x4(&chain.linkMatrix(PumaKinematics::JOINTS_COUNT - 1));
+			XMStoreFloat3(&record.position, XMVector3TransformCoord(XMLoadFloat3(&restTip), tool));
+			XMStoreFloat3(&record.normal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&restNormal), tool)));
+			record.light = lamp.lightPosition();
+			record.time = step * dt;
+			WriteRecord(trace, record, settings.binary);
+			if (!trace)
+			{
+				//the program still runs to the end, so totals don't depend on the disk
+				traceFailed("Unable to write");
+				traceEvery = 0;
+				continue;
+			}
+			++totals.records;
+		}
+		//the last records are only written out when the file is closed
+		if (trace.is_open())
+		{
+			trace.close();
+			if (!trace)
+				traceFailed("Unable to write");
+		}
+		++totals.programs;
+		totals.steps += step;
+		totals.simulatedSeconds += step * static_cast<double>(dt);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Settings settings;
+	for (auto i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "--programs") && i + 1 < argc)
+			settings.programs = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+		else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+			settings.seed = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+		else if (!strcmp(argv[i], "--rate") && i + 1 < argc)
+			settings.rate = strtof(argv[++i], nullptr);
+		else if (!strcmp(argv[i], "--trace-rate") && i + 1 < argc)
+			settings.traceRate = strtof(argv[++i], nullptr);
+		else if (!strcmp(argv[i], "--format") && i + 1 < argc && (!strcmp(argv[i + 1], "csv") || !strcmp(argv[i + 1], "bin")))
+			settings.binary = !strcmp(argv[++i], "bin");
+		else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+			settings.outDirectory = argv[++i];
+		else if (!strcmp(argv[i], "--meshes") && i + 1 < argc)
+			settings.meshDirectory = argv[++i];
+		else if (argv[i][0] != '-')
+			settings.programFiles.push_back(argv[i]);
+		else
+		{
+			cerr << "Usage: " << argv[0] << " [--programs N] [--seed S] [--rate Hz] [--trace-rate Hz] [--format csv|bin] [--out directory]"
+				" [--meshes directory] [program files...]\n";
+			return EXIT_FAILURE;
+		}
+	}
+	if (settings.rate <= 0.0f || settings.traceRate < 0.0f)
+	{
+		cerr << "Rates must be positive\n";
+		return EXIT_FAILURE;
+	}
+
+	try
+	{
+		if (settings.traceRate > 0.0f)
+			filesystem::create_directories(settings.outDirectory);
+		vector<MotionProgram> compiled;
+		if (!CompilePrograms(settings.programFiles, compiled))
+			return EXIT_FAILURE;
+		if (!compiled.empty())
+			settings.programs = static_cast<unsigned int>(compiled.size());
+		unique_ptr<PumaDynamics> dynamics;
+		if (!settings.meshDirectory.empty())
+		{
+			MeshData meshes[PumaDynamics::LINKS_COUNT];
+			for (auto i = 0U; i < PumaDynamics::LINKS_COUNT; ++i)
+				meshes[i] = MeshData::Load((filesystem::path(settings.meshDirectory) / ("mesh" + to_string(i + 1) + ".mesh")).wstring());
+			dynamics = make_unique<PumaDynamics>(meshes);
+		}
+		PathParameterization timing(JointLimits::Puma());
+		Totals totals;
+		mutex merge;
+		auto start = RunClock::now();
+		ParallelFor(settings.programs, [&](size_t begin, size_t end)
+		{
+			Totals local;
+			for (auto i = begin; i < end; ++i)
+			{
+				if (compiled.empty())
+				{
+					char name[16];
+					snprintf(name, sizeof(name), "program%05u", static_cast<unsigned int>(i));
+					Run(GenerateProgram(settings.seed + static_cast<unsigned int>(i), timing, local), name, settings, dynamics.get(), local);
+				}
+				else
+				{
+					local.moves += compiled[i].segments().size();
+					Run({ compiled[i].trajectory() }, filesystem::path(settings.programFiles[i]).stem().string(), settings, dynamics.get(), local);
+				}
+			}
+			lock_guard<mutex> lock(merge);
+			totals.Add(local);
+		}, 1);
+		auto wallSeconds = chrono::duration<double>(RunClock::now() - start).count();
+
+		cout << "{\n\t\"runner\": \"puma\",\n\t\"seed\": " << settings.seed << ",\n\t\"programs\": " << totals.programs
+			<< ",\n\t\"moves\": " << totals.moves << ",\n\t\"line_moves\": " << totals.lineMoves
+			<< ",\n\t\"failed_lines\": " << totals.failedLines << ",\n\t\"steps\": " << totals.steps
+			<< ",\n\t\"records\": " << totals.records << ",\n\t\"failed_traces\": " << totals.failedTraces << ",\n\t\"simulated_seconds\": " << totals.simulatedSeconds
+			<< ",\n\t\"wall_seconds\": " << wallSeconds;
+		if (dynamics)
+		{
+			cout << ",\n\t\"peak_torques\": [";
+			for (size_t j = 0; j < totals.peakTorques.size(); ++j)
+				cout << (j ? ", " : "") << totals.peakTorques[j];
+			cout << "]";
+		}
+		cout << ",\n\t\"realtime_factor\": " << (wallSeconds > 0.0 ? totals.simulatedSeconds / wallSeconds : 0.0) << "\n}\n";
+		if (totals.failedTraces)
+			return EXIT_FAILURE;
+	}
+	catch (const exception& e)
+	{
+		cerr << e.what() << "\n";
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}